@@ -29,6 +29,12 @@ void oc_on_terminate(void);
 void oc_window_set_title(oc_str8 title);
 void oc_window_set_size(oc_vec2 size);
 
+//----------------------------------------------------------------
+// Frame scheduling
+//----------------------------------------------------------------
+void oc_request_frame(void);
+void oc_request_frame_after(f64 delay);
+
 //----------------------------------------------------------------
 // Quitting
 //----------------------------------------------------------------
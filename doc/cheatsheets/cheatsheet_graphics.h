@@ -33,6 +33,7 @@ oc_canvas oc_canvas_create(void);
 void oc_canvas_destroy(oc_canvas canvas);
 oc_canvas oc_canvas_set_current(oc_canvas canvas);
 void oc_render(oc_canvas canvas);
+oc_canvas_stats oc_canvas_get_stats(oc_canvas canvas);
 
 //------------------------------------------------------------------------------------------
 // transform and clipping
@@ -87,6 +88,7 @@ void oc_close_path(void);
 oc_rect oc_glyph_outlines(oc_str32 glyphIndices);
 void oc_codepoints_outlines(oc_str32 string);
 void oc_text_outlines(oc_str8 string);
+void oc_codepoints_fill(oc_str32 codePoints);
 
 //------------------------------------------------------------------------------------------
 // clear/fill/stroke
@@ -121,6 +123,7 @@ oc_font oc_font_create_from_file(oc_file file, u32 rangeCount, oc_unicode_range*
 oc_font oc_font_create_from_path(oc_str8 path, u32 rangeCount, oc_unicode_range* ranges);
 
 void oc_font_destroy(oc_font font);
+void oc_font_prefetch_glyphs(oc_font font, u32 rangeCount, oc_unicode_range* ranges);
 
 oc_str32 oc_font_get_glyph_indices(oc_font font, oc_str32 codePoints, oc_str32 backing);
 oc_str32 oc_font_push_glyph_indices(oc_arena* arena, oc_font font, oc_str32 codePoints);
@@ -140,10 +143,14 @@ oc_image oc_image_nil(void);
 bool oc_image_is_nil(oc_image a);
 
 oc_image oc_image_create(oc_surface surface, u32 width, u32 height);
+oc_image oc_image_create_mipmapped(oc_surface surface, u32 width, u32 height);
 oc_image oc_image_create_from_rgba8(oc_surface surface, u32 width, u32 height, u8* pixels);
 oc_image oc_image_create_from_memory(oc_surface surface, oc_str8 mem, bool flip);
+oc_image oc_image_create_from_memory_with_options(oc_surface surface, oc_str8 mem, oc_image_options options);
 oc_image oc_image_create_from_file(oc_surface surface, oc_file file, bool flip);
 oc_image oc_image_create_from_path(oc_surface surface, oc_str8 path, bool flip);
+oc_image oc_image_create_from_memory_async(oc_surface surface, oc_str8 mem, bool flip);
+bool oc_image_is_ready(oc_image image);
 
 void oc_image_destroy(oc_image image);
 
@@ -157,6 +164,9 @@ oc_vec2 oc_image_size(oc_image image);
 oc_rect_atlas* oc_rect_atlas_create(oc_arena* arena, i32 width, i32 height);
 oc_rect oc_rect_atlas_alloc(oc_rect_atlas* atlas, i32 width, i32 height);
 void oc_rect_atlas_recycle(oc_rect_atlas* atlas, oc_rect rect);
+void oc_rect_atlas_clear(oc_rect_atlas* atlas);
+oc_rect_atlas_stats oc_rect_atlas_get_stats(oc_rect_atlas* atlas);
+u32 oc_rect_atlas_defragment(oc_rect_atlas* atlas, u32 count, oc_rect* rects);
 
 oc_image_region oc_image_atlas_alloc_from_rgba8(oc_rect_atlas* atlas, oc_image backingImage, u32 width, u32 height, u8* pixels);
 oc_image_region oc_image_atlas_alloc_from_memory(oc_rect_atlas* atlas, oc_image backingImage, oc_str8 mem, bool flip);
@@ -164,3 +174,7 @@ oc_image_region oc_image_atlas_alloc_from_file(oc_rect_atlas* atlas, oc_image ba
 oc_image_region oc_image_atlas_alloc_from_path(oc_rect_atlas* atlas, oc_image backingImage, oc_str8 path, bool flip);
 
 void oc_image_atlas_recycle(oc_rect_atlas* atlas, oc_image_region imageRgn);
+u32 oc_image_atlas_defragment(oc_rect_atlas* atlas, u32 count, oc_image_region* regions, u8** pixels);
+
+void oc_glyph_atlas_enable(oc_surface surface, f32 maxFontSize);
+void oc_glyph_atlas_disable(void);
@@ -18,6 +18,8 @@ void oc_ui_process_event(oc_event* event);
 void oc_ui_begin_frame(oc_vec2 size, oc_ui_style* defaultStyle, oc_ui_style_mask mask);
 void oc_ui_end_frame(void);
 void oc_ui_draw(void);
+oc_ui_stats oc_ui_get_stats(void);
+oc_ui_box* oc_ui_hit_test(oc_vec2 p);
 
 #define oc_ui_frame(size, style, mask)
 
@@ -37,6 +39,8 @@ void oc_ui_panel_begin(const char* name, oc_ui_flags flags);
 void oc_ui_panel_end(void);
 #define oc_ui_panel(s, f)
 
+void oc_ui_list(const char* name, oc_ui_list_info* info);
+
 void oc_ui_menu_bar_begin(const char* label);
 void oc_ui_menu_bar_end(void);
 #define oc_ui_menu_bar(name)
@@ -287,6 +287,9 @@ int check_collision(oc_rect block)
 
 ORCA_EXPORT void oc_on_frame_refresh(void)
 {
+    //NOTE: this sample animates continuously, so we ask for the next frame right away
+    oc_request_frame();
+
     oc_arena_scope scratch = oc_scratch_begin();
     f32 aspect = frameSize.x / frameSize.y;
 
@@ -63,6 +63,9 @@ ORCA_EXPORT void oc_on_resize(u32 width, u32 height)
 
 ORCA_EXPORT void oc_on_frame_refresh(void)
 {
+    //NOTE: this sample animates continuously, so we ask for the next frame right away
+    oc_request_frame();
+
     oc_canvas_select(canvas);
     oc_set_color_rgba(.05, .05, .05, 1);
     oc_clear();
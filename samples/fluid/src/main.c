@@ -723,6 +723,9 @@ ORCA_EXPORT void oc_on_resize(u32 width, u32 height)
 
 ORCA_EXPORT void oc_on_frame_refresh()
 {
+    //NOTE: this sample animates continuously, so we ask for the next frame right away
+    oc_request_frame();
+
     float aspectRatio = texWidth / texHeight;
 
     static float t = 0;
@@ -94,6 +94,9 @@ ORCA_EXPORT void oc_on_resize(u32 width, u32 height)
 
 ORCA_EXPORT void oc_on_frame_refresh(void)
 {
+    //NOTE: this sample animates continuously, so we ask for the next frame right away
+    oc_request_frame();
+
     f32 aspect = frameSize.x / frameSize.y;
 
     oc_surface_select(surface);
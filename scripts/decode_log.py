@@ -0,0 +1,89 @@
+import struct
+import sys
+from argparse import ArgumentParser
+
+# Decodes binary log files written by oc_log_set_binary_file(). See the format description in
+# src/platform/native_debug.c.
+
+LOG_MAGIC = b"OCLG"
+LOG_VERSION = 1
+
+RECORD_STRING = 1
+RECORD_ENTRY = 2
+
+LOG_HEADINGS = ["Error", "Warning", "Info"]
+
+
+class LogFormatError(Exception):
+    pass
+
+
+def read_exact(f, size):
+    data = f.read(size)
+    if len(data) != size:
+        raise LogFormatError("unexpected end of file")
+    return data
+
+
+def decode_log(f):
+    magic, version = struct.unpack("<4sI", read_exact(f, 8))
+    if magic != LOG_MAGIC:
+        raise LogFormatError("not an orca binary log file")
+    if version != LOG_VERSION:
+        raise LogFormatError(f"unsupported log version {version}")
+
+    strings = {}
+    while True:
+        tag = f.read(1)
+        if len(tag) == 0:
+            break
+
+        if tag[0] == RECORD_STRING:
+            id, length = struct.unpack("<II", read_exact(f, 8))
+            strings[id] = read_exact(f, length).decode("utf-8", errors="replace")
+
+        elif tag[0] == RECORD_ENTRY:
+            level, functionId, fileId, line, timestamp, msgLen = struct.unpack("<BIIidI", read_exact(f, 25))
+            msg = read_exact(f, msgLen).decode("utf-8", errors="replace")
+            yield {
+                "level": level,
+                "function": strings.get(functionId, "?"),
+                "file": strings.get(fileId, "?"),
+                "line": line,
+                "timestamp": timestamp,
+                "msg": msg,
+            }
+
+        else:
+            raise LogFormatError(f"unknown record tag {tag[0]}")
+
+
+def format_entry(entry, timestamps):
+    heading = LOG_HEADINGS[entry["level"]] if entry["level"] < len(LOG_HEADINGS) else "Level %i" % entry["level"]
+    prefix = "[%.6f] " % entry["timestamp"] if timestamps else ""
+    return f"{prefix}{heading}: {entry['function']}() in {entry['file']}:{entry['line']}: {entry['msg']}"
+
+
+if __name__ == "__main__":
+    parser = ArgumentParser(description="Decode an orca binary log file.")
+    parser.add_argument("input")
+    parser.add_argument("-o", "--output", help="output file, defaults to stdout")
+    parser.add_argument("-l", "--level", choices=["error", "warning", "info"], default="info", help="maximum level to print")
+    parser.add_argument("--no-timestamps", action="store_true", help="don't prefix entries with their timestamp")
+
+    args = parser.parse_args()
+
+    maxLevel = ["error", "warning", "info"].index(args.level)
+    output = open(args.output, "w", encoding="utf-8") if args.output else sys.stdout
+
+    try:
+        with open(args.input, "rb") as f:
+            for entry in decode_log(f):
+                if entry["level"] <= maxLevel:
+                    output.write(format_entry(entry, not args.no_timestamps))
+    except LogFormatError as e:
+        print(f"error: {args.input}: {e}", file=sys.stderr)
+        sys.exit(1)
+    finally:
+        if args.output:
+            output.close()
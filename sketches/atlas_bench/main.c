@@ -0,0 +1,135 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "orca.h"
+
+//NOTE: benchmark of the rect atlas on glyph-like and sprite-like size distributions.
+//      The atlas is filled until the first allocation failure, then goes through rounds
+//      where half of the live rectangles are recycled and the atlas is refilled.
+
+enum
+{
+    ATLAS_SIZE = 2048,
+    MAX_RECTS = 1 << 16,
+    CHURN_ROUNDS = 32,
+};
+
+typedef struct size_distribution
+{
+    const char* name;
+    i32 minWidth;
+    i32 maxWidth;
+    i32 minHeight;
+    i32 maxHeight;
+} size_distribution;
+
+static u64 rngState = 0x2545f4914f6cdd1dULL;
+
+static u32 rng_next(void)
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return ((u32)(rngState >> 32));
+}
+
+static i32 rng_range(i32 min, i32 max)
+{
+    return (min + (i32)(rng_next() % (u32)(max - min + 1)));
+}
+
+static u32 fill_atlas(oc_rect_atlas* atlas, size_distribution* dist, oc_rect* rects, u32 count, u32* failCount)
+{
+    while(count < MAX_RECTS)
+    {
+        i32 w = rng_range(dist->minWidth, dist->maxWidth);
+        i32 h = rng_range(dist->minHeight, dist->maxHeight);
+        oc_rect rect = oc_rect_atlas_alloc(atlas, w, h);
+        if(rect.w == 0)
+        {
+            (*failCount)++;
+            break;
+        }
+        rects[count] = rect;
+        count++;
+    }
+    return (count);
+}
+
+static void run_benchmark(size_distribution* dist)
+{
+    oc_arena arena = { 0 };
+    oc_arena_init(&arena);
+
+    oc_rect_atlas* atlas = oc_rect_atlas_create(&arena, ATLAS_SIZE, ATLAS_SIZE);
+    oc_rect* rects = oc_arena_push_array(&arena, oc_rect, MAX_RECTS);
+
+    u32 failCount = 0;
+    f64 start = oc_clock_time(OC_CLOCK_MONOTONIC);
+    u32 count = fill_atlas(atlas, dist, rects, 0, &failCount);
+    f64 fillTime = oc_clock_time(OC_CLOCK_MONOTONIC) - start;
+
+    oc_rect_atlas_stats stats = oc_rect_atlas_get_stats(atlas);
+    printf("%s: initial fill, %u rects in %.3f ms, occupancy %.3f, fragmentation %.3f\n",
+           dist->name, count, fillTime * 1000, stats.occupancy, stats.fragmentation);
+
+    start = oc_clock_time(OC_CLOCK_MONOTONIC);
+    for(int round = 0; round < CHURN_ROUNDS; round++)
+    {
+        //NOTE: recycle a random half of the live rectangles
+        u32 kept = 0;
+        for(u32 i = 0; i < count; i++)
+        {
+            if(rng_next() & 1)
+            {
+                oc_rect_atlas_recycle(atlas, rects[i]);
+            }
+            else
+            {
+                rects[kept] = rects[i];
+                kept++;
+            }
+        }
+        count = fill_atlas(atlas, dist, rects, kept, &failCount);
+    }
+    f64 churnTime = oc_clock_time(OC_CLOCK_MONOTONIC) - start;
+
+    stats = oc_rect_atlas_get_stats(atlas);
+    printf("%s: after %i churn rounds in %.3f ms, %u rects, occupancy %.3f, fragmentation %.3f, %u free rects\n",
+           dist->name, CHURN_ROUNDS, churnTime * 1000, count, stats.occupancy, stats.fragmentation, stats.freeRectCount);
+
+    start = oc_clock_time(OC_CLOCK_MONOTONIC);
+    u32 placed = oc_rect_atlas_defragment(atlas, count, rects);
+    f64 defragTime = oc_clock_time(OC_CLOCK_MONOTONIC) - start;
+
+    stats = oc_rect_atlas_get_stats(atlas);
+    printf("%s: defragment placed %u/%u rects in %.3f ms, occupancy %.3f, fragmentation %.3f\n\n",
+           dist->name, placed, count, defragTime * 1000, stats.occupancy, stats.fragmentation);
+
+    oc_arena_cleanup(&arena);
+}
+
+int main()
+{
+    oc_init();
+
+    size_distribution distributions[] = {
+        { "glyphs", 4, 20, 8, 24 },
+        { "sprites", 16, 256, 16, 256 },
+    };
+
+    for(int i = 0; i < oc_array_size(distributions); i++)
+    {
+        run_benchmark(&distributions[i]);
+    }
+
+    oc_terminate();
+    return (0);
+}
@@ -0,0 +1,512 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include <math.h>
+#include <stdio.h>
+
+#include "orca.h"
+#include "graphics/graphics_common.h"
+
+//NOTE: validation of the stroke flattening tolerance computed by oc_primitive_stroke_tolerance() against a reference
+//      rasterization. Strokes are offset in user space, so we compare the previous policy, which used the tolerance
+//      attribute directly as a user space distance, with the current one, which divides it by the scale of the
+//      transform.
+//
+//      Quadratics are offset the same way as oc_gl_encode_stroke_quadratic() and its Metal counterpart, which emit
+//      their pieces straight into the backends' buffers: the curve's hull is offset on each side, checked against the
+//      tolerance at a few parameters, and the curve is split until the check passes or OC_STROKE_MAX_SPLIT_DEPTH is
+//      reached. We then sample the coverage of the emitted pieces at each pixel center of the scaled curve,
+//      and compare it with the coverage of the exact butt-capped stroke. Caps and joints are exact in both policies and
+//      are left out.
+//
+//      Each case prints one line, where diff_px is the number of pixels whose coverage differs from the reference, and
+//      band_px is the average thickness of that difference along the edges of the stroke:
+//
+//          stroke_tolerance format=1 curve=<name> width=<f> scale=<f> old_pieces=<n> old_diff_px=<n> old_band_px=<f>
+//                           new_pieces=<n> new_diff_px=<n> new_band_px=<f>
+//
+//      followed by a summary line per policy with the largest band, the total pixel difference and number of pieces.
+
+enum
+{
+    HULL_CHECK_SAMPLE_COUNT = 5,
+    MAX_PIECES = 1 << 12,
+    MAX_OUTLINE_SEGMENTS = 512,
+    ROOT_SAMPLE_COUNT = 32,
+};
+
+static const f32 TOLERANCE = 1; // default tolerance attribute of a canvas, in surface points
+
+typedef struct stroke_piece
+{
+    oc_vec2 curve[3];
+    oc_vec2 leftHull[3];
+    oc_vec2 rightHull[3];
+} stroke_piece;
+
+typedef struct stroke_result
+{
+    u32 pieceCount;
+    stroke_piece pieces[MAX_PIECES];
+} stroke_result;
+
+static oc_vec2 quadratic_get_point(oc_vec2 p[3], f32 t)
+{
+    f32 oneMt = 1 - t;
+    oc_vec2 r = {
+        oneMt * oneMt * p[0].x + 2 * oneMt * t * p[1].x + t * t * p[2].x,
+        oneMt * oneMt * p[0].y + 2 * oneMt * t * p[1].y + t * t * p[2].y,
+    };
+    return (r);
+}
+
+static void quadratic_split(oc_vec2 p[3], f32 t, oc_vec2 outLeft[3], oc_vec2 outRight[3])
+{
+    oc_vec2 q0 = { p[0].x + t * (p[1].x - p[0].x), p[0].y + t * (p[1].y - p[0].y) };
+    oc_vec2 q1 = { p[1].x + t * (p[2].x - p[1].x), p[1].y + t * (p[2].y - p[1].y) };
+    oc_vec2 r = { q0.x + t * (q1.x - q0.x), q0.y + t * (q1.y - q0.y) };
+
+    outLeft[0] = p[0];
+    outLeft[1] = q0;
+    outLeft[2] = r;
+
+    outRight[0] = r;
+    outRight[1] = q1;
+    outRight[2] = p[2];
+}
+
+static bool offset_hull(oc_vec2 p[3], oc_vec2 result[3], f32 offset)
+{
+    //NOTE: same as oc_offset_hull() for quadratics: offset both legs of the hull, and intersect them
+    oc_vec2 legs[2][2];
+    for(int i = 0; i < 2; i++)
+    {
+        oc_vec2 n = { p[i].y - p[i + 1].y, p[i + 1].x - p[i].x };
+        f32 norm = sqrtf(n.x * n.x + n.y * n.y);
+        if(norm < 1e-6)
+        {
+            return (false);
+        }
+        n.x *= offset / norm;
+        n.y *= offset / norm;
+        legs[i][0] = (oc_vec2){ p[i].x + n.x, p[i].y + n.y };
+        legs[i][1] = (oc_vec2){ p[i + 1].x + n.x, p[i + 1].y + n.y };
+    }
+
+    oc_vec2 p0 = legs[0][0], p1 = legs[0][1], p2 = legs[1][0], p3 = legs[1][1];
+    f32 den = (p0.x - p1.x) * (p2.y - p3.y) - (p0.y - p1.y) * (p2.x - p3.x);
+    if(fabsf(den) <= 0.0001)
+    {
+        return (false);
+    }
+    f32 u = ((p0.x - p2.x) * (p2.y - p3.y) - (p0.y - p2.y) * (p2.x - p3.x)) / den;
+
+    result[0] = p0;
+    result[1] = (oc_vec2){ p0.x + u * (p1.x - p0.x), p0.y + u * (p1.y - p0.y) };
+    result[2] = p3;
+    return (true);
+}
+
+static void push_piece(stroke_result* result, oc_vec2 curve[3], oc_vec2 leftHull[3], oc_vec2 rightHull[3])
+{
+    if(result->pieceCount < MAX_PIECES)
+    {
+        stroke_piece* piece = &result->pieces[result->pieceCount];
+        result->pieceCount++;
+
+        memcpy(piece->curve, curve, 3 * sizeof(oc_vec2));
+        memcpy(piece->leftHull, leftHull, 3 * sizeof(oc_vec2));
+        memcpy(piece->rightHull, rightHull, 3 * sizeof(oc_vec2));
+    }
+}
+
+static void stroke_quadratic(stroke_result* result, oc_vec2 p[3], f32 width, f32 tolerance, int depth)
+{
+    oc_vec2 leftHull[3];
+    oc_vec2 rightHull[3];
+    oc_vec2 splitLeft[3];
+    oc_vec2 splitRight[3];
+
+    if(!offset_hull(p, leftHull, width / 2) || !offset_hull(p, rightHull, -width / 2))
+    {
+        if(depth >= OC_STROKE_MAX_SPLIT_DEPTH)
+        {
+            //NOTE: the backends stroke the chord, which we store as a straight quadratic
+            oc_vec2 n = { p[0].y - p[2].y, p[2].x - p[0].x };
+            f32 norm = sqrtf(n.x * n.x + n.y * n.y);
+            if(norm > 0)
+            {
+                n.x *= 0.5 * width / norm;
+                n.y *= 0.5 * width / norm;
+
+                oc_vec2 mid = { 0.5 * (p[0].x + p[2].x), 0.5 * (p[0].y + p[2].y) };
+                oc_vec2 chord[3] = { p[0], mid, p[2] };
+                for(int i = 0; i < 3; i++)
+                {
+                    leftHull[i] = (oc_vec2){ chord[i].x + n.x, chord[i].y + n.y };
+                    rightHull[i] = (oc_vec2){ chord[i].x - n.x, chord[i].y - n.y };
+                }
+                push_piece(result, chord, leftHull, rightHull);
+            }
+        }
+        else
+        {
+            quadratic_split(p, 0.5, splitLeft, splitRight);
+            stroke_quadratic(result, splitLeft, width, tolerance, depth + 1);
+            stroke_quadratic(result, splitRight, width, tolerance, depth + 1);
+        }
+        return;
+    }
+
+    f32 checkSamples[HULL_CHECK_SAMPLE_COUNT] = { 1. / 6, 2. / 6, 3. / 6, 4. / 6, 5. / 6 };
+
+    f32 d2LowBound = (0.5 * width - tolerance) * (0.5 * width - tolerance);
+    f32 d2HighBound = (0.5 * width + tolerance) * (0.5 * width + tolerance);
+
+    f32 maxOvershoot = 0;
+    f32 maxOvershootParameter = 0;
+
+    for(int i = 0; i < HULL_CHECK_SAMPLE_COUNT; i++)
+    {
+        f32 t = checkSamples[i];
+
+        oc_vec2 c = quadratic_get_point(p, t);
+        oc_vec2 cp = quadratic_get_point(leftHull, t);
+        oc_vec2 cn = quadratic_get_point(rightHull, t);
+
+        f32 positiveDistSquare = (c.x - cp.x) * (c.x - cp.x) + (c.y - cp.y) * (c.y - cp.y);
+        f32 negativeDistSquare = (c.x - cn.x) * (c.x - cn.x) + (c.y - cn.y) * (c.y - cn.y);
+
+        f32 positiveOvershoot = oc_max(positiveDistSquare - d2HighBound, d2LowBound - positiveDistSquare);
+        f32 negativeOvershoot = oc_max(negativeDistSquare - d2HighBound, d2LowBound - negativeDistSquare);
+
+        f32 overshoot = oc_max(positiveOvershoot, negativeOvershoot);
+        if(overshoot > maxOvershoot)
+        {
+            maxOvershoot = overshoot;
+            maxOvershootParameter = t;
+        }
+    }
+
+    if(maxOvershoot > 0 && depth < OC_STROKE_MAX_SPLIT_DEPTH)
+    {
+        quadratic_split(p, maxOvershootParameter, splitLeft, splitRight);
+        stroke_quadratic(result, splitLeft, width, tolerance, depth + 1);
+        stroke_quadratic(result, splitRight, width, tolerance, depth + 1);
+    }
+    else
+    {
+        push_piece(result, p, leftHull, rightHull);
+    }
+}
+
+static bool sweep_covers(oc_vec2 p[3], f32 halfWidth, oc_vec2 q)
+{
+    //NOTE: q is covered by the butt-capped stroke if it lies on the normal of the curve at some t in [0, 1], at a
+    //      distance of at most halfWidth. The normal passes through q where f(t) = (q - c(t)).c'(t) vanishes. f is a
+    //      cubic, so we bracket its roots by sampling it and refine them by bisection.
+    oc_vec2 a = { p[0].x - 2 * p[1].x + p[2].x, p[0].y - 2 * p[1].y + p[2].y };
+    oc_vec2 b = { p[1].x - p[0].x, p[1].y - p[0].y };
+
+    f32 prevT = 0;
+    f32 prevF = 0;
+    for(int i = 0; i <= ROOT_SAMPLE_COUNT; i++)
+    {
+        f32 t = (f32)i / ROOT_SAMPLE_COUNT;
+        oc_vec2 c = quadratic_get_point(p, t);
+        oc_vec2 d = { a.x * t + b.x, a.y * t + b.y };
+        f32 f = (q.x - c.x) * d.x + (q.y - c.y) * d.y;
+
+        f32 rootT = -1;
+        if(f == 0)
+        {
+            rootT = t;
+        }
+        else if(i > 0 && (f < 0) != (prevF < 0))
+        {
+            f32 lo = prevT;
+            f32 hi = t;
+            f32 fLo = prevF;
+            for(int j = 0; j < 24; j++)
+            {
+                f32 mid = 0.5 * (lo + hi);
+                oc_vec2 cm = quadratic_get_point(p, mid);
+                oc_vec2 dm = { a.x * mid + b.x, a.y * mid + b.y };
+                f32 fm = (q.x - cm.x) * dm.x + (q.y - cm.y) * dm.y;
+                if((fm < 0) == (fLo < 0))
+                {
+                    lo = mid;
+                    fLo = fm;
+                }
+                else
+                {
+                    hi = mid;
+                }
+            }
+            rootT = 0.5 * (lo + hi);
+        }
+
+        if(rootT >= 0)
+        {
+            oc_vec2 cr = quadratic_get_point(p, rootT);
+            f32 d2 = (q.x - cr.x) * (q.x - cr.x) + (q.y - cr.y) * (q.y - cr.y);
+            if(d2 <= halfWidth * halfWidth)
+            {
+                return (true);
+            }
+        }
+        prevT = t;
+        prevF = f;
+    }
+    return (false);
+}
+
+typedef struct piece_outline
+{
+    u32 pointCount;
+    oc_vec2 points[2 * (MAX_OUTLINE_SEGMENTS + 1)];
+    f32 minX, minY, maxX, maxY;
+} piece_outline;
+
+static piece_outline outlines[MAX_PIECES];
+
+static void build_outlines(stroke_result* result, f32 scale)
+{
+    //NOTE: flatten each piece into a closed polygon, following the right hull then the left hull backwards, like the
+    //      elements emitted by oc_gl_encode_stroke_quadratic(). Segments are a few pixels long, so the flattening
+    //      error is well below the tolerance we measure.
+    for(u32 pieceIndex = 0; pieceIndex < result->pieceCount; pieceIndex++)
+    {
+        stroke_piece* piece = &result->pieces[pieceIndex];
+        piece_outline* outline = &outlines[pieceIndex];
+
+        f32 length = 0;
+        for(int i = 0; i < 2; i++)
+        {
+            oc_vec2* h = (i == 0) ? piece->leftHull : piece->rightHull;
+            length = oc_max(length, (sqrtf((h[1].x - h[0].x) * (h[1].x - h[0].x) + (h[1].y - h[0].y) * (h[1].y - h[0].y)) + sqrtf((h[2].x - h[1].x) * (h[2].x - h[1].x) + (h[2].y - h[1].y) * (h[2].y - h[1].y))) * scale);
+        }
+        int segmentCount = oc_clamp((int)ceilf(length / 2), 8, MAX_OUTLINE_SEGMENTS);
+
+        outline->pointCount = 0;
+        for(int i = 0; i <= segmentCount; i++)
+        {
+            outline->points[outline->pointCount++] = quadratic_get_point(piece->rightHull, (f32)i / segmentCount);
+        }
+        for(int i = segmentCount; i >= 0; i--)
+        {
+            outline->points[outline->pointCount++] = quadratic_get_point(piece->leftHull, (f32)i / segmentCount);
+        }
+
+        outline->minX = outline->maxX = outline->points[0].x;
+        outline->minY = outline->maxY = outline->points[0].y;
+        for(u32 i = 1; i < outline->pointCount; i++)
+        {
+            outline->minX = oc_min(outline->minX, outline->points[i].x);
+            outline->maxX = oc_max(outline->maxX, outline->points[i].x);
+            outline->minY = oc_min(outline->minY, outline->points[i].y);
+            outline->maxY = oc_max(outline->maxY, outline->points[i].y);
+        }
+    }
+}
+
+static bool outlines_cover(u32 pieceCount, oc_vec2 q)
+{
+    //NOTE: pieces are emitted in the same path, so q is covered if its winding number is non-zero
+    int winding = 0;
+    for(u32 pieceIndex = 0; pieceIndex < pieceCount; pieceIndex++)
+    {
+        piece_outline* outline = &outlines[pieceIndex];
+        if(q.x < outline->minX || q.x > outline->maxX || q.y < outline->minY || q.y > outline->maxY)
+        {
+            continue;
+        }
+        for(u32 i = 0; i < outline->pointCount; i++)
+        {
+            oc_vec2 p0 = outline->points[i];
+            oc_vec2 p1 = outline->points[(i + 1) % outline->pointCount];
+            f32 side = (p1.x - p0.x) * (q.y - p0.y) - (q.x - p0.x) * (p1.y - p0.y);
+            if(p0.y <= q.y && p1.y > q.y && side > 0)
+            {
+                winding++;
+            }
+            else if(p0.y > q.y && p1.y <= q.y && side < 0)
+            {
+                winding--;
+            }
+        }
+    }
+    return (winding != 0);
+}
+
+typedef struct coverage_diff
+{
+    u32 diffPixels;
+    f32 bandPixels;
+} coverage_diff;
+
+static coverage_diff compare_coverage(oc_vec2 p[3], f32 width, f32 scale, stroke_result* result)
+{
+    //NOTE: rasterize the exact stroke and the emitted pieces at pixel centers, in screen space, and count the pixels
+    //      where they disagree. Dividing that count by the length of both edges of the stroke gives the average
+    //      thickness of the disagreement band, in pixels, which is what the tolerance is meant to bound.
+    build_outlines(result, scale);
+
+    f32 minX = oc_min(p[0].x, oc_min(p[1].x, p[2].x)) - width;
+    f32 maxX = oc_max(p[0].x, oc_max(p[1].x, p[2].x)) + width;
+    f32 minY = oc_min(p[0].y, oc_min(p[1].y, p[2].y)) - width;
+    f32 maxY = oc_max(p[0].y, oc_max(p[1].y, p[2].y)) + width;
+
+    int x0 = (int)floorf(minX * scale);
+    int x1 = (int)ceilf(maxX * scale);
+    int y0 = (int)floorf(minY * scale);
+    int y1 = (int)ceilf(maxY * scale);
+
+    coverage_diff diff = { 0 };
+    for(int y = y0; y < y1; y++)
+    {
+        for(int x = x0; x < x1; x++)
+        {
+            oc_vec2 q = { (x + 0.5) / scale, (y + 0.5) / scale };
+            if(sweep_covers(p, 0.5 * width, q) != outlines_cover(result->pieceCount, q))
+            {
+                diff.diffPixels++;
+            }
+        }
+    }
+
+    f32 length = 0;
+    oc_vec2 prev = p[0];
+    for(int i = 1; i <= 256; i++)
+    {
+        oc_vec2 c = quadratic_get_point(p, i / 256.);
+        length += sqrtf((c.x - prev.x) * (c.x - prev.x) + (c.y - prev.y) * (c.y - prev.y));
+        prev = c;
+    }
+    diff.bandPixels = diff.diffPixels / (2 * length * scale);
+
+    return (diff);
+}
+
+static f32 old_tolerance(f32 width)
+{
+    //NOTE: tolerance used before it depended on the transform
+    return (oc_min(TOLERANCE, 0.5 * width));
+}
+
+static f32 new_tolerance(oc_vec2 p[3], f32 width, f32 scale)
+{
+    //NOTE: build the primitive the canvas would record for this stroke, and ask the backends' tolerance for it
+    oc_path_elt element = {
+        .type = OC_PATH_QUADRATIC,
+        .p = { p[1], p[2] },
+    };
+
+    oc_primitive primitive = {
+        .cmd = OC_CMD_STROKE,
+        .attributes = {
+            .width = width,
+            .tolerance = TOLERANCE,
+            .joint = OC_JOINT_NONE,
+            .cap = OC_CAP_NONE,
+            .transform = { scale, 0, 0, 0, scale, 0 },
+            .clip = { -1e6, -1e6, 2e6, 2e6 },
+        },
+        .path = {
+            .startIndex = 0,
+            .count = 1,
+            .startPoint = p[0],
+        },
+    };
+
+    oc_vec4 screenBounds = oc_primitive_screen_bounds(&primitive, &element);
+    return (oc_primitive_stroke_tolerance(&primitive, screenBounds));
+}
+
+typedef struct test_curve
+{
+    const char* name;
+    oc_vec2 p[3];
+} test_curve;
+
+typedef struct policy_summary
+{
+    f32 maxBand;
+    u64 diffPixels;
+    u64 pieceCount;
+} policy_summary;
+
+static stroke_result oldResult;
+static stroke_result newResult;
+
+int main()
+{
+    test_curve curves[] = {
+        { "shallow", { { 0, 0 }, { 50, 20 }, { 100, 0 } } },
+        { "arc", { { 0, 0 }, { 50, 100 }, { 100, 0 } } },
+        { "hairpin", { { 0, 0 }, { 100, 10 }, { 0, 20 } } },
+        { "small", { { 0, 0 }, { 4, 6 }, { 8, 0 } } },
+    };
+    f32 widths[] = { 1, 4, 16 };
+    f32 scales[] = { 0.1, 0.25, 0.5, 1, 2, 4, 8 };
+
+    policy_summary oldSummary = { 0 };
+    policy_summary newSummary = { 0 };
+
+    for(int curveIndex = 0; curveIndex < oc_array_size(curves); curveIndex++)
+    {
+        test_curve* curve = &curves[curveIndex];
+        for(int widthIndex = 0; widthIndex < oc_array_size(widths); widthIndex++)
+        {
+            f32 width = widths[widthIndex];
+            for(int scaleIndex = 0; scaleIndex < oc_array_size(scales); scaleIndex++)
+            {
+                f32 scale = scales[scaleIndex];
+
+                oldResult.pieceCount = 0;
+                stroke_quadratic(&oldResult, curve->p, width, old_tolerance(width), 0);
+                coverage_diff oldDiff = compare_coverage(curve->p, width, scale, &oldResult);
+
+                newResult.pieceCount = 0;
+                stroke_quadratic(&newResult, curve->p, width, new_tolerance(curve->p, width, scale), 0);
+                coverage_diff newDiff = compare_coverage(curve->p, width, scale, &newResult);
+
+                printf("stroke_tolerance format=1 curve=%s width=%.2f scale=%.2f old_pieces=%u old_diff_px=%u old_band_px=%.3f new_pieces=%u new_diff_px=%u new_band_px=%.3f\n",
+                       curve->name,
+                       width,
+                       scale,
+                       oldResult.pieceCount,
+                       oldDiff.diffPixels,
+                       oldDiff.bandPixels,
+                       newResult.pieceCount,
+                       newDiff.diffPixels,
+                       newDiff.bandPixels);
+
+                oldSummary.maxBand = oc_max(oldSummary.maxBand, oldDiff.bandPixels);
+                oldSummary.diffPixels += oldDiff.diffPixels;
+                oldSummary.pieceCount += oldResult.pieceCount;
+
+                newSummary.maxBand = oc_max(newSummary.maxBand, newDiff.bandPixels);
+                newSummary.diffPixels += newDiff.diffPixels;
+                newSummary.pieceCount += newResult.pieceCount;
+            }
+        }
+    }
+
+    printf("stroke_tolerance format=1 summary policy=old tolerance_px=%.2f max_band_px=%.3f diff_px=%llu pieces=%llu\n",
+           TOLERANCE,
+           oldSummary.maxBand,
+           (unsigned long long)oldSummary.diffPixels,
+           (unsigned long long)oldSummary.pieceCount);
+    printf("stroke_tolerance format=1 summary policy=new tolerance_px=%.2f max_band_px=%.3f diff_px=%llu pieces=%llu\n",
+           TOLERANCE,
+           newSummary.maxBand,
+           (unsigned long long)newSummary.diffPixels,
+           (unsigned long long)newSummary.pieceCount);
+
+    return (0);
+}
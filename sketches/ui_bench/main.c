@@ -0,0 +1,516 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "orca.h"
+
+//NOTE: headless benchmark of the UI on synthetic widget trees. No window or surface is created, the UI
+//      is drawn into a canvas that is "rendered" without a selected surface, which only records its stats.
+//
+//      Each scene prints a single line of space separated key=value pairs, in a fixed order:
+//
+//          ui_bench format=1 scene=<name> frames=<n> boxes=<n> build_us=<f> styling_us=<f> layout_us=<f>
+//                   hover_us=<f> draw_us=<f> arena_bytes=<n> primitives=<n> path_elements=<n> styles=<n>
+//                   reused_subtrees=<n>
+//
+//      Times are averaged over the measured frames, in microseconds. Counts are taken from the last frame.
+//      The mouse follows the same deterministic path in every run, so counts are stable across runs.
+//
+//      The benchmark also checks that reusing the layout of unchanged subtrees gives the same result as a full
+//      layout, when the frame shrinks and then grows back. It prints one line, and exits with an error on failure:
+//
+//          ui_bench format=1 check=shrink_grow result=<pass|fail> reused_subtrees=<n> max_diff=<f>
+
+enum
+{
+    WARMUP_FRAMES = 10,
+    MEASURED_FRAMES = 200,
+};
+
+static const oc_vec2 frameSize = { 1280, 800 };
+
+typedef struct bench_scene
+{
+    const char* name;
+    void (*build)(oc_arena* arena, u32 frame);
+} bench_scene;
+
+//------------------------------------------------------------------------------------------
+// scenes
+//------------------------------------------------------------------------------------------
+
+static void nest(oc_arena* arena, u32 depth)
+{
+    if(depth == 0)
+    {
+        oc_ui_label("leaf");
+        return;
+    }
+
+    oc_ui_style_next(&(oc_ui_style){ .layout.margin.x = 1,
+                                     .layout.margin.y = 1,
+                                     .borderSize = 1,
+                                     .borderColor = { 0.5, 0.5, 0.5, 1 } },
+                     OC_UI_STYLE_LAYOUT_MARGINS
+                         | OC_UI_STYLE_BORDER_SIZE
+                         | OC_UI_STYLE_BORDER_COLOR);
+
+    oc_ui_container("level", OC_UI_FLAG_DRAW_BORDER)
+    {
+        nest(arena, depth - 1);
+    }
+}
+
+static void scene_deep_nesting(oc_arena* arena, u32 frame)
+{
+    oc_ui_style_next(&(oc_ui_style){ .layout.axis = OC_UI_AXIS_X }, OC_UI_STYLE_LAYOUT_AXIS);
+    oc_ui_container("columns", 0)
+    {
+        for(int i = 0; i < 16; i++)
+        {
+            oc_ui_container_str8(oc_str8_pushf(arena, "column %i", i), 0)
+            {
+                nest(arena, 48);
+            }
+        }
+    }
+}
+
+static void scene_wide_list(oc_arena* arena, u32 frame)
+{
+    oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
+                                     .size.height = { OC_UI_SIZE_PARENT, 1 } },
+                     OC_UI_STYLE_SIZE);
+    oc_ui_panel("list", OC_UI_FLAG_DRAW_BACKGROUND)
+    {
+        for(int i = 0; i < 2000; i++)
+        {
+            oc_ui_style_next(&(oc_ui_style){ .layout.axis = OC_UI_AXIS_X,
+                                             .layout.spacing = 10 },
+                             OC_UI_STYLE_LAYOUT_AXIS | OC_UI_STYLE_LAYOUT_SPACING);
+
+            oc_ui_container_str8(oc_str8_pushf(arena, "row %i", i), 0)
+            {
+                oc_ui_label_str8(oc_str8_pushf(arena, "item %i", i));
+                oc_ui_button("edit");
+                oc_ui_button("delete");
+            }
+        }
+    }
+}
+
+static void virtual_list_row(u32 index, void* user)
+{
+    oc_arena* arena = (oc_arena*)user;
+    oc_ui_label_str8(oc_str8_pushf(arena, "virtual item %u", index));
+}
+
+static void scene_virtual_list(oc_arena* arena, u32 frame)
+{
+    oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
+                                     .size.height = { OC_UI_SIZE_PARENT, 1 } },
+                     OC_UI_STYLE_SIZE);
+
+    oc_ui_list_info info = {
+        .rowCount = 100000,
+        .rowHeight = 20,
+        .overscan = 2,
+        .proc = virtual_list_row,
+        .user = arena,
+    };
+    oc_ui_list("list", &info);
+
+    //NOTE: scroll through the list
+    oc_ui_box* panel = oc_ui_box_lookup("list");
+    if(panel)
+    {
+        panel->scroll.y = (frame * 37) % (100000 * 20);
+    }
+}
+
+static void scene_text_boxes(oc_arena* arena, u32 frame)
+{
+    oc_ui_style_next(&(oc_ui_style){ .layout.axis = OC_UI_AXIS_X }, OC_UI_STYLE_LAYOUT_AXIS);
+    oc_ui_container("columns", 0)
+    {
+        for(int col = 0; col < 6; col++)
+        {
+            oc_ui_container_str8(oc_str8_pushf(arena, "column %i", col), 0)
+            {
+                for(int row = 0; row < 50; row++)
+                {
+                    oc_str8 name = oc_str8_pushf(arena, "text box %i", row);
+                    oc_str8 text = oc_str8_pushf(arena, "lorem ipsum dolor sit amet %i %i", col, row);
+
+                    oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PIXELS, 200 } },
+                                     OC_UI_STYLE_SIZE_WIDTH);
+                    oc_ui_text_box(name.ptr, arena, text);
+                }
+            }
+        }
+    }
+}
+
+static void scene_theme_rules(oc_arena* arena, u32 frame)
+{
+    static const char* tags[] = { "primary", "secondary", "warning", "error", "muted", "accent", "header", "footer" };
+
+    //NOTE: a stylesheet of tag, text, status and descendant rules, all applied from the root
+    for(int i = 0; i < 200; i++)
+    {
+        oc_ui_pattern pattern = { 0 };
+        switch(i % 4)
+        {
+            case 0:
+                oc_ui_pattern_push(arena, &pattern, (oc_ui_selector){ .kind = OC_UI_SEL_TAG, .tag = oc_ui_tag_make_str8(OC_STR8(tags[i % 8])) });
+                break;
+            case 1:
+                oc_ui_pattern_push(arena, &pattern, (oc_ui_selector){ .kind = OC_UI_SEL_TEXT, .text = oc_str8_pushf(arena, "cell %i", i) });
+                break;
+            case 2:
+                oc_ui_pattern_push(arena, &pattern, (oc_ui_selector){ .kind = OC_UI_SEL_TAG, .tag = oc_ui_tag_make_str8(OC_STR8(tags[i % 8])) });
+                oc_ui_pattern_push(arena, &pattern, (oc_ui_selector){ .kind = OC_UI_SEL_STATUS, .op = OC_UI_SEL_AND, .status = OC_UI_HOVER });
+                break;
+            case 3:
+                oc_ui_pattern_push(arena, &pattern, (oc_ui_selector){ .kind = OC_UI_SEL_TAG, .tag = oc_ui_tag_make_str8(OC_STR8(tags[i % 8])) });
+                oc_ui_pattern_push(arena, &pattern, (oc_ui_selector){ .kind = OC_UI_SEL_TAG, .tag = oc_ui_tag_make_str8(OC_STR8(tags[(i + 1) % 8])) });
+                break;
+        }
+        oc_ui_style style = { .bgColor = { (i % 7) / 7., (i % 5) / 5., (i % 3) / 3., 1 },
+                              .color = { 1, 1, 1, 1 },
+                              .roundness = i % 4 };
+        oc_ui_style_match_after(pattern, &style, OC_UI_STYLE_BG_COLOR | OC_UI_STYLE_COLOR | OC_UI_STYLE_ROUNDNESS);
+    }
+
+    oc_ui_style_next(&(oc_ui_style){ .layout.axis = OC_UI_AXIS_X }, OC_UI_STYLE_LAYOUT_AXIS);
+    oc_ui_container("grid", 0)
+    {
+        for(int col = 0; col < 20; col++)
+        {
+            oc_ui_tag_next(tags[col % 8]);
+            oc_ui_container_str8(oc_str8_pushf(arena, "column %i", col), 0)
+            {
+                for(int row = 0; row < 50; row++)
+                {
+                    int cell = col * 50 + row;
+                    oc_ui_tag_next(tags[(col + row) % 8]);
+                    oc_ui_box_make_str8(oc_str8_pushf(arena, "cell %i", cell),
+                                        OC_UI_FLAG_DRAW_BACKGROUND | OC_UI_FLAG_DRAW_TEXT | OC_UI_FLAG_BLOCK_MOUSE);
+                }
+            }
+        }
+    }
+}
+
+static void scene_menus_popups(oc_arena* arena, u32 frame)
+{
+    oc_ui_menu_bar("menu bar")
+    {
+        for(int i = 0; i < 8; i++)
+        {
+            oc_ui_menu_begin(oc_str8_pushf(arena, "Menu %i", i).ptr);
+            {
+                for(int j = 0; j < 12; j++)
+                {
+                    oc_ui_menu_button(oc_str8_pushf(arena, "Item %i.%i", i, j).ptr);
+                }
+            }
+            oc_ui_menu_end();
+        }
+    }
+
+    static oc_str8 options[] = { OC_STR8_LIT("first option"),
+                                 OC_STR8_LIT("second option"),
+                                 OC_STR8_LIT("third option"),
+                                 OC_STR8_LIT("fourth option") };
+
+    oc_ui_style_next(&(oc_ui_style){ .layout.axis = OC_UI_AXIS_X, .layout.spacing = 10 },
+                     OC_UI_STYLE_LAYOUT_AXIS | OC_UI_STYLE_LAYOUT_SPACING);
+    oc_ui_container("popups", 0)
+    {
+        for(int i = 0; i < 20; i++)
+        {
+            oc_ui_select_popup_info info = { .selectedIndex = i % 4,
+                                             .optionCount = oc_array_size(options),
+                                             .options = options };
+            oc_ui_select_popup(oc_str8_pushf(arena, "popup %i", i).ptr, &info);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------
+// driver
+//------------------------------------------------------------------------------------------
+
+static oc_font load_font(const char* path)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+    oc_str8 fontPath = oc_path_executable_relative(scratch.arena, OC_STR8(path));
+
+    oc_font font = oc_font_nil();
+    oc_file file = oc_file_open(fontPath, OC_FILE_ACCESS_READ, 0);
+    if(oc_file_last_error(file) != OC_IO_OK)
+    {
+        oc_log_error("Couldn't open file %.*s\n", oc_str8_ip(fontPath));
+    }
+    else
+    {
+        u64 size = oc_file_size(file);
+        char* buffer = (char*)oc_arena_push(scratch.arena, size);
+        oc_file_read(file, size, buffer);
+
+        oc_unicode_range ranges[5] = { OC_UNICODE_BASIC_LATIN,
+                                       OC_UNICODE_C1_CONTROLS_AND_LATIN_1_SUPPLEMENT,
+                                       OC_UNICODE_LATIN_EXTENDED_A,
+                                       OC_UNICODE_LATIN_EXTENDED_B,
+                                       OC_UNICODE_SPECIALS };
+
+        font = oc_font_create_from_memory(oc_str8_from_buffer(size, buffer), 5, ranges);
+    }
+    oc_file_close(file);
+    oc_scratch_end(scratch);
+    return (font);
+}
+
+static void send_mouse_event(oc_event_type type, oc_vec2 pos, oc_key_action action)
+{
+    oc_event event = { .type = type };
+    if(type == OC_EVENT_MOUSE_MOVE)
+    {
+        event.mouse = (oc_mouse_event){ .x = pos.x, .y = pos.y };
+    }
+    else
+    {
+        event.key = (oc_key_event){ .action = action, .button = OC_MOUSE_LEFT, .clickCount = 1 };
+    }
+    oc_ui_process_event(&event);
+}
+
+static void run_scene(bench_scene* scene, oc_canvas canvas, oc_font font)
+{
+    oc_ui_context ui;
+    oc_ui_init(&ui);
+
+    oc_arena arena = { 0 };
+    oc_arena_init(&arena);
+
+    oc_ui_style defaultStyle = { .font = font };
+    oc_ui_style_mask defaultMask = OC_UI_STYLE_FONT;
+
+    f64 buildTime = 0;
+    f64 stylingTime = 0;
+    f64 layoutTime = 0;
+    f64 hoverTime = 0;
+    f64 drawTime = 0;
+
+    oc_ui_stats stats = { 0 };
+    oc_canvas_stats canvasStats = { 0 };
+
+    for(u32 frame = 0; frame < WARMUP_FRAMES + MEASURED_FRAMES; frame++)
+    {
+        //NOTE: move the mouse along a lissajous curve covering the frame, and click once near the top-left
+        //      corner after the first layout, which opens the first menu of the menu bar scene
+        f32 t = frame * 0.05;
+        oc_vec2 mouse = { (0.5 + 0.45 * sinf(3 * t)) * frameSize.x,
+                          (0.5 + 0.45 * sinf(2 * t)) * frameSize.y };
+        if(frame == 1)
+        {
+            mouse = (oc_vec2){ 20, 10 };
+            send_mouse_event(OC_EVENT_MOUSE_MOVE, mouse, OC_KEY_NO_ACTION);
+            send_mouse_event(OC_EVENT_MOUSE_BUTTON, mouse, OC_KEY_PRESS);
+            send_mouse_event(OC_EVENT_MOUSE_BUTTON, mouse, OC_KEY_RELEASE);
+        }
+        else
+        {
+            send_mouse_event(OC_EVENT_MOUSE_MOVE, mouse, OC_KEY_NO_ACTION);
+        }
+
+        f64 startTime = oc_clock_time(OC_CLOCK_MONOTONIC);
+
+        oc_ui_begin_frame(frameSize, &defaultStyle, defaultMask);
+        scene->build(&arena, frame);
+
+        f64 buildEndTime = oc_clock_time(OC_CLOCK_MONOTONIC);
+
+        oc_ui_end_frame();
+
+        f64 drawStartTime = oc_clock_time(OC_CLOCK_MONOTONIC);
+
+        oc_canvas_select(canvas);
+        oc_ui_draw();
+        oc_render(canvas);
+
+        f64 endTime = oc_clock_time(OC_CLOCK_MONOTONIC);
+
+        stats = oc_ui_get_stats();
+        canvasStats = oc_canvas_get_stats(canvas);
+
+        if(frame >= WARMUP_FRAMES)
+        {
+            buildTime += buildEndTime - startTime;
+            stylingTime += stats.stylingTime;
+            layoutTime += stats.layoutTime;
+            hoverTime += stats.hitTestTime;
+            drawTime += endTime - drawStartTime;
+        }
+
+        oc_arena_clear(&arena);
+    }
+
+    f64 scale = 1e6 / MEASURED_FRAMES;
+
+    printf("ui_bench format=1 scene=%s frames=%i boxes=%u build_us=%.1f styling_us=%.1f layout_us=%.1f hover_us=%.1f draw_us=%.1f "
+           "arena_bytes=%llu primitives=%u path_elements=%u styles=%u reused_subtrees=%u\n",
+           scene->name,
+           MEASURED_FRAMES,
+           stats.boxCount,
+           buildTime * scale,
+           stylingTime * scale,
+           layoutTime * scale,
+           hoverTime * scale,
+           drawTime * scale,
+           (unsigned long long)stats.frameArenaBytes,
+           canvasStats.primitiveCount,
+           canvasStats.eltCount,
+           stats.styleCount,
+           stats.reusedLayoutCount);
+
+    oc_arena_cleanup(&arena);
+    oc_ui_cleanup();
+}
+
+//------------------------------------------------------------------------------------------
+// layout reuse check
+//------------------------------------------------------------------------------------------
+
+enum
+{
+    SHRINK_GROW_ITEMS = 8,
+};
+
+static void layout_shrink_grow(oc_arena* arena, oc_vec2 size, oc_ui_style* defaultStyle, oc_ui_style_mask defaultMask, oc_rect* rects)
+{
+    oc_ui_begin_frame(size, defaultStyle, defaultMask);
+
+    //NOTE: a row of items that can give up half their width, wider than the shrunk frame. The row and
+    //      its items never change, so their layout is reused, while the root's size changes with the frame.
+    oc_ui_box* items[SHRINK_GROW_ITEMS];
+
+    oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
+                                     .layout.axis = OC_UI_AXIS_X,
+                                     .layout.spacing = 10 },
+                     OC_UI_STYLE_SIZE_WIDTH | OC_UI_STYLE_LAYOUT_AXIS | OC_UI_STYLE_LAYOUT_SPACING);
+    oc_ui_container("row", 0)
+    {
+        for(int i = 0; i < SHRINK_GROW_ITEMS; i++)
+        {
+            oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_CHILDREN, .relax = 0.5 } },
+                             OC_UI_STYLE_SIZE_WIDTH);
+            items[i] = oc_ui_box_begin_str8(oc_str8_pushf(arena, "item %i", i), OC_UI_FLAG_OVERFLOW_ALLOW_X);
+            {
+                oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PIXELS, 120 },
+                                                 .size.height = { OC_UI_SIZE_PIXELS, 20 } },
+                                 OC_UI_STYLE_SIZE);
+                oc_ui_box_make("content", 0);
+            }
+            oc_ui_box_end();
+        }
+    }
+
+    oc_ui_end_frame();
+
+    for(int i = 0; i < SHRINK_GROW_ITEMS; i++)
+    {
+        rects[i] = items[i]->rect;
+    }
+    oc_arena_clear(arena);
+}
+
+static bool check_shrink_grow(oc_font font)
+{
+    oc_arena arena = { 0 };
+    oc_arena_init(&arena);
+
+    oc_ui_style defaultStyle = { .font = font };
+    oc_ui_style_mask defaultMask = OC_UI_STYLE_FONT;
+
+    oc_vec2 smallSize = { 400, frameSize.y };
+
+    //NOTE: reference layout, computed from scratch at full size
+    oc_rect expected[SHRINK_GROW_ITEMS];
+    {
+        oc_ui_context ui;
+        oc_ui_init(&ui);
+        layout_shrink_grow(&arena, frameSize, &defaultStyle, defaultMask, expected);
+        oc_ui_cleanup();
+    }
+
+    //NOTE: same layout, after shrinking the frame and growing it back
+    oc_rect rects[SHRINK_GROW_ITEMS];
+    u32 reusedCount = 0;
+    {
+        oc_ui_context ui;
+        oc_ui_init(&ui);
+        layout_shrink_grow(&arena, frameSize, &defaultStyle, defaultMask, rects);
+        layout_shrink_grow(&arena, smallSize, &defaultStyle, defaultMask, rects);
+        layout_shrink_grow(&arena, frameSize, &defaultStyle, defaultMask, rects);
+        reusedCount = oc_ui_get_stats().reusedLayoutCount;
+        oc_ui_cleanup();
+    }
+
+    f32 maxDiff = 0;
+    for(int i = 0; i < SHRINK_GROW_ITEMS; i++)
+    {
+        maxDiff = oc_max(maxDiff, fabsf(rects[i].x - expected[i].x));
+        maxDiff = oc_max(maxDiff, fabsf(rects[i].y - expected[i].y));
+        maxDiff = oc_max(maxDiff, fabsf(rects[i].w - expected[i].w));
+        maxDiff = oc_max(maxDiff, fabsf(rects[i].h - expected[i].h));
+    }
+    bool pass = (maxDiff == 0);
+
+    printf("ui_bench format=1 check=shrink_grow result=%s reused_subtrees=%u max_diff=%.2f\n",
+           pass ? "pass" : "fail",
+           reusedCount,
+           maxDiff);
+
+    oc_arena_cleanup(&arena);
+    return (pass);
+}
+
+int main()
+{
+    oc_init();
+    oc_clock_init();
+
+    oc_font font = load_font("../../resources/OpenSansLatinSubset.ttf");
+    oc_canvas canvas = oc_canvas_create();
+
+    bench_scene scenes[] = {
+        { "deep_nesting", scene_deep_nesting },
+        { "wide_list", scene_wide_list },
+        { "virtual_list", scene_virtual_list },
+        { "text_boxes", scene_text_boxes },
+        { "theme_rules", scene_theme_rules },
+        { "menus_popups", scene_menus_popups },
+    };
+
+    for(int i = 0; i < oc_array_size(scenes); i++)
+    {
+        run_scene(&scenes[i], canvas, font);
+    }
+
+    bool pass = check_shrink_grow(font);
+
+    oc_canvas_destroy(canvas);
+    oc_font_destroy(font);
+
+    oc_terminate();
+    return (pass ? 0 : -1);
+}
@@ -83,10 +83,15 @@ static void oc_init_common()
 {
     oc_init_window_handles();
     oc_ringbuffer_init(&oc_appData.eventQueue, 16);
+    oc_appData.eventMutex = oc_mutex_create();
+    oc_appData.eventCondition = oc_condition_create();
 }
 
 static void oc_terminate_common()
 {
+    oc_log_flush();
+    oc_condition_destroy(oc_appData.eventCondition);
+    oc_mutex_destroy(oc_appData.eventMutex);
     oc_ringbuffer_cleanup(&oc_appData.eventQueue);
 }
 
@@ -131,11 +136,49 @@ void oc_queue_event(oc_event* event)
         }
         else
         {
+            //NOTE: commit under the event mutex so that a thread in oc_wait_events() can't miss the wakeup
+            oc_mutex_lock(oc_appData.eventMutex);
             oc_ringbuffer_commit(queue);
+            oc_condition_signal(oc_appData.eventCondition);
+            oc_mutex_unlock(oc_appData.eventMutex);
         }
     }
 }
 
+bool oc_wait_events(f64 timeout)
+{
+    oc_ringbuffer* queue = &oc_appData.eventQueue;
+
+    oc_mutex_lock(oc_appData.eventMutex);
+    if(timeout < 0)
+    {
+        while(oc_ringbuffer_read_available(queue) < sizeof(oc_event)
+              && !oc_appData.wakeupRequested)
+        {
+            oc_condition_wait(oc_appData.eventCondition, oc_appData.eventMutex);
+        }
+    }
+    else if(timeout > 0
+            && oc_ringbuffer_read_available(queue) < sizeof(oc_event)
+            && !oc_appData.wakeupRequested)
+    {
+        oc_condition_timedwait(oc_appData.eventCondition, oc_appData.eventMutex, timeout);
+    }
+    oc_appData.wakeupRequested = false;
+    bool available = (oc_ringbuffer_read_available(queue) >= sizeof(oc_event));
+    oc_mutex_unlock(oc_appData.eventMutex);
+
+    return (available);
+}
+
+void oc_wakeup_events(void)
+{
+    oc_mutex_lock(oc_appData.eventMutex);
+    oc_appData.wakeupRequested = true;
+    oc_condition_signal(oc_appData.eventCondition);
+    oc_mutex_unlock(oc_appData.eventMutex);
+}
+
 oc_event* oc_next_event(oc_arena* arena)
 {
     //NOTE: pop and return event from queue
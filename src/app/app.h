@@ -316,8 +316,16 @@ ORCA_API void oc_set_cursor(oc_mouse_cursor cursor);
 	or the timeout elapses.
 
 	oc_next_event() get the next event from the event queue, allocating from the passed arena
+
+	oc_wait_events() blocks the calling thread until the event queue is not empty, or the timeout
+	elapses. A timeout of -1 waits indefinitely. It returns true if events are available.
+
+	oc_wakeup_events() makes the next or current call to oc_wait_events() return even if no event was
+	queued. It can be called from any thread, eg. by background work that needs a new frame when done.
 */
 ORCA_API void oc_pump_events(f64 timeout);
+ORCA_API bool oc_wait_events(f64 timeout);
+ORCA_API void oc_wakeup_events(void);
 ORCA_API oc_event* oc_next_event(oc_arena* arena);
 
 ORCA_API oc_key_code oc_scancode_to_keycode(oc_scan_code scanCode);
@@ -479,6 +487,8 @@ void oc_window_set_title(oc_str8 title);
 void oc_window_set_size(oc_vec2 size);
 
 void ORCA_IMPORT(oc_request_quit)(void);
+void ORCA_IMPORT(oc_request_frame)(void);
+void ORCA_IMPORT(oc_request_frame_after)(f64 delay);
 oc_key_code ORCA_IMPORT(oc_scancode_to_keycode)(oc_scan_code scanCode);
 
 void oc_clipboard_set_string(oc_str8 string);
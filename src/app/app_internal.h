@@ -12,6 +12,7 @@
 
 #include "platform/platform.h"
 #include "platform/platform_io_internal.h"
+#include "platform/platform_thread.h"
 #include "util/ringbuffer.h"
 
 #if OC_PLATFORM_WINDOWS
@@ -67,6 +68,9 @@ typedef struct oc_app
     oc_arena eventArena;
 
     oc_ringbuffer eventQueue;
+    oc_mutex* eventMutex;
+    oc_condition* eventCondition;
+    bool wakeupRequested; // protected by eventMutex
 
     oc_frame_stats frameStats;
 
@@ -1149,6 +1149,7 @@ void oc_terminate()
     //TODO: proper app data cleanup (eg delegate, etc)
     if(oc_appData.init)
     {
+        oc_image_decoder_cleanup();
         oc_arena_cleanup(&oc_appData.eventArena);
         oc_appData = (oc_app){ 0 };
     }
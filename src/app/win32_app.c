@@ -9,6 +9,7 @@
 #include "app.c"
 #include "platform/platform_thread.h"
 #include "graphics/graphics.h"
+#include "graphics/graphics_surface.h"
 #include <dwmapi.h>
 
 void oc_init_keys()
@@ -222,6 +223,8 @@ void oc_terminate()
     {
         SetConsoleOutputCP(oc_appData.win32.savedConsoleCodePage);
 
+        oc_image_decoder_cleanup();
+
         oc_terminate_common();
         oc_appData = (oc_app){ 0 };
     }
@@ -1249,8 +1252,6 @@ oc_str8 oc_clipboard_copy_string(oc_str8 backing)
 // win32 surfaces
 //--------------------------------------------------------------------------------
 
-#include "graphics/graphics_surface.h"
-
 oc_vec2 oc_win32_surface_contents_scaling(oc_surface_data* surface)
 {
     u32 dpi = GetDpiForWindow(surface->layer.hWnd);
@@ -8,6 +8,7 @@
 #include "gl_api.h"
 #include "glsl_shaders.h"
 #include "graphics_surface.h"
+#include "platform/platform_thread.h"
 #include "util/macros.h"
 
 typedef struct oc_gl_image
@@ -32,7 +33,8 @@ typedef struct oc_gl_path
     oc_vec4 clip;
     oc_gl_cmd cmd;
     int textureID;
-    u8 pad[8];
+    float lod;
+    u8 pad[4];
 } oc_gl_path;
 
 enum oc_gl_seg_kind_enum
@@ -126,6 +128,12 @@ enum
     OC_GL_TILE_SIZE = 16,
     OC_GL_MSAA_COUNT = 8,
     OC_GL_MAX_IMAGES_PER_BATCH = 8,
+    OC_GL_MAX_DAMAGE_RECTS = 32,
+
+    OC_GL_ENCODE_WORKER_COUNT = 3,
+    OC_GL_ENCODE_CHUNK_SIZE = 16,
+    OC_GL_ENCODE_PARALLEL_THRESHOLD = 64,
+    OC_GL_ENCODER_MIN_ELT_CAP = 1024,
 };
 
 typedef struct oc_gl_mapped_buffer
@@ -135,6 +143,87 @@ typedef struct oc_gl_mapped_buffer
     char* contents;
 } oc_gl_mapped_buffer;
 
+//NOTE: primitives are encoded in parallel. Each encoder writes the elements of the primitives it
+//      processes into its own storage, then the elements of each batch are copied into disjoint
+//      ranges of the mapped element buffer.
+typedef struct oc_gl_encoder
+{
+    oc_gl_path_elt* elements;
+    u32 eltCount;
+    u32 eltCap;
+
+    oc_primitive* primitive;
+    f32 tolerance; // stroke flattening tolerance of the current primitive, in user space
+    oc_vec4 pathScreenExtents;
+    oc_vec4 pathUserExtents;
+    int maxSegmentCount;
+
+} oc_gl_encoder;
+
+typedef struct oc_gl_encoded_primitive
+{
+    oc_gl_encoder* encoder;
+    u32 eltStart;
+    u32 eltCount;
+    int maxSegmentCount;
+    oc_vec4 pathScreenExtents;
+    oc_vec4 pathUserExtents;
+
+} oc_gl_encoded_primitive;
+
+typedef struct oc_gl_element_copy
+{
+    oc_gl_encoded_primitive* encoded;
+    u32 dstIndex;
+    int pathIndex;
+
+} oc_gl_element_copy;
+
+typedef enum oc_gl_encode_job_kind
+{
+    OC_GL_ENCODE_JOB_ENCODE,
+    OC_GL_ENCODE_JOB_COPY,
+} oc_gl_encode_job_kind;
+
+typedef struct oc_gl_encode_pool oc_gl_encode_pool;
+
+typedef struct oc_gl_encode_worker
+{
+    oc_gl_encode_pool* pool;
+    u32 index;
+    oc_thread* thread;
+
+} oc_gl_encode_worker;
+
+typedef struct oc_gl_encode_pool
+{
+    oc_mutex* mutex;
+    oc_condition* workCondition;
+    oc_condition* doneCondition;
+    oc_gl_encode_worker workers[OC_GL_ENCODE_WORKER_COUNT];
+    oc_gl_encoder encoders[OC_GL_ENCODE_WORKER_COUNT + 1]; // the last encoder is used by the rendering thread
+
+    bool quit;
+    u64 generation;
+    u32 busyCount;
+
+    //NOTE: current job, items are handed out in chunks of OC_GL_ENCODE_CHUNK_SIZE
+    oc_gl_encode_job_kind kind;
+    u32 nextIndex;
+    u32 itemCount;
+
+    u32* primitiveIndices;
+    oc_primitive* primitives;
+    oc_vec4* boxes;
+    oc_path_elt* pathElements;
+    u32 eltCount;
+    oc_gl_encoded_primitive* encoded;
+
+    oc_gl_element_copy* copies;
+    oc_gl_path_elt* dstElements;
+
+} oc_gl_encode_pool;
+
 typedef struct oc_gl_canvas_backend
 {
     oc_canvas_backend interface;
@@ -156,6 +245,21 @@ typedef struct oc_gl_canvas_backend
 
     GLuint outTexture;
 
+    //NOTE: retained output and per-tile damage tracking
+    GLuint compositeTexture;
+    GLuint compositeFramebuffer;
+    GLuint dirtyTilesBuffer;
+
+    int tileCount;
+    u64* tileHashes;
+    u64* prevTileHashes;
+    int* dirtyTiles;
+    bool fullDamage;
+    oc_color lastClearColor;
+
+    u32 damageRectCount;
+    oc_rect damageRects[OC_GL_MAX_DAMAGE_RECTS];
+
     int bufferIndex;
     GLsync bufferSync[OC_GL_INPUT_BUFFERS_COUNT];
     oc_gl_mapped_buffer pathBuffer[OC_GL_INPUT_BUFFERS_COUNT];
@@ -180,7 +284,6 @@ typedef struct oc_gl_canvas_backend
     int pathBatchStart;
     int eltBatchStart;
 
-    oc_primitive* primitive;
     oc_vec4 pathScreenExtents;
     oc_vec4 pathUserExtents;
 
@@ -188,6 +291,11 @@ typedef struct oc_gl_canvas_backend
     int maxSegmentCount;
 
     int currentImageIndex;
+
+    oc_gl_encode_pool encodePool;
+    oc_gl_encoded_primitive* encodedPrimitives;
+    oc_gl_element_copy* pendingCopies;
+    u32 pendingCopyCount;
 } oc_gl_canvas_backend;
 
 static void oc_update_path_extents(oc_vec4* extents, oc_vec2 p)
@@ -221,45 +329,34 @@ void oc_gl_grow_input_buffer(oc_gl_mapped_buffer* buffer, int copyStart, int cop
     *buffer = newBuffer;
 }
 
-void oc_gl_canvas_encode_element(oc_gl_canvas_backend* backend, oc_path_elt_type kind, oc_vec2* p)
+void oc_gl_canvas_encode_element(oc_gl_encoder* encoder, oc_path_elt_type kind, oc_vec2* p)
 {
-    int bufferIndex = backend->bufferIndex;
-    int bufferCap = backend->elementBuffer[bufferIndex].size / sizeof(oc_gl_path_elt);
-    if(backend->eltCount >= bufferCap)
+    if(encoder->eltCount >= encoder->eltCap)
     {
-        int newBufferCap = (int)(bufferCap * 1.5);
-        int newBufferSize = newBufferCap * sizeof(oc_gl_path_elt);
-
-        oc_log_info("growing element buffer to %i elements\n", newBufferCap);
-
-        oc_gl_grow_input_buffer(&backend->elementBuffer[bufferIndex],
-                                backend->eltBatchStart * sizeof(oc_gl_path_elt),
-                                backend->eltCount * sizeof(oc_gl_path_elt),
-                                newBufferSize);
+        encoder->eltCap = oc_max(2 * encoder->eltCap, OC_GL_ENCODER_MIN_ELT_CAP);
+        encoder->elements = realloc(encoder->elements, encoder->eltCap * sizeof(oc_gl_path_elt));
     }
 
-    oc_gl_path_elt* elementData = (oc_gl_path_elt*)backend->elementBuffer[bufferIndex].contents;
-    oc_gl_path_elt* elt = &elementData[backend->eltCount];
-    backend->eltCount++;
+    oc_gl_path_elt* elt = &encoder->elements[encoder->eltCount];
+    encoder->eltCount++;
 
-    elt->pathIndex = backend->pathCount - backend->pathBatchStart;
     int count = 0;
     switch(kind)
     {
         case OC_PATH_LINE:
-            backend->maxSegmentCount += 1;
+            encoder->maxSegmentCount += 1;
             elt->kind = OC_GL_LINE;
             count = 2;
             break;
 
         case OC_PATH_QUADRATIC:
-            backend->maxSegmentCount += 3;
+            encoder->maxSegmentCount += 3;
             elt->kind = OC_GL_QUADRATIC;
             count = 3;
             break;
 
         case OC_PATH_CUBIC:
-            backend->maxSegmentCount += 7;
+            encoder->maxSegmentCount += 7;
             elt->kind = OC_GL_CUBIC;
             count = 4;
             break;
@@ -270,12 +367,12 @@ void oc_gl_canvas_encode_element(oc_gl_canvas_backend* backend, oc_path_elt_type
 
     for(int i = 0; i < count; i++)
     {
-        oc_update_path_extents(&backend->pathUserExtents, p[i]);
+        oc_update_path_extents(&encoder->pathUserExtents, p[i]);
 
-        oc_vec2 screenP = oc_mat2x3_mul(backend->primitive->attributes.transform, p[i]);
+        oc_vec2 screenP = oc_mat2x3_mul(encoder->primitive->attributes.transform, p[i]);
         elt->p[i] = (oc_vec2){ screenP.x, screenP.y };
 
-        oc_update_path_extents(&backend->pathScreenExtents, screenP);
+        oc_update_path_extents(&encoder->pathScreenExtents, screenP);
     }
 }
 
@@ -373,10 +470,12 @@ void oc_gl_canvas_encode_path(oc_gl_canvas_backend* backend, oc_primitive* primi
         path->uvTransform[11] = 0;
 
         path->textureID = backend->currentImageIndex;
+        path->lod = oc_image_sample_lod(primitive->attributes.image, uvTransform, scale);
     }
     else
     {
         path->textureID = -1;
+        path->lod = 0;
     }
 
     int firstTileX = path->box.x * scale / OC_GL_TILE_SIZE;
@@ -579,14 +678,14 @@ static void oc_cubic_split(oc_vec2 p[4], f32 t, oc_vec2 outLeft[4], oc_vec2 outR
     outRight[3] = p[3];
 }
 
-void oc_gl_encode_stroke_line(oc_gl_canvas_backend* backend, oc_vec2* p)
+void oc_gl_encode_stroke_line(oc_gl_encoder* encoder, oc_vec2* p)
 {
     if(p[0].x == p[1].x && p[0].y == p[1].y)
     {
         return;
     }
 
-    f32 width = backend->primitive->attributes.width;
+    f32 width = encoder->primitive->attributes.width;
 
     oc_vec2 v = { p[1].x - p[0].x, p[1].y - p[0].y };
     oc_vec2 n = { v.y, -v.x };
@@ -598,11 +697,11 @@ void oc_gl_encode_stroke_line(oc_gl_canvas_backend* backend, oc_vec2* p)
     oc_vec2 joint0[2] = { oc_vec2_add(p[0], oc_vec2_mul(-1, offset)), oc_vec2_add(p[0], offset) };
     oc_vec2 joint1[2] = { oc_vec2_add(p[1], offset), oc_vec2_add(p[1], oc_vec2_mul(-1, offset)) };
 
-    oc_gl_canvas_encode_element(backend, OC_PATH_LINE, right);
+    oc_gl_canvas_encode_element(encoder, OC_PATH_LINE, right);
 
-    oc_gl_canvas_encode_element(backend, OC_PATH_LINE, left);
-    oc_gl_canvas_encode_element(backend, OC_PATH_LINE, joint0);
-    oc_gl_canvas_encode_element(backend, OC_PATH_LINE, joint1);
+    oc_gl_canvas_encode_element(encoder, OC_PATH_LINE, left);
+    oc_gl_canvas_encode_element(encoder, OC_PATH_LINE, joint0);
+    oc_gl_canvas_encode_element(encoder, OC_PATH_LINE, joint1);
 }
 
 enum
@@ -610,21 +709,21 @@ enum
     OC_HULL_CHECK_SAMPLE_COUNT = 5
 };
 
-void oc_gl_encode_stroke_quadratic(oc_gl_canvas_backend* backend, oc_vec2* p)
+void oc_gl_encode_stroke_quadratic(oc_gl_encoder* encoder, oc_vec2* p, int depth)
 {
-    f32 width = backend->primitive->attributes.width;
-    f32 tolerance = oc_min(backend->primitive->attributes.tolerance, 0.5 * width);
+    f32 width = encoder->primitive->attributes.width;
+    f32 tolerance = encoder->tolerance;
 
     //NOTE: check for degenerate line case
     const f32 equalEps = 1e-3;
     if(oc_vec2_close(p[0], p[1], equalEps))
     {
-        oc_gl_encode_stroke_line(backend, p + 1);
+        oc_gl_encode_stroke_line(encoder, p + 1);
         return;
     }
     else if(oc_vec2_close(p[1], p[2], equalEps))
     {
-        oc_gl_encode_stroke_line(backend, p);
+        oc_gl_encode_stroke_line(encoder, p);
         return;
     }
 
@@ -634,13 +733,21 @@ void oc_gl_encode_stroke_quadratic(oc_gl_canvas_backend* backend, oc_vec2* p)
     if(!oc_offset_hull(3, p, leftHull, width / 2)
        || !oc_offset_hull(3, p, rightHull, -width / 2))
     {
-        //TODO split and recurse
-        //NOTE: offsetting the hull failed, split the curve
-        oc_vec2 splitLeft[3];
-        oc_vec2 splitRight[3];
-        oc_quadratic_split(p, 0.5, splitLeft, splitRight);
-        oc_gl_encode_stroke_quadratic(backend, splitLeft);
-        oc_gl_encode_stroke_quadratic(backend, splitRight);
+        if(depth >= OC_STROKE_MAX_SPLIT_DEPTH)
+        {
+            //NOTE: stop splitting and stroke the chord
+            oc_vec2 line[2] = { p[0], p[2] };
+            oc_gl_encode_stroke_line(encoder, line);
+        }
+        else
+        {
+            //NOTE: offsetting the hull failed, split the curve
+            oc_vec2 splitLeft[3];
+            oc_vec2 splitRight[3];
+            oc_quadratic_split(p, 0.5, splitLeft, splitRight);
+            oc_gl_encode_stroke_quadratic(encoder, splitLeft, depth + 1);
+            oc_gl_encode_stroke_quadratic(encoder, splitRight, depth + 1);
+        }
     }
     else
     {
@@ -675,13 +782,14 @@ void oc_gl_encode_stroke_quadratic(oc_gl_canvas_backend* backend, oc_vec2* p)
             }
         }
 
-        if(maxOvershoot > 0)
+        //NOTE: past the maximum depth, the hull is used as is even if it's not within tolerance
+        if(maxOvershoot > 0 && depth < OC_STROKE_MAX_SPLIT_DEPTH)
         {
             oc_vec2 splitLeft[3];
             oc_vec2 splitRight[3];
             oc_quadratic_split(p, maxOvershootParameter, splitLeft, splitRight);
-            oc_gl_encode_stroke_quadratic(backend, splitLeft);
-            oc_gl_encode_stroke_quadratic(backend, splitRight);
+            oc_gl_encode_stroke_quadratic(encoder, splitLeft, depth + 1);
+            oc_gl_encode_stroke_quadratic(encoder, splitRight, depth + 1);
         }
         else
         {
@@ -689,21 +797,21 @@ void oc_gl_encode_stroke_quadratic(oc_gl_canvas_backend* backend, oc_vec2* p)
             leftHull[0] = leftHull[2];
             leftHull[2] = tmp;
 
-            oc_gl_canvas_encode_element(backend, OC_PATH_QUADRATIC, rightHull);
-            oc_gl_canvas_encode_element(backend, OC_PATH_QUADRATIC, leftHull);
+            oc_gl_canvas_encode_element(encoder, OC_PATH_QUADRATIC, rightHull);
+            oc_gl_canvas_encode_element(encoder, OC_PATH_QUADRATIC, leftHull);
 
             oc_vec2 joint0[2] = { rightHull[2], leftHull[0] };
             oc_vec2 joint1[2] = { leftHull[2], rightHull[0] };
-            oc_gl_canvas_encode_element(backend, OC_PATH_LINE, joint0);
-            oc_gl_canvas_encode_element(backend, OC_PATH_LINE, joint1);
+            oc_gl_canvas_encode_element(encoder, OC_PATH_LINE, joint0);
+            oc_gl_canvas_encode_element(encoder, OC_PATH_LINE, joint1);
         }
     }
 }
 
-void oc_gl_encode_stroke_cubic(oc_gl_canvas_backend* backend, oc_vec2* p)
+void oc_gl_encode_stroke_cubic(oc_gl_encoder* encoder, oc_vec2* p, int depth)
 {
-    f32 width = backend->primitive->attributes.width;
-    f32 tolerance = oc_min(backend->primitive->attributes.tolerance, 0.5 * width);
+    f32 width = encoder->primitive->attributes.width;
+    f32 tolerance = encoder->tolerance;
 
     //NOTE: check degenerate line cases
     f32 equalEps = 1e-3;
@@ -713,19 +821,19 @@ void oc_gl_encode_stroke_cubic(oc_gl_canvas_backend* backend, oc_vec2* p)
        || (oc_vec2_close(p[1], p[2], equalEps) && oc_vec2_close(p[2], p[3], equalEps)))
     {
         oc_vec2 line[2] = { p[0], p[3] };
-        oc_gl_encode_stroke_line(backend, line);
+        oc_gl_encode_stroke_line(encoder, line);
         return;
     }
     else if(oc_vec2_close(p[0], p[1], equalEps) && oc_vec2_close(p[1], p[3], equalEps))
     {
         oc_vec2 line[2] = { p[0], oc_vec2_add(oc_vec2_mul(5. / 9, p[0]), oc_vec2_mul(4. / 9, p[2])) };
-        oc_gl_encode_stroke_line(backend, line);
+        oc_gl_encode_stroke_line(encoder, line);
         return;
     }
     else if(oc_vec2_close(p[0], p[2], equalEps) && oc_vec2_close(p[2], p[3], equalEps))
     {
         oc_vec2 line[2] = { p[0], oc_vec2_add(oc_vec2_mul(5. / 9, p[0]), oc_vec2_mul(4. / 9, p[1])) };
-        oc_gl_encode_stroke_line(backend, line);
+        oc_gl_encode_stroke_line(encoder, line);
         return;
     }
 
@@ -735,13 +843,21 @@ void oc_gl_encode_stroke_cubic(oc_gl_canvas_backend* backend, oc_vec2* p)
     if(!oc_offset_hull(4, p, leftHull, width / 2)
        || !oc_offset_hull(4, p, rightHull, -width / 2))
     {
-        //TODO split and recurse
-        //NOTE: offsetting the hull failed, split the curve
-        oc_vec2 splitLeft[4];
-        oc_vec2 splitRight[4];
-        oc_cubic_split(p, 0.5, splitLeft, splitRight);
-        oc_gl_encode_stroke_cubic(backend, splitLeft);
-        oc_gl_encode_stroke_cubic(backend, splitRight);
+        if(depth >= OC_STROKE_MAX_SPLIT_DEPTH)
+        {
+            //NOTE: stop splitting and stroke the chord
+            oc_vec2 line[2] = { p[0], p[3] };
+            oc_gl_encode_stroke_line(encoder, line);
+        }
+        else
+        {
+            //NOTE: offsetting the hull failed, split the curve
+            oc_vec2 splitLeft[4];
+            oc_vec2 splitRight[4];
+            oc_cubic_split(p, 0.5, splitLeft, splitRight);
+            oc_gl_encode_stroke_cubic(encoder, splitLeft, depth + 1);
+            oc_gl_encode_stroke_cubic(encoder, splitRight, depth + 1);
+        }
     }
     else
     {
@@ -776,13 +892,14 @@ void oc_gl_encode_stroke_cubic(oc_gl_canvas_backend* backend, oc_vec2* p)
             }
         }
 
-        if(maxOvershoot > 0)
+        //NOTE: past the maximum depth, the hull is used as is even if it's not within tolerance
+        if(maxOvershoot > 0 && depth < OC_STROKE_MAX_SPLIT_DEPTH)
         {
             oc_vec2 splitLeft[4];
             oc_vec2 splitRight[4];
             oc_cubic_split(p, maxOvershootParameter, splitLeft, splitRight);
-            oc_gl_encode_stroke_cubic(backend, splitLeft);
-            oc_gl_encode_stroke_cubic(backend, splitRight);
+            oc_gl_encode_stroke_cubic(encoder, splitLeft, depth + 1);
+            oc_gl_encode_stroke_cubic(encoder, splitRight, depth + 1);
         }
         else
         {
@@ -793,18 +910,18 @@ void oc_gl_encode_stroke_cubic(oc_gl_canvas_backend* backend, oc_vec2* p)
             leftHull[1] = leftHull[2];
             leftHull[2] = tmp;
 
-            oc_gl_canvas_encode_element(backend, OC_PATH_CUBIC, rightHull);
-            oc_gl_canvas_encode_element(backend, OC_PATH_CUBIC, leftHull);
+            oc_gl_canvas_encode_element(encoder, OC_PATH_CUBIC, rightHull);
+            oc_gl_canvas_encode_element(encoder, OC_PATH_CUBIC, leftHull);
 
             oc_vec2 joint0[2] = { rightHull[3], leftHull[0] };
             oc_vec2 joint1[2] = { leftHull[3], rightHull[0] };
-            oc_gl_canvas_encode_element(backend, OC_PATH_LINE, joint0);
-            oc_gl_canvas_encode_element(backend, OC_PATH_LINE, joint1);
+            oc_gl_canvas_encode_element(encoder, OC_PATH_LINE, joint0);
+            oc_gl_canvas_encode_element(encoder, OC_PATH_LINE, joint1);
         }
     }
 }
 
-void oc_gl_encode_stroke_element(oc_gl_canvas_backend* backend,
+void oc_gl_encode_stroke_element(oc_gl_encoder* encoder,
                                  oc_path_elt* element,
                                  oc_vec2 currentPoint,
                                  oc_vec2* startTangent,
@@ -817,17 +934,17 @@ void oc_gl_encode_stroke_element(oc_gl_canvas_backend* backend,
     switch(element->type)
     {
         case OC_PATH_LINE:
-            oc_gl_encode_stroke_line(backend, controlPoints);
+            oc_gl_encode_stroke_line(encoder, controlPoints);
             endPointIndex = 1;
             break;
 
         case OC_PATH_QUADRATIC:
-            oc_gl_encode_stroke_quadratic(backend, controlPoints);
+            oc_gl_encode_stroke_quadratic(encoder, controlPoints, 0);
             endPointIndex = 2;
             break;
 
         case OC_PATH_CUBIC:
-            oc_gl_encode_stroke_cubic(backend, controlPoints);
+            oc_gl_encode_stroke_cubic(encoder, controlPoints, 0);
             endPointIndex = 3;
             break;
 
@@ -864,11 +981,11 @@ void oc_gl_encode_stroke_element(oc_gl_canvas_backend* backend,
     OC_DEBUG_ASSERT(startTangent->x != 0 || startTangent->y != 0);
 }
 
-void oc_gl_stroke_cap(oc_gl_canvas_backend* backend,
+void oc_gl_stroke_cap(oc_gl_encoder* encoder,
                       oc_vec2 p0,
                       oc_vec2 direction)
 {
-    oc_attributes* attributes = &backend->primitive->attributes;
+    oc_attributes* attributes = &encoder->primitive->attributes;
 
     //NOTE(martin): compute the tangent and normal vectors (multiplied by half width) at the cap point
     f32 dn = sqrt(oc_square(direction.x) + oc_square(direction.y));
@@ -886,18 +1003,18 @@ void oc_gl_stroke_cap(oc_gl_canvas_backend* backend,
                          { p0.x - n0.x, p0.y - n0.y },
                          { p0.x + n0.x, p0.y + n0.y } };
 
-    oc_gl_canvas_encode_element(backend, OC_PATH_LINE, points);
-    oc_gl_canvas_encode_element(backend, OC_PATH_LINE, points + 1);
-    oc_gl_canvas_encode_element(backend, OC_PATH_LINE, points + 2);
-    oc_gl_canvas_encode_element(backend, OC_PATH_LINE, points + 3);
+    oc_gl_canvas_encode_element(encoder, OC_PATH_LINE, points);
+    oc_gl_canvas_encode_element(encoder, OC_PATH_LINE, points + 1);
+    oc_gl_canvas_encode_element(encoder, OC_PATH_LINE, points + 2);
+    oc_gl_canvas_encode_element(encoder, OC_PATH_LINE, points + 3);
 }
 
-void oc_gl_stroke_joint(oc_gl_canvas_backend* backend,
+void oc_gl_stroke_joint(oc_gl_encoder* encoder,
                         oc_vec2 p0,
                         oc_vec2 t0,
                         oc_vec2 t1)
 {
-    oc_attributes* attributes = &backend->primitive->attributes;
+    oc_attributes* attributes = &encoder->primitive->attributes;
 
     //NOTE(martin): compute the normals at the joint point
     f32 norm_t0 = sqrt(oc_square(t0.x) + oc_square(t0.y));
@@ -945,10 +1062,10 @@ void oc_gl_stroke_joint(oc_gl_canvas_backend* backend,
                              { p0.x + n1.x * halfW, p0.y + n1.y * halfW },
                              p0 };
 
-        oc_gl_canvas_encode_element(backend, OC_PATH_LINE, points);
-        oc_gl_canvas_encode_element(backend, OC_PATH_LINE, points + 1);
-        oc_gl_canvas_encode_element(backend, OC_PATH_LINE, points + 2);
-        oc_gl_canvas_encode_element(backend, OC_PATH_LINE, points + 3);
+        oc_gl_canvas_encode_element(encoder, OC_PATH_LINE, points);
+        oc_gl_canvas_encode_element(encoder, OC_PATH_LINE, points + 1);
+        oc_gl_canvas_encode_element(encoder, OC_PATH_LINE, points + 2);
+        oc_gl_canvas_encode_element(encoder, OC_PATH_LINE, points + 3);
     }
     else
     {
@@ -958,13 +1075,13 @@ void oc_gl_stroke_joint(oc_gl_canvas_backend* backend,
                              { p0.x + n1.x * halfW, p0.y + n1.y * halfW },
                              p0 };
 
-        oc_gl_canvas_encode_element(backend, OC_PATH_LINE, points);
-        oc_gl_canvas_encode_element(backend, OC_PATH_LINE, points + 1);
-        oc_gl_canvas_encode_element(backend, OC_PATH_LINE, points + 2);
+        oc_gl_canvas_encode_element(encoder, OC_PATH_LINE, points);
+        oc_gl_canvas_encode_element(encoder, OC_PATH_LINE, points + 1);
+        oc_gl_canvas_encode_element(encoder, OC_PATH_LINE, points + 2);
     }
 }
 
-u32 oc_gl_encode_stroke_subpath(oc_gl_canvas_backend* backend,
+u32 oc_gl_encode_stroke_subpath(oc_gl_encoder* encoder,
                                 oc_path_elt* elements,
                                 oc_path_descriptor* path,
                                 u32 startIndex,
@@ -981,7 +1098,7 @@ u32 oc_gl_encode_stroke_subpath(oc_gl_canvas_backend* backend,
     oc_vec2 endTangent = { 0, 0 };
 
     //NOTE(martin): encode first element and compute first tangent
-    oc_gl_encode_stroke_element(backend, elements + startIndex, currentPoint, &startTangent, &endTangent, &endPoint);
+    oc_gl_encode_stroke_element(encoder, elements + startIndex, currentPoint, &startTangent, &endTangent, &endPoint);
 
     firstTangent = startTangent;
     previousEndTangent = endTangent;
@@ -989,18 +1106,18 @@ u32 oc_gl_encode_stroke_subpath(oc_gl_canvas_backend* backend,
 
     //NOTE(martin): encode subsequent elements along with their joints
 
-    oc_attributes* attributes = &backend->primitive->attributes;
+    oc_attributes* attributes = &encoder->primitive->attributes;
 
     u32 eltIndex = startIndex + 1;
     for(;
         eltIndex < eltCount && elements[eltIndex].type != OC_PATH_MOVE;
         eltIndex++)
     {
-        oc_gl_encode_stroke_element(backend, elements + eltIndex, currentPoint, &startTangent, &endTangent, &endPoint);
+        oc_gl_encode_stroke_element(encoder, elements + eltIndex, currentPoint, &startTangent, &endTangent, &endPoint);
 
         if(attributes->joint != OC_JOINT_NONE)
         {
-            oc_gl_stroke_joint(backend, currentPoint, previousEndTangent, startTangent);
+            oc_gl_stroke_joint(encoder, currentPoint, previousEndTangent, startTangent);
         }
         previousEndTangent = endTangent;
         currentPoint = endPoint;
@@ -1015,19 +1132,19 @@ u32 oc_gl_encode_stroke_subpath(oc_gl_canvas_backend* backend,
         if(attributes->joint != OC_JOINT_NONE)
         {
             //NOTE(martin): add a closing joint if the path is closed
-            oc_gl_stroke_joint(backend, endPoint, endTangent, firstTangent);
+            oc_gl_stroke_joint(encoder, endPoint, endTangent, firstTangent);
         }
     }
     else if(attributes->cap == OC_CAP_SQUARE)
     {
         //NOTE(martin): add start and end cap
-        oc_gl_stroke_cap(backend, startPoint, (oc_vec2){ -startTangent.x, -startTangent.y });
-        oc_gl_stroke_cap(backend, endPoint, endTangent);
+        oc_gl_stroke_cap(encoder, startPoint, (oc_vec2){ -startTangent.x, -startTangent.y });
+        oc_gl_stroke_cap(encoder, endPoint, endTangent);
     }
     return (eltIndex);
 }
 
-void oc_gl_encode_stroke(oc_gl_canvas_backend* backend,
+void oc_gl_encode_stroke(oc_gl_encoder* encoder,
                          oc_path_elt* elements,
                          oc_path_descriptor* path)
 {
@@ -1047,11 +1164,315 @@ void oc_gl_encode_stroke(oc_gl_canvas_backend* backend,
         }
         if(startIndex < eltCount)
         {
-            startIndex = oc_gl_encode_stroke_subpath(backend, elements, path, startIndex, startPoint);
+            startIndex = oc_gl_encode_stroke_subpath(encoder, elements, path, startIndex, startPoint);
         }
     }
 }
 
+static oc_vec2 oc_gl_encode_fill_element(oc_gl_encoder* encoder, oc_path_elt_type type, oc_vec2 currentPos, oc_vec2* points)
+{
+    oc_vec2 p[4] = { currentPos, points[0], points[1], points[2] };
+
+    switch(type)
+    {
+        case OC_PATH_MOVE:
+            currentPos = points[0];
+            break;
+
+        case OC_PATH_LINE:
+            oc_gl_canvas_encode_element(encoder, type, p);
+            currentPos = points[0];
+            break;
+
+        case OC_PATH_QUADRATIC:
+            oc_gl_canvas_encode_element(encoder, type, p);
+            currentPos = points[1];
+            break;
+
+        case OC_PATH_CUBIC:
+            oc_gl_canvas_encode_element(encoder, type, p);
+            currentPos = points[2];
+            break;
+
+        default:
+            break;
+    }
+    return (currentPos);
+}
+
+void oc_gl_encode_fill(oc_gl_encoder* encoder,
+                       oc_path_elt* elements,
+                       u32 eltCount,
+                       oc_path_descriptor* path)
+{
+    //NOTE: start from the path's start point rather than from the end of the previous primitive,
+    //      so that primitives can be culled or skipped without affecting the next ones
+    oc_vec2 currentPos = path->startPoint;
+
+    for(u32 eltIndex = 0;
+        (eltIndex < path->count) && (path->startIndex + eltIndex < eltCount);
+        eltIndex++)
+    {
+        oc_path_elt* elt = &elements[path->startIndex + eltIndex];
+
+        if(elt->type == OC_PATH_GLYPH_DEF)
+        {
+            //NOTE: skip glyph outlines definitions, they are only drawn through glyph elements
+            eltIndex += elt->glyphDef.count;
+        }
+        else if(elt->type == OC_PATH_GLYPH)
+        {
+            //NOTE: encode the referenced glyph outlines, applying the glyph's scale and origin
+            u32 defIndex = elt->glyph.defIndex;
+            oc_path_elt* def = &elements[defIndex];
+
+            if(defIndex < eltCount
+               && def->type == OC_PATH_GLYPH_DEF
+               && defIndex + def->glyphDef.count < eltCount)
+            {
+                oc_vec2 origin = elt->glyph.origin;
+                oc_vec2 scale = elt->glyph.scale;
+                oc_vec2 glyphPos = origin;
+
+                for(u32 outlineIndex = 1; outlineIndex <= def->glyphDef.count; outlineIndex++)
+                {
+                    oc_path_elt* outline = &def[outlineIndex];
+                    oc_vec2 points[3];
+                    for(int i = 0; i < 3; i++)
+                    {
+                        points[i] = (oc_vec2){ origin.x + scale.x * outline->p[i].x,
+                                               origin.y + scale.y * outline->p[i].y };
+                    }
+                    glyphPos = oc_gl_encode_fill_element(encoder, outline->type, glyphPos, points);
+                }
+            }
+            currentPos = elt->glyph.origin;
+        }
+        else
+        {
+            currentPos = oc_gl_encode_fill_element(encoder, elt->type, currentPos, elt->p);
+        }
+    }
+}
+
+static void oc_gl_encode_primitive(oc_gl_encoder* encoder,
+                                   oc_primitive* primitive,
+                                   oc_vec4 box,
+                                   oc_path_elt* pathElements,
+                                   u32 eltCount,
+                                   oc_gl_encoded_primitive* encoded)
+{
+    encoder->primitive = primitive;
+    encoder->tolerance = oc_primitive_stroke_tolerance(primitive, box);
+    encoder->pathScreenExtents = (oc_vec4){ FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
+    encoder->pathUserExtents = (oc_vec4){ FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
+    encoder->maxSegmentCount = 0;
+
+    u32 eltStart = encoder->eltCount;
+
+    if(primitive->cmd == OC_CMD_STROKE)
+    {
+        oc_gl_encode_stroke(encoder, pathElements + primitive->path.startIndex, &primitive->path);
+    }
+    else
+    {
+        oc_gl_encode_fill(encoder, pathElements, eltCount, &primitive->path);
+    }
+
+    encoded->encoder = encoder;
+    encoded->eltStart = eltStart;
+    encoded->eltCount = encoder->eltCount - eltStart;
+    encoded->maxSegmentCount = encoder->maxSegmentCount;
+    encoded->pathScreenExtents = encoder->pathScreenExtents;
+    encoded->pathUserExtents = encoder->pathUserExtents;
+}
+
+static void oc_gl_copy_encoded_elements(oc_gl_path_elt* dstElements, oc_gl_element_copy* copy)
+{
+    oc_gl_encoded_primitive* encoded = copy->encoded;
+    oc_gl_path_elt* src = encoded->encoder->elements + encoded->eltStart;
+    oc_gl_path_elt* dst = dstElements + copy->dstIndex;
+
+    for(u32 i = 0; i < encoded->eltCount; i++)
+    {
+        dst[i] = src[i];
+        dst[i].pathIndex = copy->pathIndex;
+    }
+}
+
+static void oc_gl_encode_pool_work(oc_gl_encode_pool* pool, u32 encoderIndex)
+{
+    oc_gl_encoder* encoder = &pool->encoders[encoderIndex];
+
+    while(true)
+    {
+        oc_mutex_lock(pool->mutex);
+        u32 start = pool->nextIndex;
+        pool->nextIndex += OC_GL_ENCODE_CHUNK_SIZE;
+        oc_mutex_unlock(pool->mutex);
+
+        if(start >= pool->itemCount)
+        {
+            break;
+        }
+        u32 end = oc_min(start + OC_GL_ENCODE_CHUNK_SIZE, pool->itemCount);
+
+        for(u32 i = start; i < end; i++)
+        {
+            if(pool->kind == OC_GL_ENCODE_JOB_ENCODE)
+            {
+                u32 primitiveIndex = pool->primitiveIndices[i];
+                oc_gl_encode_primitive(encoder,
+                                       &pool->primitives[primitiveIndex],
+                                       pool->boxes[primitiveIndex],
+                                       pool->pathElements,
+                                       pool->eltCount,
+                                       &pool->encoded[primitiveIndex]);
+            }
+            else
+            {
+                oc_gl_copy_encoded_elements(pool->dstElements, &pool->copies[i]);
+            }
+        }
+    }
+}
+
+i32 oc_gl_encode_worker_proc(void* userPointer)
+{
+    oc_gl_encode_worker* worker = (oc_gl_encode_worker*)userPointer;
+    oc_gl_encode_pool* pool = worker->pool;
+    u64 generation = 0;
+
+    oc_mutex_lock(pool->mutex);
+    while(true)
+    {
+        while(!pool->quit && pool->generation == generation)
+        {
+            oc_condition_wait(pool->workCondition, pool->mutex);
+        }
+        if(pool->quit)
+        {
+            break;
+        }
+        generation = pool->generation;
+        oc_mutex_unlock(pool->mutex);
+
+        oc_gl_encode_pool_work(pool, worker->index);
+
+        oc_mutex_lock(pool->mutex);
+        pool->busyCount--;
+        if(!pool->busyCount)
+        {
+            oc_condition_signal(pool->doneCondition);
+        }
+    }
+    oc_mutex_unlock(pool->mutex);
+    return (0);
+}
+
+static void oc_gl_encode_pool_init(oc_gl_encode_pool* pool)
+{
+    pool->mutex = oc_mutex_create();
+    pool->workCondition = oc_condition_create();
+    pool->doneCondition = oc_condition_create();
+
+    for(int i = 0; i < OC_GL_ENCODE_WORKER_COUNT; i++)
+    {
+        oc_gl_encode_worker* worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->index = i;
+        worker->thread = oc_thread_create(oc_gl_encode_worker_proc, worker);
+    }
+}
+
+static void oc_gl_encode_pool_cleanup(oc_gl_encode_pool* pool)
+{
+    if(pool->mutex)
+    {
+        oc_mutex_lock(pool->mutex);
+        pool->quit = true;
+        oc_condition_broadcast(pool->workCondition);
+        oc_mutex_unlock(pool->mutex);
+
+        for(int i = 0; i < OC_GL_ENCODE_WORKER_COUNT; i++)
+        {
+            if(pool->workers[i].thread)
+            {
+                oc_thread_join(pool->workers[i].thread, 0);
+            }
+        }
+        oc_condition_destroy(pool->workCondition);
+        oc_condition_destroy(pool->doneCondition);
+        oc_mutex_destroy(pool->mutex);
+    }
+    for(int i = 0; i < OC_GL_ENCODE_WORKER_COUNT + 1; i++)
+    {
+        free(pool->encoders[i].elements);
+    }
+}
+
+static void oc_gl_encode_pool_run(oc_gl_encode_pool* pool, oc_gl_encode_job_kind kind, u32 itemCount)
+{
+    pool->kind = kind;
+    pool->nextIndex = 0;
+    pool->itemCount = itemCount;
+
+    if(itemCount < OC_GL_ENCODE_PARALLEL_THRESHOLD)
+    {
+        //NOTE: not worth waking up the workers, do everything on the rendering thread
+        oc_gl_encode_pool_work(pool, OC_GL_ENCODE_WORKER_COUNT);
+    }
+    else
+    {
+        oc_mutex_lock(pool->mutex);
+        pool->generation++;
+        pool->busyCount = OC_GL_ENCODE_WORKER_COUNT;
+        oc_condition_broadcast(pool->workCondition);
+        oc_mutex_unlock(pool->mutex);
+
+        oc_gl_encode_pool_work(pool, OC_GL_ENCODE_WORKER_COUNT);
+
+        oc_mutex_lock(pool->mutex);
+        while(pool->busyCount)
+        {
+            oc_condition_wait(pool->doneCondition, pool->mutex);
+        }
+        oc_mutex_unlock(pool->mutex);
+    }
+}
+
+static void oc_gl_write_batch_elements(oc_gl_canvas_backend* backend)
+{
+    //NOTE: make sure the element buffer can hold the batch, then copy encoded elements into it in parallel
+    if(!backend->pendingCopyCount)
+    {
+        return;
+    }
+
+    int bufferIndex = backend->bufferIndex;
+    int bufferCap = backend->elementBuffer[bufferIndex].size / sizeof(oc_gl_path_elt);
+    if(backend->eltCount > bufferCap)
+    {
+        int newBufferCap = oc_max((int)(bufferCap * 1.5), backend->eltCount);
+        int newBufferSize = newBufferCap * sizeof(oc_gl_path_elt);
+
+        oc_log_info("growing element buffer to %i elements\n", newBufferCap);
+
+        oc_gl_grow_input_buffer(&backend->elementBuffer[bufferIndex],
+                                backend->eltBatchStart * sizeof(oc_gl_path_elt),
+                                0,
+                                newBufferSize);
+    }
+
+    oc_gl_encode_pool* pool = &backend->encodePool;
+    pool->copies = backend->pendingCopies;
+    pool->dstElements = (oc_gl_path_elt*)backend->elementBuffer[bufferIndex].contents;
+
+    oc_gl_encode_pool_run(pool, OC_GL_ENCODE_JOB_COPY, backend->pendingCopyCount);
+
+    backend->pendingCopyCount = 0;
+}
+
 void oc_gl_grow_buffer_if_needed(GLuint buffer, i32 wantedSize, const char* name)
 {
     i32 oldSize = 0;
@@ -1078,6 +1499,8 @@ void oc_gl_render_batch(oc_gl_canvas_backend* backend,
                         oc_vec2 viewportSize,
                         f32 scale)
 {
+    oc_gl_write_batch_elements(backend);
+
     GLuint pathBuffer = backend->pathBuffer[backend->bufferIndex].buffer;
     GLuint elementBuffer = backend->elementBuffer[backend->bufferIndex].buffer;
 
@@ -1245,10 +1668,13 @@ void oc_gl_render_batch(oc_gl_canvas_backend* backend,
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, backend->screenTilesBuffer);
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, backend->screenTilesCountBuffer);
 
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, backend->dirtyTilesBuffer);
+
     glUniform1i(0, tileSize);
     glUniform1f(1, scale);
     glUniform1i(2, pathCount);
     glUniform1i(3, backend->pathBatchStart);
+    glUniform1i(4, nTilesX);
 
     glDispatchCompute(nTilesX, nTilesY, 1);
     glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
@@ -1316,7 +1742,8 @@ void oc_gl_render_batch(oc_gl_canvas_backend* backend,
         }
     }
 
-    //NOTE: blit pass
+    //NOTE: blit pass, composited over the retained output of previous frames
+    glBindFramebuffer(GL_FRAMEBUFFER, backend->compositeFramebuffer);
     glUseProgram(backend->blit);
     glBindBuffer(GL_ARRAY_BUFFER, backend->dummyVertexBuffer);
     glActiveTexture(GL_TEXTURE0);
@@ -1341,6 +1768,52 @@ void oc_gl_render_batch(oc_gl_canvas_backend* backend,
     backend->maxTileQueueCount = 0;
 }
 
+void oc_gl_canvas_resize_damage_tracking(oc_gl_canvas_backend* backend, oc_vec2 size)
+{
+    int tileSize = OC_GL_TILE_SIZE;
+    int nTilesX = (int)(size.x + tileSize - 1) / tileSize;
+    int nTilesY = (int)(size.y + tileSize - 1) / tileSize;
+
+    //NOTE: (re)create the retained composite target. Batches are blitted into it, and it is
+    //      copied to the default framebuffer on each frame, so that tiles that didn't change
+    //      since the last frame don't need to be rasterized again.
+    if(backend->compositeTexture)
+    {
+        glDeleteTextures(1, &backend->compositeTexture);
+    }
+    glGenTextures(1, &backend->compositeTexture);
+    glBindTexture(GL_TEXTURE_2D, backend->compositeTexture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, size.x, size.y);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    if(!backend->compositeFramebuffer)
+    {
+        glGenFramebuffers(1, &backend->compositeFramebuffer);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, backend->compositeFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, backend->compositeTexture, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    //NOTE: per-tile hashes of the primitives that touch each tile
+    backend->tileCount = nTilesX * nTilesY;
+
+    free(backend->tileHashes);
+    free(backend->prevTileHashes);
+    free(backend->dirtyTiles);
+
+    backend->tileHashes = oc_malloc_array(u64, backend->tileCount);
+    backend->prevTileHashes = oc_malloc_array(u64, backend->tileCount);
+    backend->dirtyTiles = oc_malloc_array(int, backend->tileCount);
+
+    memset(backend->prevTileHashes, 0, backend->tileCount * sizeof(u64));
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, backend->dirtyTilesBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, backend->tileCount * sizeof(int), 0, GL_DYNAMIC_COPY);
+
+    backend->fullDamage = true;
+}
+
 void oc_gl_canvas_resize(oc_gl_canvas_backend* backend, oc_vec2 size)
 {
     int tileSize = OC_GL_TILE_SIZE;
@@ -1350,6 +1823,8 @@ void oc_gl_canvas_resize(oc_gl_canvas_backend* backend, oc_vec2 size)
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, backend->screenTilesBuffer);
     glBufferData(GL_SHADER_STORAGE_BUFFER, nTilesX * nTilesY * OC_GL_SCREEN_TILE_SIZE, 0, GL_DYNAMIC_COPY);
 
+    oc_gl_canvas_resize_damage_tracking(backend, size);
+
     if(backend->outTexture)
     {
         //NOTE: do we need to explicitly glDeleteTextures()?
@@ -1364,6 +1839,281 @@ void oc_gl_canvas_resize(oc_gl_canvas_backend* backend, oc_vec2 size)
     backend->frameSize = size;
 }
 
+//--------------------------------------------------------------------
+// Damage tracking
+//--------------------------------------------------------------------
+
+typedef struct oc_gl_primitive_key
+{
+    oc_primitive_cmd cmd;
+    oc_color color;
+    f32 width;
+    oc_joint_type joint;
+    f32 maxJointExcursion;
+    oc_cap_type cap;
+    u64 image;
+    oc_rect srcRegion;
+    oc_mat2x3 transform;
+    oc_rect clip;
+    oc_vec2 startPoint;
+} oc_gl_primitive_key;
+
+static u64 oc_gl_primitive_hash(oc_primitive* primitive, oc_path_elt* elements, u32 count)
+{
+    //NOTE: only hash attributes that affect rasterization. The key is zeroed first so that padding bytes are stable.
+    oc_gl_primitive_key key;
+    memset(&key, 0, sizeof(oc_gl_primitive_key));
+
+    key.cmd = primitive->cmd;
+    key.color = primitive->attributes.color;
+    key.image = primitive->attributes.image.h;
+    key.srcRegion = primitive->attributes.srcRegion;
+    key.transform = primitive->attributes.transform;
+    key.clip = primitive->attributes.clip;
+    key.startPoint = primitive->path.startPoint;
+
+    if(primitive->cmd == OC_CMD_STROKE)
+    {
+        key.width = primitive->attributes.width;
+        key.joint = primitive->attributes.joint;
+        key.maxJointExcursion = primitive->attributes.maxJointExcursion;
+        key.cap = primitive->attributes.cap;
+    }
+
+    u64 hash = oc_hash_xx64_string(oc_str8_from_buffer(sizeof(oc_gl_primitive_key), (char*)&key));
+
+    //NOTE: glyph outlines definitions are not drawn by themselves and can move to another primitive from
+    //      one frame to the next, so they are skipped. Glyph elements are hashed with their outline hash
+    //      rather than the index of their definition.
+    u32 runStart = 0;
+    for(u32 i = 0; i < count; i++)
+    {
+        if(elements[i].type == OC_PATH_GLYPH_DEF || elements[i].type == OC_PATH_GLYPH)
+        {
+            hash = oc_hash_xx64_string_seed(oc_str8_from_buffer((i - runStart) * sizeof(oc_path_elt), (char*)(elements + runStart)), hash);
+
+            if(elements[i].type == OC_PATH_GLYPH_DEF)
+            {
+                i += elements[i].glyphDef.count;
+            }
+            else
+            {
+                oc_path_elt glyph = elements[i];
+                glyph.glyph.defIndex = 0;
+                hash = oc_hash_xx64_string_seed(oc_str8_from_buffer(sizeof(oc_path_elt), (char*)&glyph), hash);
+            }
+            runStart = i + 1;
+        }
+    }
+    if(runStart < count)
+    {
+        hash = oc_hash_xx64_string_seed(oc_str8_from_buffer((count - runStart) * sizeof(oc_path_elt), (char*)(elements + runStart)), hash);
+    }
+    return (hash);
+}
+
+static u64 oc_gl_hash_combine(u64 a, u64 b)
+{
+    return (a ^ (b + 0x9e3779b97f4a7c15ULL + (a << 6) + (a >> 2)));
+}
+
+static bool oc_gl_box_in_damage(oc_gl_canvas_backend* backend, oc_vec4 box, f32 scale)
+{
+    //NOTE: box is in points, damage rects are in pixels. Pad by one pixel for antialiasing.
+    oc_vec4 pixelBox = { box.x * scale - 1, box.y * scale - 1, box.z * scale + 1, box.w * scale + 1 };
+
+    for(u32 i = 0; i < backend->damageRectCount; i++)
+    {
+        oc_rect r = backend->damageRects[i];
+        if(pixelBox.x < r.x + r.w
+           && pixelBox.z >= r.x
+           && pixelBox.y < r.y + r.h
+           && pixelBox.w >= r.y)
+        {
+            return (true);
+        }
+    }
+    return (false);
+}
+
+void oc_gl_canvas_compute_damage(oc_gl_canvas_backend* backend,
+                                 oc_color clearColor,
+                                 u32 primitiveCount,
+                                 oc_primitive* primitives,
+                                 u32 eltCount,
+                                 oc_path_elt* pathElements,
+                                 oc_vec4* boxes,
+                                 f32 scale,
+                                 int nTilesX,
+                                 int nTilesY,
+                                 oc_vec2 viewportSize)
+{
+    int tileSize = OC_GL_TILE_SIZE;
+
+    //NOTE: accumulate the hashes of all primitives touching each tile, in submission order
+    memset(backend->tileHashes, 0, backend->tileCount * sizeof(u64));
+
+    for(int primitiveIndex = 0; primitiveIndex < primitiveCount; primitiveIndex++)
+    {
+        oc_primitive* primitive = &primitives[primitiveIndex];
+        boxes[primitiveIndex] = (oc_vec4){ 0, 0, -1, -1 };
+
+        if(!primitive->path.count || primitive->path.startIndex + primitive->path.count > eltCount)
+        {
+            continue;
+        }
+
+        oc_vec4 box = oc_primitive_screen_bounds(primitive, pathElements);
+        boxes[primitiveIndex] = box;
+
+        if(box.x > box.z || box.y > box.w)
+        {
+            continue;
+        }
+
+        u64 hash = oc_gl_primitive_hash(primitive, pathElements + primitive->path.startIndex, primitive->path.count);
+
+        int firstTileX = oc_max(0, (int)floorf((box.x * scale - 1) / tileSize));
+        int firstTileY = oc_max(0, (int)floorf((box.y * scale - 1) / tileSize));
+        int lastTileX = oc_min(nTilesX - 1, (int)floorf((box.z * scale + 1) / tileSize));
+        int lastTileY = oc_min(nTilesY - 1, (int)floorf((box.w * scale + 1) / tileSize));
+
+        for(int y = firstTileY; y <= lastTileY; y++)
+        {
+            for(int x = firstTileX; x <= lastTileX; x++)
+            {
+                u64* tileHash = &backend->tileHashes[y * nTilesX + x];
+                *tileHash = oc_gl_hash_combine(*tileHash, hash);
+            }
+        }
+    }
+
+    bool fullDamage = backend->fullDamage
+                   || clearColor.r != backend->lastClearColor.r
+                   || clearColor.g != backend->lastClearColor.g
+                   || clearColor.b != backend->lastClearColor.b
+                   || clearColor.a != backend->lastClearColor.a;
+
+    //NOTE: coalesce runs of dirty tiles into rects, extending rects of the previous row when the runs line up.
+    //      If we run out of rects, fall back to the bounding box of all dirty tiles.
+    backend->damageRectCount = 0;
+    bool overflow = false;
+    int minX = nTilesX, minY = nTilesY, maxX = -1, maxY = -1;
+
+    for(int y = 0; y < nTilesY; y++)
+    {
+        int x = 0;
+        while(x < nTilesX)
+        {
+            int tileIndex = y * nTilesX + x;
+            if(!fullDamage && backend->tileHashes[tileIndex] == backend->prevTileHashes[tileIndex])
+            {
+                x++;
+                continue;
+            }
+            int start = x;
+            while(x < nTilesX
+                  && (fullDamage || backend->tileHashes[y * nTilesX + x] != backend->prevTileHashes[y * nTilesX + x]))
+            {
+                x++;
+            }
+
+            minX = oc_min(minX, start);
+            maxX = oc_max(maxX, x - 1);
+            minY = oc_min(minY, y);
+            maxY = oc_max(maxY, y);
+
+            oc_rect* rect = 0;
+            for(u32 i = 0; i < backend->damageRectCount; i++)
+            {
+                oc_rect* r = &backend->damageRects[i];
+                if(r->x == start && r->w == x - start && r->y + r->h == y)
+                {
+                    rect = r;
+                    break;
+                }
+            }
+            if(rect)
+            {
+                rect->h += 1;
+            }
+            else if(backend->damageRectCount < OC_GL_MAX_DAMAGE_RECTS)
+            {
+                backend->damageRects[backend->damageRectCount] = (oc_rect){ start, y, x - start, 1 };
+                backend->damageRectCount++;
+            }
+            else
+            {
+                overflow = true;
+            }
+        }
+    }
+    if(overflow)
+    {
+        backend->damageRects[0] = (oc_rect){ minX, minY, maxX - minX + 1, maxY - minY + 1 };
+        backend->damageRectCount = 1;
+    }
+
+    //NOTE: mark dirty tiles for the merge pass and convert rects from tiles to pixels
+    memset(backend->dirtyTiles, 0, backend->tileCount * sizeof(int));
+
+    for(u32 i = 0; i < backend->damageRectCount; i++)
+    {
+        oc_rect* r = &backend->damageRects[i];
+        for(int y = r->y; y < r->y + r->h; y++)
+        {
+            for(int x = r->x; x < r->x + r->w; x++)
+            {
+                backend->dirtyTiles[y * nTilesX + x] = 1;
+            }
+        }
+        r->x *= tileSize;
+        r->y *= tileSize;
+        r->w = oc_min(r->w * tileSize, viewportSize.x - r->x);
+        r->h = oc_min(r->h * tileSize, viewportSize.y - r->y);
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, backend->dirtyTilesBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, backend->tileCount * sizeof(int), backend->dirtyTiles);
+
+    //NOTE: swap hash buffers for next frame
+    u64* tmp = backend->prevTileHashes;
+    backend->prevTileHashes = backend->tileHashes;
+    backend->tileHashes = tmp;
+
+    backend->fullDamage = false;
+    backend->lastClearColor = clearColor;
+}
+
+u32 oc_gl_canvas_get_damage(oc_canvas_backend* interface, u32 maxRectCount, oc_rect* rects)
+{
+    oc_gl_canvas_backend* backend = (oc_gl_canvas_backend*)interface;
+
+    u32 count = 0;
+    if(maxRectCount && backend->damageRectCount)
+    {
+        if(backend->damageRectCount <= maxRectCount)
+        {
+            count = backend->damageRectCount;
+            memcpy(rects, backend->damageRects, count * sizeof(oc_rect));
+        }
+        else
+        {
+            //NOTE: not enough room for all rects, report their bounding box
+            oc_vec4 box = { FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
+            for(u32 i = 0; i < backend->damageRectCount; i++)
+            {
+                oc_rect r = backend->damageRects[i];
+                oc_update_path_extents(&box, (oc_vec2){ r.x, r.y });
+                oc_update_path_extents(&box, (oc_vec2){ r.x + r.w, r.y + r.h });
+            }
+            rects[0] = (oc_rect){ box.x, box.y, box.z - box.x, box.w - box.y };
+            count = 1;
+        }
+    }
+    return (count);
+}
+
 void oc_gl_canvas_render(oc_canvas_backend* interface,
                          oc_color clearColor,
                          u32 primitiveCount,
@@ -1401,13 +2151,39 @@ void oc_gl_canvas_render(oc_canvas_backend* interface,
 
     glViewport(0, 0, viewportSize.x, viewportSize.y);
 
-    //NOTE: clear screen and reset input buffer offsets
+    //NOTE: compute damaged tiles by comparing per-tile primitive hashes with the previous frame
+    oc_arena_scope scratch = oc_scratch_begin();
+    oc_vec4* boxes = oc_arena_push_array(scratch.arena, oc_vec4, primitiveCount);
+
+    oc_gl_canvas_compute_damage(backend,
+                                clearColor,
+                                primitiveCount,
+                                primitives,
+                                eltCount,
+                                pathElements,
+                                boxes,
+                                scale,
+                                nTilesX,
+                                nTilesY,
+                                viewportSize);
+
+    //NOTE: clear damaged regions of the retained output and reset input buffer offsets
+    glBindFramebuffer(GL_FRAMEBUFFER, backend->compositeFramebuffer);
+    glEnable(GL_SCISSOR_TEST);
+    glClearColor(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
+
+    for(u32 i = 0; i < backend->damageRectCount; i++)
+    {
+        //NOTE: damage rects have a top-left origin, and GL framebuffers have a bottom-left origin
+        oc_rect r = backend->damageRects[i];
+        glScissor(r.x, viewportSize.y - (r.y + r.h), r.w, r.h);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+    glDisable(GL_SCISSOR_TEST);
+
     glEnable(GL_BLEND);
     glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
-    glClearColor(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
-    glClear(GL_COLOR_BUFFER_BIT);
-
     backend->pathCount = 0;
     backend->pathBatchStart = 0;
     backend->eltCount = 0;
@@ -1415,16 +2191,64 @@ void oc_gl_canvas_render(oc_canvas_backend* interface,
     backend->maxSegmentCount = 0;
     backend->maxTileQueueCount = 0;
 
-    //NOTE: encode and render batches
-    oc_vec2 currentPos = { 0 };
+    //NOTE: encode the primitives that touch damaged tiles in parallel
+    oc_gl_encode_pool* pool = &backend->encodePool;
+    for(int i = 0; i < OC_GL_ENCODE_WORKER_COUNT + 1; i++)
+    {
+        pool->encoders[i].eltCount = 0;
+    }
+
+    u32* encodeIndices = oc_arena_push_array(scratch.arena, u32, primitiveCount);
+    bool* skipped = oc_arena_push_array(scratch.arena, bool, primitiveCount);
+    u32 encodeCount = 0;
+
+    for(int primitiveIndex = 0; backend->damageRectCount && primitiveIndex < primitiveCount; primitiveIndex++)
+    {
+        oc_primitive* primitive = &primitives[primitiveIndex];
+        skipped[primitiveIndex] = false;
+
+        if(primitive->path.count)
+        {
+            if(oc_gl_box_in_damage(backend, boxes[primitiveIndex], scale))
+            {
+                encodeIndices[encodeCount] = primitiveIndex;
+                encodeCount++;
+            }
+            else
+            {
+                //NOTE: primitive doesn't touch any damaged tile, skip encoding it
+                skipped[primitiveIndex] = true;
+            }
+        }
+    }
+
+    backend->encodedPrimitives = oc_arena_push_array(scratch.arena, oc_gl_encoded_primitive, primitiveCount);
+    backend->pendingCopies = oc_arena_push_array(scratch.arena, oc_gl_element_copy, encodeCount);
+    backend->pendingCopyCount = 0;
+
+    pool->primitiveIndices = encodeIndices;
+    pool->primitives = primitives;
+    pool->boxes = boxes;
+    pool->pathElements = pathElements;
+    pool->eltCount = eltCount;
+    pool->encoded = backend->encodedPrimitives;
+
+    oc_gl_encode_pool_run(pool, OC_GL_ENCODE_JOB_ENCODE, encodeCount);
+
+    //NOTE: assign encoded primitives to batches and render them
     oc_image images[OC_GL_MAX_IMAGES_PER_BATCH] = { 0 };
     int imageCount = 0;
     backend->eltCount = 0;
 
-    for(int primitiveIndex = 0; primitiveIndex < primitiveCount; primitiveIndex++)
+    for(int primitiveIndex = 0; backend->damageRectCount && primitiveIndex < primitiveCount; primitiveIndex++)
     {
         oc_primitive* primitive = &primitives[primitiveIndex];
 
+        if(skipped[primitiveIndex])
+        {
+            continue;
+        }
+
         if(primitive->attributes.image.h != 0)
         {
             backend->currentImageIndex = -1;
@@ -1467,49 +2291,21 @@ void oc_gl_canvas_render(oc_canvas_backend* interface,
 
         if(primitive->path.count)
         {
-            backend->primitive = primitive;
-            backend->pathScreenExtents = (oc_vec4){ FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
-            backend->pathUserExtents = (oc_vec4){ FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
+            //NOTE: reserve a range of the element buffer, the elements are copied when the batch is rendered
+            oc_gl_encoded_primitive* encoded = &backend->encodedPrimitives[primitiveIndex];
 
-            if(primitive->cmd == OC_CMD_STROKE)
-            {
-                oc_gl_encode_stroke(backend, pathElements + primitive->path.startIndex, &primitive->path);
-            }
-            else
-            {
-                int segCount = 0;
-                for(int eltIndex = 0;
-                    (eltIndex < primitive->path.count) && (primitive->path.startIndex + eltIndex < eltCount);
-                    eltIndex++)
-                {
-                    oc_path_elt* elt = &pathElements[primitive->path.startIndex + eltIndex];
-
-                    if(elt->type != OC_PATH_MOVE)
-                    {
-                        oc_vec2 p[4] = { currentPos, elt->p[0], elt->p[1], elt->p[2] };
-                        oc_gl_canvas_encode_element(backend, elt->type, p);
-                        segCount++;
-                    }
-                    switch(elt->type)
-                    {
-                        case OC_PATH_MOVE:
-                            currentPos = elt->p[0];
-                            break;
+            oc_gl_element_copy* copy = &backend->pendingCopies[backend->pendingCopyCount];
+            backend->pendingCopyCount++;
 
-                        case OC_PATH_LINE:
-                            currentPos = elt->p[0];
-                            break;
+            copy->encoded = encoded;
+            copy->dstIndex = backend->eltCount;
+            copy->pathIndex = backend->pathCount - backend->pathBatchStart;
 
-                        case OC_PATH_QUADRATIC:
-                            currentPos = elt->p[1];
-                            break;
+            backend->eltCount += encoded->eltCount;
+            backend->maxSegmentCount += encoded->maxSegmentCount;
+            backend->pathScreenExtents = encoded->pathScreenExtents;
+            backend->pathUserExtents = encoded->pathUserExtents;
 
-                        case OC_PATH_CUBIC:
-                            currentPos = elt->p[2];
-                            break;
-                    }
-                }
-            }
             //NOTE: push path
             oc_gl_canvas_encode_path(backend, primitive, scale);
         }
@@ -1524,6 +2320,18 @@ void oc_gl_canvas_render(oc_canvas_backend* interface,
                        viewportSize,
                        scale);
 
+    oc_scratch_end(scratch);
+
+    //NOTE: copy retained output to the default framebuffer
+    glDisable(GL_BLEND);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, backend->compositeFramebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, viewportSize.x, viewportSize.y,
+                      0, 0, viewportSize.x, viewportSize.y,
+                      GL_COLOR_BUFFER_BIT,
+                      GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
     //NOTE: add fence for rolling input buffers
     backend->bufferSync[backend->bufferIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 }
@@ -1531,7 +2339,7 @@ void oc_gl_canvas_render(oc_canvas_backend* interface,
 //--------------------------------------------------------------------
 // Image API
 //--------------------------------------------------------------------
-oc_image_data* oc_gl_canvas_image_create(oc_canvas_backend* interface, oc_vec2 size)
+oc_image_data* oc_gl_canvas_image_create(oc_canvas_backend* interface, oc_vec2 size, u32 levelCount)
 {
     oc_gl_image* image = 0;
 
@@ -1540,11 +2348,12 @@ oc_image_data* oc_gl_canvas_image_create(oc_canvas_backend* interface, oc_vec2 s
     {
         glGenTextures(1, &image->texture);
         glBindTexture(GL_TEXTURE_2D, image->texture);
-        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, size.x, size.y);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexStorage2D(GL_TEXTURE_2D, levelCount, GL_RGBA8, size.x, size.y);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
         image->interface.size = size;
+        image->interface.levelCount = levelCount;
     }
     return ((oc_image_data*)image);
 }
@@ -1552,9 +2361,13 @@ oc_image_data* oc_gl_canvas_image_create(oc_canvas_backend* interface, oc_vec2 s
 void oc_gl_canvas_image_destroy(oc_canvas_backend* interface, oc_image_data* imageInterface)
 {
     //TODO: check that this image belongs to this backend
+    oc_gl_canvas_backend* backend = (oc_gl_canvas_backend*)interface;
     oc_gl_image* image = (oc_gl_image*)imageInterface;
     glDeleteTextures(1, &image->texture);
     free(image);
+
+    //NOTE: primitive hashes don't capture image contents, so invalidate the retained output
+    backend->fullDamage = true;
 }
 
 void oc_gl_canvas_image_upload_region(oc_canvas_backend* interface,
@@ -1563,9 +2376,18 @@ void oc_gl_canvas_image_upload_region(oc_canvas_backend* interface,
                                       u8* pixels)
 {
     //TODO: check that this image belongs to this backend
+    oc_gl_canvas_backend* backend = (oc_gl_canvas_backend*)interface;
     oc_gl_image* image = (oc_gl_image*)imageInterface;
     glBindTexture(GL_TEXTURE_2D, image->texture);
     glTexSubImage2D(GL_TEXTURE_2D, 0, region.x, region.y, region.w, region.h, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+    if(image->interface.levelCount > 1)
+    {
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+
+    //NOTE: primitive hashes don't capture image contents, so invalidate the retained output
+    backend->fullDamage = true;
 }
 
 //--------------------------------------------------------------------
@@ -1580,6 +2402,11 @@ void oc_gl_canvas_destroy(oc_canvas_backend* interface)
     //TODO
     ////////////////////////////////////////////////////////////////////
 
+    oc_gl_encode_pool_cleanup(&backend->encodePool);
+
+    free(backend->tileHashes);
+    free(backend->prevTileHashes);
+    free(backend->dirtyTiles);
     free(backend);
 }
 
@@ -1703,12 +2530,15 @@ oc_canvas_backend* oc_gl_canvas_backend_create(oc_wgl_surface* surface)
 
         backend->msaaCount = OC_GL_MSAA_COUNT;
 
+        oc_gl_encode_pool_init(&backend->encodePool);
+
         //NOTE(martin): setup interface functions
         backend->interface.destroy = oc_gl_canvas_destroy;
         backend->interface.render = oc_gl_canvas_render;
         backend->interface.imageCreate = oc_gl_canvas_image_create;
         backend->interface.imageDestroy = oc_gl_canvas_image_destroy;
         backend->interface.imageUploadRegion = oc_gl_canvas_image_upload_region;
+        backend->interface.getDamage = oc_gl_canvas_get_damage;
 
         surface->interface.prepare((oc_surface_data*)surface);
 
@@ -1815,6 +2645,9 @@ oc_canvas_backend* oc_gl_canvas_backend_create(oc_wgl_surface* surface)
         glBindBuffer(GL_SHADER_STORAGE_BUFFER, backend->rasterDispatchBuffer);
         glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(oc_gl_dispatch_indirect_command), 0, GL_DYNAMIC_COPY);
 
+        glGenBuffers(1, &backend->dirtyTilesBuffer);
+        oc_gl_canvas_resize_damage_tracking(backend, backend->frameSize);
+
         if(err)
         {
             oc_gl_canvas_destroy((oc_canvas_backend*)backend);
@@ -35,6 +35,7 @@ struct oc_gl_path
     vec4 clip;
     int cmd;
     int textureID;
+    float lod;
 };
 
 struct oc_gl_path_elt
@@ -53,16 +53,30 @@ layout(binding = 6) coherent restrict buffer screenTilesCountBufferSSBO
 
 screenTilesCountBuffer;
 
+layout(binding = 7) restrict readonly buffer dirtyTilesBufferSSBO
+{
+    int elements[];
+}
+
+dirtyTilesBuffer;
+
 layout(location = 0) uniform int tileSize;
 layout(location = 1) uniform float scale;
 layout(location = 2) uniform int pathCount;
 layout(location = 3) uniform int pathBufferStart;
+layout(location = 4) uniform int nTilesX;
 
 void main()
 {
     ivec2 tileCoord = ivec2(gl_WorkGroupID.xy);
     int tileIndex = -1;
 
+    if(dirtyTilesBuffer.elements[tileCoord.y * nTilesX + tileCoord.x] == 0)
+    {
+        //NOTE: tile is unchanged since last frame, keep the retained output
+        return;
+    }
+
     int lastOpIndex = -1;
 
     for(int pathIndex = 0; pathIndex < pathCount; pathIndex++)
@@ -166,6 +166,7 @@ void main()
             int textureID = pathBuffer.elements[pathBufferStart + pathIndex].textureID;
             if(textureID >= 0)
             {
+                float lod = pathBuffer.elements[pathBufferStart + pathIndex].lod;
                 vec4 texColor = vec4(0);
 
                 for(int sampleIndex = 0; sampleIndex < srcSampleCount; sampleIndex++)
@@ -176,35 +177,35 @@ void main()
 
                     if(textureID == 0)
                     {
-                        texColor += texture(srcTexture0, uv);
+                        texColor += textureLod(srcTexture0, uv, lod);
                     }
                     else if(textureID == 1)
                     {
-                        texColor += texture(srcTexture1, uv);
+                        texColor += textureLod(srcTexture1, uv, lod);
                     }
                     else if(textureID == 2)
                     {
-                        texColor += texture(srcTexture2, uv);
+                        texColor += textureLod(srcTexture2, uv, lod);
                     }
                     else if(textureID == 3)
                     {
-                        texColor += texture(srcTexture3, uv);
+                        texColor += textureLod(srcTexture3, uv, lod);
                     }
                     else if(textureID == 4)
                     {
-                        texColor += texture(srcTexture4, uv);
+                        texColor += textureLod(srcTexture4, uv, lod);
                     }
                     else if(textureID == 5)
                     {
-                        texColor += texture(srcTexture5, uv);
+                        texColor += textureLod(srcTexture5, uv, lod);
                     }
                     else if(textureID == 6)
                     {
-                        texColor += texture(srcTexture6, uv);
+                        texColor += textureLod(srcTexture6, uv, lod);
                     }
                     else if(textureID == 7)
                     {
-                        texColor += texture(srcTexture7, uv);
+                        texColor += textureLod(srcTexture7, uv, lod);
                     }
                 }
                 texColor /= srcSampleCount;
@@ -108,6 +108,8 @@ ORCA_API void oc_surface_swap_interval(oc_surface surface, int swap);
 ORCA_API bool oc_surface_get_hidden(oc_surface surface);
 ORCA_API void oc_surface_set_hidden(oc_surface surface, bool hidden);
 
+ORCA_API u32 oc_surface_get_damage(oc_surface surface, u32 maxRectCount, oc_rect* rects); //DOC: gets the regions of the surface (in pixels, top-left origin) that changed during the last render
+
 #else
 
 ORCA_API oc_surface oc_surface_canvas(void); //DOC: creates a surface for use with the canvas API
@@ -210,6 +212,15 @@ typedef struct oc_text_metrics
 
 } oc_text_metrics;
 
+typedef struct oc_canvas_stats
+{
+    u32 primitiveCount;       // number of primitives sent to the surface
+    u32 culledPrimitiveCount; // number of primitives dropped because they were outside their clip or the surface
+    u32 mergedPrimitiveCount; // number of fills merged into the previous primitive as additional subpaths
+    u32 eltCount;             // number of path elements sent to the surface
+
+} oc_canvas_stats;
+
 //------------------------------------------------------------------------------------------
 //SECTION: graphics canvas
 //------------------------------------------------------------------------------------------
@@ -219,7 +230,9 @@ ORCA_API bool oc_canvas_is_nil(oc_canvas canvas); //DOC: true if canvas is nil
 ORCA_API oc_canvas oc_canvas_create(void);             //DOC: create a new canvas
 ORCA_API void oc_canvas_destroy(oc_canvas canvas);     //DOC: destroys canvas
 ORCA_API oc_canvas oc_canvas_select(oc_canvas canvas); //DOC: selects canvas in the current thread
-ORCA_API void oc_render(oc_canvas canvas);             //DOC: renders all canvas commands onto surface
+ORCA_API void oc_render(oc_canvas canvas);             //DOC: renders all canvas commands onto surface, or only updates the canvas stats and discards them if no surface is selected
+
+ORCA_API oc_canvas_stats oc_canvas_get_stats(oc_canvas canvas); //DOC: returns primitive counts of the last call to oc_render()
 
 //------------------------------------------------------------------------------------------
 //SECTION: fonts
@@ -233,6 +246,8 @@ ORCA_API oc_font oc_font_create_from_path(oc_str8 path, u32 rangeCount, oc_unico
 
 ORCA_API void oc_font_destroy(oc_font font);
 
+ORCA_API void oc_font_prefetch_glyphs(oc_font font, u32 rangeCount, oc_unicode_range* ranges); //DOC: loads glyphs of the given ranges ahead of their first use
+
 ORCA_API oc_str32 oc_font_get_glyph_indices(oc_font font, oc_str32 codePoints, oc_str32 backing);
 ORCA_API oc_str32 oc_font_push_glyph_indices(oc_arena* arena, oc_font font, oc_str32 codePoints);
 ORCA_API u32 oc_font_get_glyph_index(oc_font font, oc_utf32 codePoint);
@@ -251,11 +266,22 @@ ORCA_API oc_text_metrics oc_font_text_metrics(oc_font font, f32 fontSize, oc_str
 ORCA_API oc_image oc_image_nil(void);
 ORCA_API bool oc_image_is_nil(oc_image a);
 
+typedef struct oc_image_options
+{
+    bool flip;        // flip rows vertically when decoding
+    bool mipmaps;     // build a mip chain, for images that are drawn at varying scales
+    u32 maxDimension; // if non-zero, decoded images are box-filtered down so that neither side exceeds this
+} oc_image_options;
+
 ORCA_API oc_image oc_image_create(oc_surface surface, u32 width, u32 height);
+ORCA_API oc_image oc_image_create_mipmapped(oc_surface surface, u32 width, u32 height); //DOC: lower levels are regenerated each time level 0 is uploaded
 ORCA_API oc_image oc_image_create_from_rgba8(oc_surface surface, u32 width, u32 height, u8* pixels);
 ORCA_API oc_image oc_image_create_from_memory(oc_surface surface, oc_str8 mem, bool flip);
+ORCA_API oc_image oc_image_create_from_memory_with_options(oc_surface surface, oc_str8 mem, oc_image_options options);
 ORCA_API oc_image oc_image_create_from_file(oc_surface surface, oc_file file, bool flip);
 ORCA_API oc_image oc_image_create_from_path(oc_surface surface, oc_str8 path, bool flip);
+ORCA_API oc_image oc_image_create_from_memory_async(oc_surface surface, oc_str8 mem, bool flip); //DOC: returns a pending image right away and decodes it on a host thread, drawing it does nothing until it is ready
+ORCA_API bool oc_image_is_ready(oc_image image);                                                  //DOC: true once a pending image has been decoded and uploaded
 
 ORCA_API void oc_image_destroy(oc_image image);
 
@@ -272,6 +298,18 @@ typedef struct oc_rect_atlas oc_rect_atlas;
 ORCA_API oc_rect_atlas* oc_rect_atlas_create(oc_arena* arena, i32 width, i32 height);
 ORCA_API oc_rect oc_rect_atlas_alloc(oc_rect_atlas* atlas, i32 width, i32 height);
 ORCA_API void oc_rect_atlas_recycle(oc_rect_atlas* atlas, oc_rect rect);
+ORCA_API void oc_rect_atlas_clear(oc_rect_atlas* atlas);
+
+typedef struct oc_rect_atlas_stats
+{
+    u32 allocCount;
+    u32 freeRectCount;
+    f32 occupancy;     // fraction of the atlas area that is allocated
+    f32 fragmentation; // 1 - largest free rectangle area / total free area
+} oc_rect_atlas_stats;
+
+ORCA_API oc_rect_atlas_stats oc_rect_atlas_get_stats(oc_rect_atlas* atlas);
+ORCA_API u32 oc_rect_atlas_defragment(oc_rect_atlas* atlas, u32 count, oc_rect* rects); //DOC: repacks live rectangles in place and returns how many could be placed, rectangles that couldn't are zeroed
 
 //NOTE: image atlas helpers
 typedef struct oc_image_region
@@ -285,6 +323,11 @@ ORCA_API oc_image_region oc_image_atlas_alloc_from_memory(oc_rect_atlas* atlas,
 ORCA_API oc_image_region oc_image_atlas_alloc_from_file(oc_rect_atlas* atlas, oc_image backingImage, oc_file file, bool flip);
 ORCA_API oc_image_region oc_image_atlas_alloc_from_path(oc_rect_atlas* atlas, oc_image backingImage, oc_str8 path, bool flip);
 ORCA_API void oc_image_atlas_recycle(oc_rect_atlas* atlas, oc_image_region imageRgn);
+ORCA_API u32 oc_image_atlas_defragment(oc_rect_atlas* atlas, u32 count, oc_image_region* regions, u8** pixels); //DOC: repacks image regions and re-uploads their rgba8 pixels
+
+//NOTE: glyph atlas
+ORCA_API void oc_glyph_atlas_enable(oc_surface surface, f32 maxFontSize); //DOC: rasterizes text up to maxFontSize into an atlas image of surface, instead of drawing outlines
+ORCA_API void oc_glyph_atlas_disable(void);
 
 //------------------------------------------------------------------------------------------
 //SECTION: transform, viewport and clipping
@@ -361,6 +404,7 @@ ORCA_API void oc_circle_stroke(f32 x, f32 y, f32 r);
 ORCA_API void oc_arc(f32 x, f32 y, f32 r, f32 arcAngle, f32 startAngle);
 
 ORCA_API void oc_text_fill(f32 x, f32 y, oc_str8 text);
+ORCA_API void oc_codepoints_fill(oc_str32 codePoints); //DOC: fills codepoints starting at the current position
 
 //NOTE: image helpers
 ORCA_API void oc_image_draw(oc_image image, oc_rect rect);
@@ -14,8 +14,13 @@
 #if OC_PLATFORM_ORCA
     #define STBI_NO_STDIO
     #define STBI_NO_HDR
+#else
+    //NOTE: the host decodes images on several threads, and this version of stb_image stores its failure
+    //      reason in an unprotected global, so we don't use failure strings there.
+    #define STBI_NO_FAILURE_STRINGS
 #endif
 #include "stb/stb_image.h"
+#undef STBI_NO_FAILURE_STRINGS
 
 #define STB_TRUETYPE_IMPLEMENTATION
 #include "stb/stb_truetype.h"
@@ -33,10 +38,18 @@ typedef struct oc_glyph_map_entry
 
 typedef struct oc_glyph_data
 {
+    bool loaded;
     bool exists;
     oc_utf32 codePoint;
     oc_path_descriptor pathDescriptor;
+    oc_path_elt* outlines;
     oc_glyph_metrics metrics;
+
+    //NOTE(martin): index of the glyph's outlines definition in the canvas being built, valid if
+    //              defGeneration matches the canvas' current glyph definitions generation
+    u32 defGeneration;
+    u32 defIndex;
+    u32 outlineHash;
     //...
 
 } oc_glyph_data;
@@ -56,13 +69,28 @@ typedef struct oc_font_data
     u32 rangeCount;
     u32 glyphCount;
     u32 outlineCount;
-    oc_glyph_map_entry* glyphMap;
+    oc_glyph_map_entry* glyphMap; // in requested order
+    u32 lookupCount;
+    oc_glyph_map_entry* lookupMap; // sorted by first codepoint, without overlaps
     oc_glyph_data* glyphs;
-    oc_path_elt* outlines;
+
+    //NOTE(martin): glyph outlines and metrics are loaded on first use, so we keep a copy of the
+    //              font file and the stbtt font info around, and store outlines in a per-font arena.
+    oc_str8 fontFile;
+    stbtt_fontinfo stbttFontInfo;
+    oc_arena glyphArena;
+
+    //NOTE(martin): direct lookup table for the Basic Latin and Latin-1 codepoints, and last range hit for the others
+    u32 latin1GlyphIndices[256];
+    u32 lastRangeIndex;
 
     f32 unitsPerEm;
     oc_font_metrics metrics;
 
+    //NOTE(martin): metrics used for codepoints that have no glyph in the font, computed on first use
+    bool missingGlyphMetricsCached;
+    oc_glyph_metrics missingGlyphMetrics;
+
 } oc_font_data;
 
 typedef struct oc_canvas_data oc_canvas_data;
@@ -89,9 +117,72 @@ typedef struct oc_graphics_handle_slot
 
 enum
 {
-    OC_GRAPHICS_HANDLES_MAX_COUNT = 512
+    OC_GRAPHICS_HANDLES_MAX_COUNT = 512,
+    OC_TEXT_METRICS_CACHE_ENTRY_COUNT = 1024,
+    OC_TEXT_METRICS_CACHE_BUCKET_COUNT = 256,
 };
 
+typedef struct oc_text_metrics_cache_entry
+{
+    oc_list_elt lruElt;
+    oc_list_elt bucketElt;
+
+    oc_font font;
+    u64 hash;
+    bool utf32;
+    oc_str8 key; // copy of the text bytes, compared on lookup so that hash collisions are not hits
+    u64 keyCapacity; // size of the key buffer, which is kept when the entry is reused
+    oc_text_metrics metrics; // in font units, scaled by the font size on lookup
+
+} oc_text_metrics_cache_entry;
+
+typedef struct oc_text_metrics_cache
+{
+    oc_text_metrics_cache_entry entries[OC_TEXT_METRICS_CACHE_ENTRY_COUNT];
+    u32 entryNextIndex;
+    oc_list buckets[OC_TEXT_METRICS_CACHE_BUCKET_COUNT];
+    oc_list lru; // most recently used first
+
+} oc_text_metrics_cache;
+
+enum
+{
+    OC_GLYPH_ATLAS_IMAGE_SIZE = 1024,
+    OC_GLYPH_ATLAS_BUCKET_COUNT = 1024,
+    OC_GLYPH_ATLAS_SIZE_STEPS = 4,    // font size buckets per pixel
+    OC_GLYPH_ATLAS_SUBPIXEL_COUNT = 4, // horizontal subpixel offsets per pixel
+};
+
+typedef struct oc_glyph_atlas_entry
+{
+    oc_list_elt listElt;
+
+    oc_font font;
+    u32 glyphIndex;
+    u32 sizeBucket;
+    u32 subpixel;
+
+    oc_rect rect;   // region of the atlas image, empty for glyphs without coverage
+    oc_vec2 offset; // offset of the bitmap's top left corner from the pen position, in pixels, y down
+
+} oc_glyph_atlas_entry;
+
+typedef struct oc_glyph_atlas
+{
+    bool enabled;
+    bool flushRequested;
+    f32 maxFontSize;
+    f32 scaling;
+
+    oc_image image;
+    oc_arena arena;
+    oc_rect_atlas* rectAtlas;
+
+    oc_list freeList;
+    oc_list buckets[OC_GLYPH_ATLAS_BUCKET_COUNT];
+
+} oc_glyph_atlas;
+
 typedef struct oc_graphics_data
 {
     bool init;
@@ -103,6 +194,10 @@ typedef struct oc_graphics_data
     oc_arena resourceArena;
     oc_list canvasFreeList;
     oc_list fontFreeList;
+    u32 glyphDefGeneration;
+
+    oc_text_metrics_cache textMetricsCache;
+    oc_glyph_atlas glyphAtlas;
 
 } oc_graphics_data;
 
@@ -117,6 +212,7 @@ typedef struct oc_canvas_data
     oc_path_descriptor path;
     oc_vec2 subPathStartPoint;
     oc_vec2 subPathLastPoint;
+    bool pathHasOpenSubpath; // a subpath of the current path was left without ending at its start point
 
     oc_mat2x3 matrixStack[OC_MATRIX_STACK_MAX_DEPTH];
     u32 matrixStackSize;
@@ -126,9 +222,20 @@ typedef struct oc_canvas_data
 
     u32 primitiveCount;
     oc_primitive primitives[OC_MAX_PRIMITIVE_COUNT];
+    oc_vec4 primitiveBounds[OC_MAX_PRIMITIVE_COUNT];
+    u32 culledCount;
+    u32 mergedCount;
+    bool lastPrimitiveClosed; // all subpaths of the last primitive end at their start point
+
+    //NOTE(martin): glyph outlines definitions pushed since this generation started can be referenced
+    //              by glyph elements. A new generation starts when the element buffer is reset.
+    u32 glyphDefGeneration;
+    bool pathHasGlyphDefs;
+    bool pathHasGlyphs;
 
     //NOTE: these are used at render time
     oc_color clearColor;
+    oc_canvas_stats stats;
 
     oc_vec4 shapeExtents;
     oc_vec4 shapeScreenExtents;
@@ -197,6 +304,23 @@ void oc_graphics_handle_recycle(u64 h)
     }
 }
 
+void oc_graphics_handle_set_data(u64 h, void* data)
+{
+    OC_DEBUG_ASSERT(oc_graphicsData.init);
+
+    u32 index = h >> 32;
+    u32 generation = h & 0xffffffff;
+
+    if(index < oc_graphicsData.handleNextIndex)
+    {
+        oc_graphics_handle_slot* slot = &oc_graphicsData.handleArray[index];
+        if(slot->generation == generation)
+        {
+            slot->data = data;
+        }
+    }
+}
+
 void* oc_graphics_data_from_handle(oc_graphics_handle_kind kind, u64 h)
 {
     OC_DEBUG_ASSERT(oc_graphicsData.init);
@@ -315,22 +439,223 @@ void oc_clip_stack_pop(oc_canvas_data* canvas)
     }
 }
 
+oc_vec4 oc_primitive_screen_bounds(oc_primitive* primitive, oc_path_elt* elements)
+{
+    //NOTE(martin): compute a conservative bounding box of the primitive in screen space, using the
+    //              control points hull of its path, padded by the stroke width, and transformed
+    oc_vec2 p = primitive->path.startPoint;
+    oc_vec4 box = { p.x, p.y, p.x, p.y };
+
+    for(u32 eltIndex = 0; eltIndex < primitive->path.count; eltIndex++)
+    {
+        oc_path_elt* elt = &elements[primitive->path.startIndex + eltIndex];
+
+        if(elt->type == OC_PATH_GLYPH_DEF)
+        {
+            //NOTE(martin): outlines definitions are in font units and only drawn through glyph elements
+            eltIndex += elt->glyphDef.count;
+            continue;
+        }
+        else if(elt->type == OC_PATH_GLYPH)
+        {
+            oc_path_elt* def = &elements[elt->glyph.defIndex];
+            oc_vec2 p0 = { elt->glyph.origin.x + elt->glyph.scale.x * def->glyphDef.min.x,
+                           elt->glyph.origin.y + elt->glyph.scale.y * def->glyphDef.min.y };
+            oc_vec2 p1 = { elt->glyph.origin.x + elt->glyph.scale.x * def->glyphDef.max.x,
+                           elt->glyph.origin.y + elt->glyph.scale.y * def->glyphDef.max.y };
+
+            box.x = oc_min(box.x, oc_min(p0.x, p1.x));
+            box.y = oc_min(box.y, oc_min(p0.y, p1.y));
+            box.z = oc_max(box.z, oc_max(p0.x, p1.x));
+            box.w = oc_max(box.w, oc_max(p0.y, p1.y));
+            continue;
+        }
+
+        u32 pointCount = (elt->type == OC_PATH_CUBIC) ? 3 : ((elt->type == OC_PATH_QUADRATIC) ? 2 : 1);
+
+        for(u32 i = 0; i < pointCount; i++)
+        {
+            box.x = oc_min(box.x, elt->p[i].x);
+            box.y = oc_min(box.y, elt->p[i].y);
+            box.z = oc_max(box.z, elt->p[i].x);
+            box.w = oc_max(box.w, elt->p[i].y);
+        }
+    }
+
+    if(primitive->cmd == OC_CMD_STROKE)
+    {
+        //NOTE(martin): square caps extend by at most half width * sqrt(2), and miter joints by maxJointExcursion
+        f32 pad = primitive->attributes.width;
+        if(primitive->attributes.joint == OC_JOINT_MITER)
+        {
+            pad += primitive->attributes.maxJointExcursion;
+        }
+        box.x -= pad;
+        box.y -= pad;
+        box.z += pad;
+        box.w += pad;
+    }
+
+    oc_mat2x3 transform = primitive->attributes.transform;
+    oc_vec2 p0 = oc_mat2x3_mul(transform, (oc_vec2){ box.x, box.y });
+    oc_vec2 p1 = oc_mat2x3_mul(transform, (oc_vec2){ box.z, box.y });
+    oc_vec2 p2 = oc_mat2x3_mul(transform, (oc_vec2){ box.z, box.w });
+    oc_vec2 p3 = oc_mat2x3_mul(transform, (oc_vec2){ box.x, box.w });
+
+    oc_vec4 screenBox = {
+        oc_min(p0.x, oc_min(p1.x, oc_min(p2.x, p3.x))),
+        oc_min(p0.y, oc_min(p1.y, oc_min(p2.y, p3.y))),
+        oc_max(p0.x, oc_max(p1.x, oc_max(p2.x, p3.x))),
+        oc_max(p0.y, oc_max(p1.y, oc_max(p2.y, p3.y))),
+    };
+
+    //NOTE(martin): intersect with clip. The result is empty if x > z or y > w
+    oc_rect clip = primitive->attributes.clip;
+    screenBox.x = oc_max(screenBox.x, clip.x);
+    screenBox.y = oc_max(screenBox.y, clip.y);
+    screenBox.z = oc_min(screenBox.z, clip.x + clip.w);
+    screenBox.w = oc_min(screenBox.w, clip.y + clip.h);
+
+    return (screenBox);
+}
+
+f32 oc_primitive_stroke_tolerance(oc_primitive* primitive, oc_vec4 screenBounds)
+{
+    //NOTE(martin): the tolerance attribute is in surface points, but strokes are offset in user space, so we divide
+    //              it by the largest scaling factor of the transform. This cuts subdivision of content drawn small,
+    //              and keeps zoomed-in content within tolerance on screen. Primitives whose screen extents are
+    //              smaller than the tolerance can't show any flattening error, so they get the loosest tolerance.
+    //              The offset check compares squared distances, which can't resolve a tolerance that is too small
+    //              relative to the width in f32, so we clamp it to a fraction of the width.
+    oc_attributes* attributes = &primitive->attributes;
+    f32 maxTolerance = 0.5 * attributes->width;
+    f32 minTolerance = 1e-3 * attributes->width;
+
+    oc_mat2x3 m = attributes->transform;
+    f32 scale = sqrtf(oc_max(oc_square(m.m[0]) + oc_square(m.m[3]),
+                             oc_square(m.m[1]) + oc_square(m.m[4])));
+
+    f32 extents = oc_max(screenBounds.z - screenBounds.x, screenBounds.w - screenBounds.y);
+
+    f32 tolerance = maxTolerance;
+    if(scale > 0 && extents >= attributes->tolerance)
+    {
+        tolerance = oc_clamp(attributes->tolerance / scale, minTolerance, maxTolerance);
+    }
+    return (tolerance);
+}
+
+static void oc_path_check_open_subpath(oc_canvas_data* canvas)
+{
+    //NOTE(martin): called before the current subpath is ended by a new one or by pushing the path
+    if(canvas->subPathStartPoint.x != canvas->subPathLastPoint.x
+       || canvas->subPathStartPoint.y != canvas->subPathLastPoint.y)
+    {
+        canvas->pathHasOpenSubpath = true;
+    }
+}
+
+static bool oc_primitive_try_merge(oc_canvas_data* canvas, oc_primitive* primitive, oc_vec4 bounds, bool closed)
+{
+    //NOTE(martin): merge a fill into the previous primitive when it would render identically as one more subpath
+    //              of that primitive. This requires:
+    //              - both to be untextured fills with the same color, transform and clip. Textured fills are
+    //                excluded because backends map the image onto the extents of the whole path,
+    //              - their elements to be contiguous, and the new path to start with a move or a glyph, so that
+    //                it doesn't implicitly continue from the end of the previous one,
+    //              - their bounds not to overlap, so that neither blending nor winding can interact,
+    //              - all subpaths of both paths to be closed. Backends don't close subpaths implicitly, and
+    //                the winding spill of an open subpath is only bounded by the bounds of its whole path,
+    //                which would grow to cover the gap between the two.
+    if(!canvas->primitiveCount || primitive->cmd != OC_CMD_FILL || !primitive->path.count
+       || !closed || !canvas->lastPrimitiveClosed)
+    {
+        return (false);
+    }
+
+    oc_primitive* prev = &canvas->primitives[canvas->primitiveCount - 1];
+    oc_vec4* prevBounds = &canvas->primitiveBounds[canvas->primitiveCount - 1];
+
+    oc_attributes* a = &prev->attributes;
+    oc_attributes* b = &primitive->attributes;
+
+    oc_path_elt_type firstType = canvas->pathElements[primitive->path.startIndex].type;
+
+    if(prev->cmd != OC_CMD_FILL
+       || prev->path.startIndex + prev->path.count != primitive->path.startIndex
+       || (firstType != OC_PATH_MOVE && firstType != OC_PATH_GLYPH && firstType != OC_PATH_GLYPH_DEF)
+       || !oc_image_is_nil(a->image)
+       || !oc_image_is_nil(b->image)
+       || memcmp(&a->color, &b->color, sizeof(oc_color))
+       || memcmp(&a->transform, &b->transform, sizeof(oc_mat2x3))
+       || memcmp(&a->clip, &b->clip, sizeof(oc_rect)))
+    {
+        return (false);
+    }
+
+    if(bounds.x < prevBounds->z
+       && prevBounds->x < bounds.z
+       && bounds.y < prevBounds->w
+       && prevBounds->y < bounds.w)
+    {
+        return (false);
+    }
+
+    prev->path.count += primitive->path.count;
+
+    prevBounds->x = oc_min(prevBounds->x, bounds.x);
+    prevBounds->y = oc_min(prevBounds->y, bounds.y);
+    prevBounds->z = oc_max(prevBounds->z, bounds.z);
+    prevBounds->w = oc_max(prevBounds->w, bounds.w);
+
+    return (true);
+}
+
 void oc_push_command(oc_canvas_data* canvas, oc_primitive primitive)
 {
     //NOTE(martin): push primitive and updates current stream, eventually patching a pending jump.
     OC_ASSERT(canvas->primitiveCount < OC_MAX_PRIMITIVE_COUNT);
 
-    canvas->primitives[canvas->primitiveCount] = primitive;
-    canvas->primitives[canvas->primitiveCount].attributes = canvas->attributes;
-    canvas->primitives[canvas->primitiveCount].attributes.transform = oc_matrix_stack_top(canvas);
-    canvas->primitives[canvas->primitiveCount].attributes.clip = oc_clip_stack_top(canvas);
-    canvas->primitiveCount++;
+    primitive.attributes = canvas->attributes;
+    primitive.attributes.transform = oc_matrix_stack_top(canvas);
+    primitive.attributes.clip = oc_clip_stack_top(canvas);
+
+    oc_vec4 bounds = oc_primitive_screen_bounds(&primitive, canvas->pathElements);
+
+    oc_path_check_open_subpath(canvas);
+    bool closed = !canvas->pathHasOpenSubpath;
+
+    if(bounds.x > bounds.z || bounds.y > bounds.w)
+    {
+        //NOTE(martin): primitive is entirely outside its clip, drop it and reclaim its path elements,
+        //              unless they hold glyph outlines that later glyph elements may reference
+        if(!canvas->pathHasGlyphDefs)
+        {
+            canvas->path.count = 0;
+        }
+        canvas->culledCount++;
+    }
+    else if(oc_primitive_try_merge(canvas, &primitive, bounds, closed))
+    {
+        canvas->mergedCount++;
+        canvas->lastPrimitiveClosed = closed;
+    }
+    else
+    {
+        canvas->primitives[canvas->primitiveCount] = primitive;
+        canvas->primitiveBounds[canvas->primitiveCount] = bounds;
+        canvas->primitiveCount++;
+        canvas->lastPrimitiveClosed = closed;
+    }
 }
 
 void oc_new_path(oc_canvas_data* canvas)
 {
     canvas->path.startIndex += canvas->path.count;
     canvas->path.count = 0;
+    canvas->pathHasGlyphDefs = false;
+    canvas->pathHasGlyphs = false;
+    canvas->pathHasOpenSubpath = false;
     canvas->subPathStartPoint = canvas->subPathLastPoint;
     canvas->path.startPoint = canvas->subPathStartPoint;
 }
@@ -369,6 +694,354 @@ oc_font_data* oc_font_data_from_handle(oc_font handle)
     return (data);
 }
 
+//------------------------------------------------------------------------------------------
+//NOTE(martin): text metrics cache
+//------------------------------------------------------------------------------------------
+
+//NOTE(martin): the cache stores unscaled metrics keyed by font and text bytes, so that the same string
+//              measured at different sizes shares a single entry. Entries are bucketed by the xxh64 of
+//              the bytes, but lookups also compare the bytes themselves. Least recently used entries are
+//              evicted when the cache is full.
+
+oc_text_metrics_cache_entry* oc_text_metrics_cache_find(oc_font font, u64 hash, bool utf32, oc_str8 key)
+{
+    oc_text_metrics_cache* cache = &oc_graphicsData.textMetricsCache;
+    oc_list* bucket = &cache->buckets[hash % OC_TEXT_METRICS_CACHE_BUCKET_COUNT];
+
+    oc_list_for(*bucket, entry, oc_text_metrics_cache_entry, bucketElt)
+    {
+        if(entry->hash == hash
+           && entry->font.h == font.h
+           && entry->utf32 == utf32
+           && entry->key.len == key.len
+           && !memcmp(entry->key.ptr, key.ptr, key.len))
+        {
+            //NOTE(martin): move entry to the front of the lru list
+            oc_list_remove(&cache->lru, &entry->lruElt);
+            oc_list_push(&cache->lru, &entry->lruElt);
+            return (entry);
+        }
+    }
+    return (0);
+}
+
+void oc_text_metrics_cache_insert(oc_font font, u64 hash, bool utf32, oc_str8 key, oc_text_metrics* metrics)
+{
+    oc_text_metrics_cache* cache = &oc_graphicsData.textMetricsCache;
+    oc_text_metrics_cache_entry* entry = 0;
+
+    if(cache->entryNextIndex < OC_TEXT_METRICS_CACHE_ENTRY_COUNT)
+    {
+        entry = &cache->entries[cache->entryNextIndex];
+        cache->entryNextIndex++;
+    }
+    else
+    {
+        //NOTE(martin): evict the least recently used entry
+        entry = oc_list_last_entry(cache->lru, oc_text_metrics_cache_entry, lruElt);
+        oc_list_remove(&cache->lru, &entry->lruElt);
+        oc_list_remove(&cache->buckets[entry->hash % OC_TEXT_METRICS_CACHE_BUCKET_COUNT], &entry->bucketElt);
+    }
+
+    if(entry->keyCapacity < key.len)
+    {
+        char* keyBuffer = realloc(entry->key.ptr, key.len);
+        if(!keyBuffer)
+        {
+            //NOTE(martin): leave the entry empty and at the end of the lru list, so that it gets reused first
+            entry->font = oc_font_nil();
+            entry->key.len = 0;
+            oc_list_push_back(&cache->lru, &entry->lruElt);
+            oc_list_push(&cache->buckets[entry->hash % OC_TEXT_METRICS_CACHE_BUCKET_COUNT], &entry->bucketElt);
+            return;
+        }
+        entry->key.ptr = keyBuffer;
+        entry->keyCapacity = key.len;
+    }
+    memcpy(entry->key.ptr, key.ptr, key.len);
+    entry->key.len = key.len;
+
+    entry->font = font;
+    entry->hash = hash;
+    entry->utf32 = utf32;
+    entry->metrics = *metrics;
+
+    oc_list_push(&cache->lru, &entry->lruElt);
+    oc_list_push(&cache->buckets[hash % OC_TEXT_METRICS_CACHE_BUCKET_COUNT], &entry->bucketElt);
+}
+
+void oc_text_metrics_cache_purge_font(oc_font font)
+{
+    oc_text_metrics_cache* cache = &oc_graphicsData.textMetricsCache;
+
+    oc_list_for_safe(cache->lru, entry, oc_text_metrics_cache_entry, lruElt)
+    {
+        if(entry->font.h == font.h)
+        {
+            oc_list_remove(&cache->lru, &entry->lruElt);
+            oc_list_remove(&cache->buckets[entry->hash % OC_TEXT_METRICS_CACHE_BUCKET_COUNT], &entry->bucketElt);
+
+            //NOTE(martin): move the entry to the end of the lru list so that it gets reused first
+            entry->font = oc_font_nil();
+            oc_list_push_back(&cache->lru, &entry->lruElt);
+            oc_list_push(&cache->buckets[entry->hash % OC_TEXT_METRICS_CACHE_BUCKET_COUNT], &entry->bucketElt);
+        }
+    }
+}
+
+oc_text_metrics oc_text_metrics_scale(oc_text_metrics metrics, f32 fontScale)
+{
+    metrics.ink.x *= fontScale;
+    metrics.ink.y *= fontScale;
+    metrics.ink.w *= fontScale;
+    metrics.ink.h *= fontScale;
+    metrics.logical.x *= fontScale;
+    metrics.logical.y *= fontScale;
+    metrics.logical.w *= fontScale;
+    metrics.logical.h *= fontScale;
+    metrics.advance.x *= fontScale;
+    metrics.advance.y *= fontScale;
+    return (metrics);
+}
+
+//------------------------------------------------------------------------------------------
+//NOTE(martin): glyph atlas
+//------------------------------------------------------------------------------------------
+
+//NOTE(martin): when enabled, small text drawn with an untransformed or translated matrix is rasterized
+//              once per (font, size bucket, subpixel offset) into an atlas image, and drawn as textured
+//              quads instead of vector outlines.
+
+void oc_glyph_atlas_disable(void)
+{
+    oc_glyph_atlas* atlas = &oc_graphicsData.glyphAtlas;
+    if(atlas->enabled)
+    {
+        oc_image_destroy(atlas->image);
+        oc_arena_cleanup(&atlas->arena);
+        memset(atlas, 0, sizeof(oc_glyph_atlas));
+    }
+}
+
+void oc_glyph_atlas_enable(oc_surface surface, f32 maxFontSize)
+{
+    oc_glyph_atlas_disable();
+
+    oc_glyph_atlas* atlas = &oc_graphicsData.glyphAtlas;
+
+    atlas->image = oc_image_create(surface, OC_GLYPH_ATLAS_IMAGE_SIZE, OC_GLYPH_ATLAS_IMAGE_SIZE);
+    if(oc_image_is_nil(atlas->image))
+    {
+        oc_log_error("couldn't create glyph atlas image\n");
+        return;
+    }
+
+    oc_arena_init(&atlas->arena);
+    atlas->rectAtlas = oc_rect_atlas_create(&atlas->arena, OC_GLYPH_ATLAS_IMAGE_SIZE, OC_GLYPH_ATLAS_IMAGE_SIZE);
+    atlas->maxFontSize = maxFontSize;
+    atlas->scaling = oc_surface_contents_scaling(surface).x;
+    atlas->enabled = true;
+}
+
+u32 oc_glyph_atlas_bucket_index(oc_font font, u32 glyphIndex, u32 sizeBucket, u32 subpixel)
+{
+    u64 key = font.h * 0x9e3779b97f4a7c15ULL
+            ^ ((u64)glyphIndex << 16)
+            ^ ((u64)sizeBucket << 3)
+            ^ subpixel;
+
+    return ((key ^ (key >> 29)) % OC_GLYPH_ATLAS_BUCKET_COUNT);
+}
+
+void oc_glyph_atlas_purge_font(oc_font font)
+{
+    oc_glyph_atlas* atlas = &oc_graphicsData.glyphAtlas;
+    if(atlas->enabled)
+    {
+        for(int bucketIndex = 0; bucketIndex < OC_GLYPH_ATLAS_BUCKET_COUNT; bucketIndex++)
+        {
+            oc_list_for_safe(atlas->buckets[bucketIndex], entry, oc_glyph_atlas_entry, listElt)
+            {
+                if(entry->font.h == font.h)
+                {
+                    oc_list_remove(&atlas->buckets[bucketIndex], &entry->listElt);
+                    if(entry->rect.w)
+                    {
+                        oc_rect_atlas_recycle(atlas->rectAtlas, entry->rect);
+                    }
+                    oc_list_push(&atlas->freeList, &entry->listElt);
+                }
+            }
+        }
+    }
+}
+
+void oc_glyph_atlas_flush(void)
+{
+    //NOTE(martin): evict all glyphs and reset the rect atlas, glyphs in use get rasterized again
+    //              into a compact layout on their next use
+    oc_glyph_atlas* atlas = &oc_graphicsData.glyphAtlas;
+    for(int bucketIndex = 0; bucketIndex < OC_GLYPH_ATLAS_BUCKET_COUNT; bucketIndex++)
+    {
+        oc_list_for_safe(atlas->buckets[bucketIndex], entry, oc_glyph_atlas_entry, listElt)
+        {
+            oc_list_remove(&atlas->buckets[bucketIndex], &entry->listElt);
+            oc_list_push(&atlas->freeList, &entry->listElt);
+        }
+    }
+    oc_rect_atlas_clear(atlas->rectAtlas);
+    atlas->flushRequested = false;
+}
+
+oc_glyph_atlas_entry* oc_glyph_atlas_find(oc_font font, u32 glyphIndex, u32 sizeBucket, u32 subpixel)
+{
+    oc_glyph_atlas* atlas = &oc_graphicsData.glyphAtlas;
+    u32 bucketIndex = oc_glyph_atlas_bucket_index(font, glyphIndex, sizeBucket, subpixel);
+
+    oc_list_for(atlas->buckets[bucketIndex], entry, oc_glyph_atlas_entry, listElt)
+    {
+        if(entry->font.h == font.h
+           && entry->glyphIndex == glyphIndex
+           && entry->sizeBucket == sizeBucket
+           && entry->subpixel == subpixel)
+        {
+            return (entry);
+        }
+    }
+    return (0);
+}
+
+oc_glyph_atlas_entry* oc_glyph_atlas_rasterize(oc_font font,
+                                               oc_font_data* fontData,
+                                               u32 glyphIndex,
+                                               oc_glyph_data* glyph,
+                                               u32 sizeBucket,
+                                               u32 subpixel)
+{
+    oc_glyph_atlas* atlas = &oc_graphicsData.glyphAtlas;
+
+    stbtt_fontinfo* stbttFontInfo = &fontData->stbttFontInfo;
+    int stbttGlyphIndex = stbtt_FindGlyphIndex(stbttFontInfo, glyph->codePoint);
+
+    f32 scale = (f32)sizeBucket / OC_GLYPH_ATLAS_SIZE_STEPS / fontData->unitsPerEm;
+    f32 shiftX = (f32)subpixel / OC_GLYPH_ATLAS_SUBPIXEL_COUNT;
+
+    int x0, y0, x1, y1;
+    stbtt_GetGlyphBitmapBoxSubpixel(stbttFontInfo, stbttGlyphIndex, scale, scale, shiftX, 0, &x0, &y0, &x1, &y1);
+
+    int width = x1 - x0;
+    int height = y1 - y0;
+
+    oc_rect rect = { 0 };
+    if(width > 0 && height > 0)
+    {
+        rect = oc_rect_atlas_alloc(atlas->rectAtlas, width, height);
+        if(rect.w != width || rect.h != height)
+        {
+            //NOTE(martin): atlas is full, the caller falls back to outlines. Glyphs already drawn this frame
+            //              still reference the atlas, so we defer repacking until the frame is rendered.
+            atlas->flushRequested = true;
+            return (0);
+        }
+
+        oc_arena_scope scratch = oc_scratch_begin();
+
+        u8* coverage = oc_arena_push_array(scratch.arena, u8, width * height);
+        stbtt_MakeGlyphBitmapSubpixel(stbttFontInfo, coverage, width, height, width, scale, scale, shiftX, 0, stbttGlyphIndex);
+
+        //NOTE(martin): store coverage in the alpha channel of a white image, so that the fill color tints it
+        u8* pixels = oc_arena_push_array(scratch.arena, u8, width * height * 4);
+        for(int i = 0; i < width * height; i++)
+        {
+            pixels[4 * i] = 255;
+            pixels[4 * i + 1] = 255;
+            pixels[4 * i + 2] = 255;
+            pixels[4 * i + 3] = coverage[i];
+        }
+        oc_image_upload_region_rgba8(atlas->image, rect, pixels);
+
+        oc_scratch_end(scratch);
+    }
+
+    oc_glyph_atlas_entry* entry = oc_list_pop_entry(&atlas->freeList, oc_glyph_atlas_entry, listElt);
+    if(!entry)
+    {
+        entry = oc_arena_push_type(&atlas->arena, oc_glyph_atlas_entry);
+    }
+    entry->font = font;
+    entry->glyphIndex = glyphIndex;
+    entry->sizeBucket = sizeBucket;
+    entry->subpixel = subpixel;
+    entry->rect = rect;
+    entry->offset = (oc_vec2){ x0, y0 };
+
+    u32 bucketIndex = oc_glyph_atlas_bucket_index(font, glyphIndex, sizeBucket, subpixel);
+    oc_list_push(&atlas->buckets[bucketIndex], &entry->listElt);
+
+    return (entry);
+}
+
+static void oc_font_build_lookup_map(oc_font_data* font)
+{
+    //NOTE(martin): build a map sorted by first codepoint, so that glyph lookups can do a binary search. Ranges can
+    //              overlap, in which case a codepoint maps to the first range that contains it, in the requested
+    //              order. So we add ranges in that order, only keeping the parts that aren't covered by previous
+    //              ranges. This doesn't change glyph indices, which were assigned in the requested order.
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    oc_glyph_map_entry* map = 0;
+    u32 count = 0;
+
+    for(int rangeIndex = 0; rangeIndex < font->rangeCount; rangeIndex++)
+    {
+        oc_glyph_map_entry* entry = &font->glyphMap[rangeIndex];
+        u64 first = entry->range.firstCodePoint;
+        u64 end = first + entry->range.count;
+
+        //NOTE(martin): a range adds at most one more piece than the number of pieces already in the map
+        oc_glyph_map_entry* newMap = oc_arena_push_array(scratch.arena, oc_glyph_map_entry, 2 * count + 1);
+        u32 newCount = 0;
+
+        u64 cursor = first;
+        for(int i = 0; i < count; i++)
+        {
+            u64 pieceFirst = map[i].range.firstCodePoint;
+            u64 pieceEnd = pieceFirst + map[i].range.count;
+
+            if(cursor < end && pieceFirst > cursor)
+            {
+                //NOTE(martin): add the uncovered part of the range before this piece
+                u64 gapEnd = oc_min(pieceFirst, end);
+                newMap[newCount] = (oc_glyph_map_entry){
+                    .range = { .firstCodePoint = cursor, .count = gapEnd - cursor },
+                    .firstGlyphIndex = entry->firstGlyphIndex + cursor - first,
+                };
+                newCount++;
+            }
+            cursor = oc_max(cursor, pieceEnd);
+
+            newMap[newCount] = map[i];
+            newCount++;
+        }
+        if(cursor < end)
+        {
+            newMap[newCount] = (oc_glyph_map_entry){
+                .range = { .firstCodePoint = cursor, .count = end - cursor },
+                .firstGlyphIndex = entry->firstGlyphIndex + cursor - first,
+            };
+            newCount++;
+        }
+        map = newMap;
+        count = newCount;
+    }
+
+    font->lookupCount = count;
+    font->lookupMap = oc_malloc_array(oc_glyph_map_entry, oc_max(count, 1));
+    memcpy(font->lookupMap, map, count * sizeof(oc_glyph_map_entry));
+
+    oc_scratch_end(scratch);
+}
+
 oc_font oc_font_create_from_memory(oc_str8 mem, u32 rangeCount, oc_unicode_range* ranges)
 {
     if(!oc_graphicsData.init)
@@ -377,35 +1050,49 @@ oc_font oc_font_create_from_memory(oc_str8 mem, u32 rangeCount, oc_unicode_range
     }
     oc_font fontHandle = oc_font_nil();
 
+    oc_arena glyphArena = { 0 };
     oc_font_data* font = oc_list_pop_entry(&oc_graphicsData.fontFreeList, oc_font_data, freeListElt);
-    if(!font)
+    if(font)
+    {
+        //NOTE(martin): reuse the glyph arena of the recycled font
+        glyphArena = font->glyphArena;
+        oc_arena_clear(&glyphArena);
+    }
+    else
     {
         font = oc_arena_push_type(&oc_graphicsData.resourceArena, oc_font_data);
+        oc_arena_init_with_options(&glyphArena, &(oc_arena_options){ .reserve = 64 << 10 });
     }
     if(font)
     {
         memset(font, 0, sizeof(oc_font_data));
+        font->glyphArena = glyphArena;
         fontHandle = oc_font_handle_alloc(font);
 
-        stbtt_fontinfo stbttFontInfo;
-        stbtt_InitFont(&stbttFontInfo, (byte*)mem.ptr, 0);
+        //NOTE(martin): keep a copy of the font file, since glyphs are loaded lazily
+        font->fontFile.ptr = oc_malloc_array(char, mem.len);
+        font->fontFile.len = mem.len;
+        memcpy(font->fontFile.ptr, mem.ptr, mem.len);
+
+        stbtt_fontinfo* stbttFontInfo = &font->stbttFontInfo;
+        stbtt_InitFont(stbttFontInfo, (byte*)font->fontFile.ptr, 0);
 
         //NOTE(martin): load font metrics data
-        font->unitsPerEm = 1. / stbtt_ScaleForMappingEmToPixels(&stbttFontInfo, 1);
+        font->unitsPerEm = 1. / stbtt_ScaleForMappingEmToPixels(stbttFontInfo, 1);
 
         int ascent, descent, lineGap, x0, x1, y0, y1;
-        stbtt_GetFontVMetrics(&stbttFontInfo, &ascent, &descent, &lineGap);
-        stbtt_GetFontBoundingBox(&stbttFontInfo, &x0, &y0, &x1, &y1);
+        stbtt_GetFontVMetrics(stbttFontInfo, &ascent, &descent, &lineGap);
+        stbtt_GetFontBoundingBox(stbttFontInfo, &x0, &y0, &x1, &y1);
 
         font->metrics.ascent = ascent;
         font->metrics.descent = -descent;
         font->metrics.lineGap = lineGap;
         font->metrics.width = x1 - x0;
 
-        stbtt_GetCodepointBox(&stbttFontInfo, 'x', &x0, &y0, &x1, &y1);
+        stbtt_GetCodepointBox(stbttFontInfo, 'x', &x0, &y0, &x1, &y1);
         font->metrics.xHeight = y1 - y0;
 
-        stbtt_GetCodepointBox(&stbttFontInfo, 'M', &x0, &y0, &x1, &y1);
+        stbtt_GetCodepointBox(stbttFontInfo, 'M', &x0, &y0, &x1, &y1);
         font->metrics.capHeight = y1 - y0;
 
         //NOTE(martin): load codepoint ranges
@@ -422,132 +1109,23 @@ oc_font oc_font_create_from_memory(oc_str8 mem, u32 rangeCount, oc_unicode_range
             font->glyphCount += ranges[i].count;
         }
 
-        font->glyphs = oc_malloc_array(oc_glyph_data, font->glyphCount);
+        oc_font_build_lookup_map(font);
 
-        //NOTE(martin): first do a count of outlines
-        int outlineCount = 0;
-        for(int rangeIndex = 0; rangeIndex < rangeCount; rangeIndex++)
+        //NOTE(martin): build the Latin-1 direct lookup table
+        for(int i = 0; i < font->lookupCount; i++)
         {
-            oc_utf32 codePoint = font->glyphMap[rangeIndex].range.firstCodePoint;
-            u32 firstGlyphIndex = font->glyphMap[rangeIndex].firstGlyphIndex;
-            u32 endGlyphIndex = firstGlyphIndex + font->glyphMap[rangeIndex].range.count;
-
-            for(int glyphIndex = firstGlyphIndex;
-                glyphIndex < endGlyphIndex; glyphIndex++)
+            oc_glyph_map_entry* entry = &font->lookupMap[i];
+            for(u32 codePoint = entry->range.firstCodePoint;
+                codePoint < 256 && codePoint - entry->range.firstCodePoint < entry->range.count;
+                codePoint++)
             {
-                int stbttGlyphIndex = stbtt_FindGlyphIndex(&stbttFontInfo, codePoint);
-                if(stbttGlyphIndex == 0)
-                {
-                    //NOTE(martin): the codepoint is not found in the font
-                    codePoint++;
-                    continue;
-                }
-                //NOTE(martin): load glyph outlines
-                stbtt_vertex* vertices = 0;
-                outlineCount += stbtt_GetGlyphShape(&stbttFontInfo, stbttGlyphIndex, &vertices);
-                stbtt_FreeShape(&stbttFontInfo, vertices);
-                codePoint++;
+                font->latin1GlyphIndices[codePoint] = entry->firstGlyphIndex + codePoint - entry->range.firstCodePoint;
             }
         }
-        //NOTE(martin): allocate outlines
-        font->outlines = oc_malloc_array(oc_path_elt, outlineCount);
-        font->outlineCount = 0;
-
-        //NOTE(martin): load metrics and outlines
-        for(int rangeIndex = 0; rangeIndex < rangeCount; rangeIndex++)
-        {
-            oc_utf32 codePoint = font->glyphMap[rangeIndex].range.firstCodePoint;
-            u32 firstGlyphIndex = font->glyphMap[rangeIndex].firstGlyphIndex;
-            u32 endGlyphIndex = firstGlyphIndex + font->glyphMap[rangeIndex].range.count;
-
-            for(int glyphIndex = firstGlyphIndex;
-                glyphIndex < endGlyphIndex; glyphIndex++)
-            {
-                oc_glyph_data* glyph = &(font->glyphs[glyphIndex - 1]);
-
-                int stbttGlyphIndex = stbtt_FindGlyphIndex(&stbttFontInfo, codePoint);
-                if(stbttGlyphIndex == 0)
-                {
-                    //NOTE(martin): the codepoint is not found in the font, we zero the glyph info
-                    memset(glyph, 0, sizeof(*glyph));
-                    codePoint++;
-                    continue;
-                }
-
-                glyph->exists = true;
-                glyph->codePoint = codePoint;
-
-                //NOTE(martin): load glyph metric
-                int xAdvance, xBearing, x0, y0, x1, y1;
-                stbtt_GetGlyphHMetrics(&stbttFontInfo, stbttGlyphIndex, &xAdvance, &xBearing);
-                stbtt_GetGlyphBox(&stbttFontInfo, stbttGlyphIndex, &x0, &y0, &x1, &y1);
-
-                //NOTE(martin): stb stbtt_GetGlyphBox returns bottom left and top right corners, with y up,
-                //              so we have to set .y = -y1
-                glyph->metrics.ink = (oc_rect){
-                    .x = x0,
-                    .y = -y1,
-                    .w = x1 - x0,
-                    .h = y1 - y0
-                };
-
-                glyph->metrics.advance = (oc_vec2){ xAdvance, 0 };
 
-                //NOTE(martin): load glyph outlines
-
-                stbtt_vertex* vertices = 0;
-                int vertexCount = stbtt_GetGlyphShape(&stbttFontInfo, stbttGlyphIndex, &vertices);
-
-                glyph->pathDescriptor = (oc_path_descriptor){ .startIndex = font->outlineCount,
-                                                              .count = vertexCount,
-                                                              .startPoint = { 0, 0 } };
-
-                oc_path_elt* elements = font->outlines + font->outlineCount;
-                font->outlineCount += vertexCount;
-                oc_vec2 currentPos = { 0, 0 };
-
-                for(int vertIndex = 0; vertIndex < vertexCount; vertIndex++)
-                {
-                    f32 x = vertices[vertIndex].x;
-                    f32 y = vertices[vertIndex].y;
-                    f32 cx = vertices[vertIndex].cx;
-                    f32 cy = vertices[vertIndex].cy;
-                    f32 cx1 = vertices[vertIndex].cx1;
-                    f32 cy1 = vertices[vertIndex].cy1;
-
-                    switch(vertices[vertIndex].type)
-                    {
-                        case STBTT_vmove:
-                            elements[vertIndex].type = OC_PATH_MOVE;
-                            elements[vertIndex].p[0] = (oc_vec2){ x, y };
-                            break;
-
-                        case STBTT_vline:
-                            elements[vertIndex].type = OC_PATH_LINE;
-                            elements[vertIndex].p[0] = (oc_vec2){ x, y };
-                            break;
-
-                        case STBTT_vcurve:
-                        {
-                            elements[vertIndex].type = OC_PATH_QUADRATIC;
-                            elements[vertIndex].p[0] = (oc_vec2){ cx, cy };
-                            elements[vertIndex].p[1] = (oc_vec2){ x, y };
-                        }
-                        break;
-
-                        case STBTT_vcubic:
-                            elements[vertIndex].type = OC_PATH_CUBIC;
-                            elements[vertIndex].p[0] = (oc_vec2){ cx, cy };
-                            elements[vertIndex].p[1] = (oc_vec2){ cx1, cy1 };
-                            elements[vertIndex].p[2] = (oc_vec2){ x, y };
-                            break;
-                    }
-                    currentPos = (oc_vec2){ x, y };
-                }
-                stbtt_FreeShape(&stbttFontInfo, vertices);
-                codePoint++;
-            }
-        }
+        //NOTE(martin): glyphs are zeroed here, and their outlines and metrics are loaded on first use
+        font->glyphs = oc_malloc_array(oc_glyph_data, font->glyphCount);
+        memset(font->glyphs, 0, font->glyphCount * sizeof(oc_glyph_data));
     }
     return (fontHandle);
 }
@@ -598,81 +1176,250 @@ void oc_font_destroy(oc_font fontHandle)
     if(fontData)
     {
         free(fontData->glyphMap);
+        free(fontData->lookupMap);
         free(fontData->glyphs);
-        free(fontData->outlines);
+        free(fontData->fontFile.ptr);
+
+        oc_text_metrics_cache_purge_font(fontHandle);
+        oc_glyph_atlas_purge_font(fontHandle);
 
         oc_list_push(&oc_graphicsData.fontFreeList, &fontData->freeListElt);
         oc_graphics_handle_recycle(fontHandle.h);
     }
 }
 
+static u32 oc_font_find_glyph_index_in_ranges(oc_font_data* fontData, oc_utf32 codePoint)
+{
+    //NOTE(martin): check the last range hit first, since text tends to stay in the same script
+    u32 rangeIndex = fontData->lastRangeIndex;
+    if(rangeIndex < fontData->lookupCount)
+    {
+        oc_glyph_map_entry* entry = &fontData->lookupMap[rangeIndex];
+        if(codePoint - entry->range.firstCodePoint < entry->range.count)
+        {
+            return (entry->firstGlyphIndex + codePoint - entry->range.firstCodePoint);
+        }
+    }
+
+    //NOTE(martin): binary search the last range whose first codepoint is less or equal to the codepoint.
+    //              Ranges of the lookup map don't overlap, so it's the only one that can contain it.
+    u32 lo = 0;
+    u32 hi = fontData->lookupCount;
+    while(lo < hi)
+    {
+        u32 mid = lo + (hi - lo) / 2;
+        if(fontData->lookupMap[mid].range.firstCodePoint <= codePoint)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    if(lo)
+    {
+        oc_glyph_map_entry* entry = &fontData->lookupMap[lo - 1];
+        if(codePoint - entry->range.firstCodePoint < entry->range.count)
+        {
+            fontData->lastRangeIndex = lo - 1;
+            return (entry->firstGlyphIndex + codePoint - entry->range.firstCodePoint);
+        }
+    }
+    return (0);
+}
+
 oc_str32 oc_font_get_glyph_indices_from_font_data(oc_font_data* fontData, oc_str32 codePoints, oc_str32 backing)
 {
     u64 count = oc_min(codePoints.len, backing.len);
+    u64 i = 0;
 
-    for(int i = 0; i < count; i++)
+    while(i < count)
     {
-        u32 glyphIndex = 0;
-        for(int rangeIndex = 0; rangeIndex < fontData->rangeCount; rangeIndex++)
+        //NOTE(martin): fast path for runs of Latin-1 codepoints, which are a direct table lookup
+        while(i < count && codePoints.ptr[i] < 256)
         {
-            if(codePoints.ptr[i] >= fontData->glyphMap[rangeIndex].range.firstCodePoint
-               && codePoints.ptr[i] < (fontData->glyphMap[rangeIndex].range.firstCodePoint + fontData->glyphMap[rangeIndex].range.count))
-            {
-                u32 rangeOffset = codePoints.ptr[i] - fontData->glyphMap[rangeIndex].range.firstCodePoint;
-                glyphIndex = fontData->glyphMap[rangeIndex].firstGlyphIndex + rangeOffset;
-                break;
-            }
+            backing.ptr[i] = fontData->latin1GlyphIndices[codePoints.ptr[i]];
+            i++;
         }
-        if(glyphIndex && !fontData->glyphs[glyphIndex].exists)
+        while(i < count && codePoints.ptr[i] >= 256)
         {
-            backing.ptr[i] = 0;
+            backing.ptr[i] = oc_font_find_glyph_index_in_ranges(fontData, codePoints.ptr[i]);
+            i++;
+        }
+    }
+    oc_str32 res = { .ptr = backing.ptr, .len = count };
+    return (res);
+}
+
+u32 oc_font_get_glyph_index_from_font_data(oc_font_data* fontData, oc_utf32 codePoint)
+{
+    u32 glyphIndex = 0;
+    oc_str32 codePoints = { .ptr = &codePoint, .len = 1 };
+    oc_str32 backing = { .ptr = &glyphIndex, 1 };
+    oc_font_get_glyph_indices_from_font_data(fontData, codePoints, backing);
+    return (glyphIndex);
+}
+
+oc_str32 oc_font_get_glyph_indices(oc_font font, oc_str32 codePoints, oc_str32 backing)
+{
+    oc_font_data* fontData = oc_font_data_from_handle(font);
+    if(!fontData)
+    {
+        return ((oc_str32){ 0 });
+    }
+    return (oc_font_get_glyph_indices_from_font_data(fontData, codePoints, backing));
+}
+
+oc_str32 oc_font_push_glyph_indices(oc_arena* arena, oc_font font, oc_str32 codePoints)
+{
+    u32* buffer = oc_arena_push_array(arena, u32, codePoints.len);
+    oc_str32 backing = { .ptr = buffer, .len = codePoints.len };
+    return (oc_font_get_glyph_indices(font, codePoints, backing));
+}
+
+u32 oc_font_get_glyph_index(oc_font font, oc_utf32 codePoint)
+{
+    u32 glyphIndex = 0;
+    oc_str32 codePoints = { .ptr = &codePoint, .len = 1 };
+    oc_str32 backing = { .ptr = &glyphIndex, .len = 1 };
+    oc_font_get_glyph_indices(font, codePoints, backing);
+    return (glyphIndex);
+}
+
+void oc_font_load_glyph(oc_font_data* fontData, u32 glyphIndex, oc_glyph_data* glyph)
+{
+    glyph->loaded = true;
+
+    //NOTE(martin): find the codepoint of the glyph
+    oc_utf32 codePoint = 0;
+    bool found = false;
+    for(int rangeIndex = 0; rangeIndex < fontData->rangeCount; rangeIndex++)
+    {
+        oc_glyph_map_entry* entry = &fontData->glyphMap[rangeIndex];
+        if(glyphIndex - entry->firstGlyphIndex < entry->range.count)
+        {
+            codePoint = entry->range.firstCodePoint + glyphIndex - entry->firstGlyphIndex;
+            found = true;
+            break;
+        }
+    }
+    if(!found)
+    {
+        return;
+    }
+
+    stbtt_fontinfo* stbttFontInfo = &fontData->stbttFontInfo;
+    int stbttGlyphIndex = stbtt_FindGlyphIndex(stbttFontInfo, codePoint);
+    if(stbttGlyphIndex == 0)
+    {
+        //NOTE(martin): the codepoint is not found in the font, we leave the glyph info zeroed
+        return;
+    }
+
+    glyph->exists = true;
+    glyph->codePoint = codePoint;
+
+    //NOTE(martin): load glyph metric
+    int xAdvance, xBearing, x0, y0, x1, y1;
+    stbtt_GetGlyphHMetrics(stbttFontInfo, stbttGlyphIndex, &xAdvance, &xBearing);
+    stbtt_GetGlyphBox(stbttFontInfo, stbttGlyphIndex, &x0, &y0, &x1, &y1);
+
+    //NOTE(martin): stb stbtt_GetGlyphBox returns bottom left and top right corners, with y up,
+    //              so we have to set .y = -y1
+    glyph->metrics.ink = (oc_rect){
+        .x = x0,
+        .y = -y1,
+        .w = x1 - x0,
+        .h = y1 - y0
+    };
+
+    glyph->metrics.advance = (oc_vec2){ xAdvance, 0 };
+
+    //NOTE(martin): load glyph outlines into the font's glyph arena
+    stbtt_vertex* vertices = 0;
+    int vertexCount = stbtt_GetGlyphShape(stbttFontInfo, stbttGlyphIndex, &vertices);
+
+    oc_path_elt* elements = oc_arena_push_array(&fontData->glyphArena, oc_path_elt, vertexCount);
+
+    glyph->outlines = elements;
+    glyph->pathDescriptor = (oc_path_descriptor){ .startIndex = fontData->outlineCount,
+                                                  .count = vertexCount,
+                                                  .startPoint = { 0, 0 } };
+    fontData->outlineCount += vertexCount;
+
+    for(int vertIndex = 0; vertIndex < vertexCount; vertIndex++)
+    {
+        f32 x = vertices[vertIndex].x;
+        f32 y = vertices[vertIndex].y;
+        f32 cx = vertices[vertIndex].cx;
+        f32 cy = vertices[vertIndex].cy;
+        f32 cx1 = vertices[vertIndex].cx1;
+        f32 cy1 = vertices[vertIndex].cy1;
+
+        switch(vertices[vertIndex].type)
+        {
+            case STBTT_vmove:
+                elements[vertIndex].type = OC_PATH_MOVE;
+                elements[vertIndex].p[0] = (oc_vec2){ x, y };
+                break;
+
+            case STBTT_vline:
+                elements[vertIndex].type = OC_PATH_LINE;
+                elements[vertIndex].p[0] = (oc_vec2){ x, y };
+                break;
+
+            case STBTT_vcurve:
+            {
+                elements[vertIndex].type = OC_PATH_QUADRATIC;
+                elements[vertIndex].p[0] = (oc_vec2){ cx, cy };
+                elements[vertIndex].p[1] = (oc_vec2){ x, y };
+            }
+            break;
+
+            case STBTT_vcubic:
+                elements[vertIndex].type = OC_PATH_CUBIC;
+                elements[vertIndex].p[0] = (oc_vec2){ cx, cy };
+                elements[vertIndex].p[1] = (oc_vec2){ cx1, cy1 };
+                elements[vertIndex].p[2] = (oc_vec2){ x, y };
+                break;
         }
-        backing.ptr[i] = glyphIndex;
     }
-    oc_str32 res = { .ptr = backing.ptr, .len = count };
-    return (res);
-}
+    stbtt_FreeShape(stbttFontInfo, vertices);
 
-u32 oc_font_get_glyph_index_from_font_data(oc_font_data* fontData, oc_utf32 codePoint)
-{
-    u32 glyphIndex = 0;
-    oc_str32 codePoints = { .ptr = &codePoint, .len = 1 };
-    oc_str32 backing = { .ptr = &glyphIndex, 1 };
-    oc_font_get_glyph_indices_from_font_data(fontData, codePoints, backing);
-    return (glyphIndex);
+    glyph->outlineHash = (u32)oc_hash_xx64_string(oc_str8_from_buffer(vertexCount * sizeof(oc_path_elt), (char*)elements));
 }
 
-oc_str32 oc_font_get_glyph_indices(oc_font font, oc_str32 codePoints, oc_str32 backing)
+oc_glyph_data* oc_font_get_glyph_data(oc_font_data* fontData, u32 glyphIndex)
 {
-    oc_font_data* fontData = oc_font_data_from_handle(font);
-    if(!fontData)
+    OC_DEBUG_ASSERT(glyphIndex);
+    OC_DEBUG_ASSERT(glyphIndex < fontData->glyphCount);
+
+    oc_glyph_data* glyph = &(fontData->glyphs[glyphIndex - 1]);
+    if(!glyph->loaded)
     {
-        return ((oc_str32){ 0 });
+        oc_font_load_glyph(fontData, glyphIndex, glyph);
     }
-    return (oc_font_get_glyph_indices_from_font_data(fontData, codePoints, backing));
-}
-
-oc_str32 oc_font_push_glyph_indices(oc_arena* arena, oc_font font, oc_str32 codePoints)
-{
-    u32* buffer = oc_arena_push_array(arena, u32, codePoints.len);
-    oc_str32 backing = { .ptr = buffer, .len = codePoints.len };
-    return (oc_font_get_glyph_indices(font, codePoints, backing));
-}
-
-u32 oc_font_get_glyph_index(oc_font font, oc_utf32 codePoint)
-{
-    u32 glyphIndex = 0;
-    oc_str32 codePoints = { .ptr = &codePoint, .len = 1 };
-    oc_str32 backing = { .ptr = &glyphIndex, .len = 1 };
-    oc_font_get_glyph_indices(font, codePoints, backing);
-    return (glyphIndex);
+    return (glyph);
 }
 
-oc_glyph_data* oc_font_get_glyph_data(oc_font_data* fontData, u32 glyphIndex)
+void oc_font_prefetch_glyphs(oc_font font, u32 rangeCount, oc_unicode_range* ranges)
 {
-    OC_DEBUG_ASSERT(glyphIndex);
-    OC_DEBUG_ASSERT(glyphIndex < fontData->glyphCount);
-    return (&(fontData->glyphs[glyphIndex - 1]));
+    oc_font_data* fontData = oc_font_data_from_handle(font);
+    if(fontData)
+    {
+        for(int rangeIndex = 0; rangeIndex < rangeCount; rangeIndex++)
+        {
+            for(u32 i = 0; i < ranges[rangeIndex].count; i++)
+            {
+                u32 glyphIndex = oc_font_get_glyph_index_from_font_data(fontData, ranges[rangeIndex].firstCodePoint + i);
+                if(glyphIndex && glyphIndex < fontData->glyphCount)
+                {
+                    oc_font_get_glyph_data(fontData, glyphIndex);
+                }
+            }
+        }
+    }
 }
 
 oc_font_metrics oc_font_get_metrics_unscaled(oc_font font)
@@ -760,54 +1507,53 @@ int oc_font_get_codepoint_metrics(oc_font font, oc_utf32 codePoint, oc_text_metr
 */
 /////////////////////////////////////////////////
 
-oc_text_metrics oc_font_text_metrics_utf32(oc_font font, f32 fontSize, oc_str32 codePoints)
+oc_glyph_metrics oc_font_get_missing_glyph_metrics(oc_font_data* fontData)
 {
-    if(!codePoints.len || !codePoints.ptr)
-    {
-        return ((oc_text_metrics){ 0 });
-    }
-
-    oc_font_data* fontData = oc_font_data_from_handle(font);
-    if(!fontData)
-    {
-        return ((oc_text_metrics){ 0 });
-    }
-
-    oc_arena_scope scratch = oc_scratch_begin();
-    oc_str32 glyphIndices = oc_font_push_glyph_indices(scratch.arena, font, codePoints);
-
-    //NOTE(martin): find width of missing character
-    //TODO(martin): should cache that at font creation...
-    oc_glyph_metrics missingGlyphMetrics = { 0 };
-    u32 missingGlyphIndex = oc_font_get_glyph_index_from_font_data(fontData, 0xfffd);
-
-    if(missingGlyphIndex)
-    {
-        oc_font_get_glyph_metrics_from_font_data(fontData, (oc_str32){ .ptr = &missingGlyphIndex, .len = 1 }, &missingGlyphMetrics);
-    }
-    else
+    if(!fontData->missingGlyphMetricsCached)
     {
-        //NOTE(martin): could not find replacement glyph, try to get an 'X' to get a somewhat correct dimensions
-        //              to render an empty rectangle. Otherwise just render with the max font width
+        //NOTE(martin): find width of missing character
+        oc_glyph_metrics missingGlyphMetrics = { 0 };
+        u32 missingGlyphIndex = oc_font_get_glyph_index_from_font_data(fontData, 0xfffd);
 
-        missingGlyphIndex = oc_font_get_glyph_index_from_font_data(fontData, 'X');
         if(missingGlyphIndex)
         {
             oc_font_get_glyph_metrics_from_font_data(fontData, (oc_str32){ .ptr = &missingGlyphIndex, .len = 1 }, &missingGlyphMetrics);
         }
         else
         {
-            missingGlyphMetrics = (oc_glyph_metrics){
-                .ink = {
-                    .x = fontData->metrics.width * 0.1,
-                    .y = -fontData->metrics.ascent,
-                    .w = fontData->metrics.width * 0.8,
-                    .h = fontData->metrics.ascent,
-                },
-                .advance = { .x = fontData->metrics.width, .y = 0 },
-            };
+            //NOTE(martin): could not find replacement glyph, try to get an 'X' to get a somewhat correct dimensions
+            //              to render an empty rectangle. Otherwise just render with the max font width
+
+            missingGlyphIndex = oc_font_get_glyph_index_from_font_data(fontData, 'X');
+            if(missingGlyphIndex)
+            {
+                oc_font_get_glyph_metrics_from_font_data(fontData, (oc_str32){ .ptr = &missingGlyphIndex, .len = 1 }, &missingGlyphMetrics);
+            }
+            else
+            {
+                missingGlyphMetrics = (oc_glyph_metrics){
+                    .ink = {
+                        .x = fontData->metrics.width * 0.1,
+                        .y = -fontData->metrics.ascent,
+                        .w = fontData->metrics.width * 0.8,
+                        .h = fontData->metrics.ascent,
+                    },
+                    .advance = { .x = fontData->metrics.width, .y = 0 },
+                };
+            }
         }
+        fontData->missingGlyphMetrics = missingGlyphMetrics;
+        fontData->missingGlyphMetricsCached = true;
     }
+    return (fontData->missingGlyphMetrics);
+}
+
+oc_text_metrics oc_font_text_metrics_unscaled(oc_font_data* fontData, oc_font font, oc_str32 codePoints)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+    oc_str32 glyphIndices = oc_font_push_glyph_indices(scratch.arena, font, codePoints);
+
+    oc_glyph_metrics missingGlyphMetrics = oc_font_get_missing_glyph_metrics(fontData);
 
     //NOTE(martin): accumulate text extents
     oc_text_metrics metrics = { 0 };
@@ -868,23 +1614,44 @@ oc_text_metrics oc_font_text_metrics_utf32(oc_font font, f32 fontSize, oc_str32
 
     OC_ASSERT(metrics.ink.y <= 0);
 
-    f32 fontScale = oc_font_get_scale_for_em_pixels(font, fontSize);
-
-    metrics.ink.x *= fontScale;
-    metrics.ink.y *= fontScale;
-    metrics.ink.w *= fontScale;
-    metrics.ink.h *= fontScale;
-    metrics.logical.x *= fontScale;
-    metrics.logical.y *= fontScale;
-    metrics.logical.w *= fontScale;
-    metrics.logical.h *= fontScale;
-    metrics.advance.x *= fontScale;
-    metrics.advance.y *= fontScale;
-
     oc_scratch_end(scratch);
     return (metrics);
 }
 
+oc_text_metrics oc_font_text_metrics_utf32(oc_font font, f32 fontSize, oc_str32 codePoints)
+{
+    if(!codePoints.len || !codePoints.ptr)
+    {
+        return ((oc_text_metrics){ 0 });
+    }
+
+    oc_font_data* fontData = oc_font_data_from_handle(font);
+    if(!fontData)
+    {
+        return ((oc_text_metrics){ 0 });
+    }
+
+    //NOTE(martin): utf32 keys are tagged so that they never match utf8 keys with the same bytes, and are
+    //              hashed with a different seed so that they don't share buckets either
+    oc_str8 bytes = { .ptr = (char*)codePoints.ptr, .len = codePoints.len * sizeof(oc_utf32) };
+    u64 hash = oc_hash_xx64_string_seed(bytes, 32);
+
+    oc_text_metrics metrics;
+    oc_text_metrics_cache_entry* entry = oc_text_metrics_cache_find(font, hash, true, bytes);
+    if(entry)
+    {
+        metrics = entry->metrics;
+    }
+    else
+    {
+        metrics = oc_font_text_metrics_unscaled(fontData, font, codePoints);
+        oc_text_metrics_cache_insert(font, hash, true, bytes, &metrics);
+    }
+
+    f32 fontScale = oc_font_get_scale_for_em_pixels(font, fontSize);
+    return (oc_text_metrics_scale(metrics, fontScale));
+}
+
 oc_text_metrics oc_font_text_metrics(oc_font font, f32 fontSize, oc_str8 text)
 {
     if(!text.len || !text.ptr)
@@ -892,11 +1659,33 @@ oc_text_metrics oc_font_text_metrics(oc_font font, f32 fontSize, oc_str8 text)
         return ((oc_text_metrics){ 0 });
     }
 
-    oc_arena_scope scratch = oc_scratch_begin();
-    oc_str32 codePoints = oc_utf8_push_to_codepoints(scratch.arena, text);
-    oc_text_metrics result = oc_font_text_metrics_utf32(font, fontSize, codePoints);
-    oc_scratch_end(scratch);
-    return (result);
+    oc_font_data* fontData = oc_font_data_from_handle(font);
+    if(!fontData)
+    {
+        return ((oc_text_metrics){ 0 });
+    }
+
+    //NOTE(martin): look up the utf8 text directly, so that cache hits don't need to decode it
+    u64 hash = oc_hash_xx64_string(text);
+
+    oc_text_metrics metrics;
+    oc_text_metrics_cache_entry* entry = oc_text_metrics_cache_find(font, hash, false, text);
+    if(entry)
+    {
+        metrics = entry->metrics;
+    }
+    else
+    {
+        oc_arena_scope scratch = oc_scratch_begin();
+        oc_str32 codePoints = oc_utf8_push_to_codepoints(scratch.arena, text);
+        metrics = oc_font_text_metrics_unscaled(fontData, font, codePoints);
+        oc_scratch_end(scratch);
+
+        oc_text_metrics_cache_insert(font, hash, false, text, &metrics);
+    }
+
+    f32 fontScale = oc_font_get_scale_for_em_pixels(font, fontSize);
+    return (oc_text_metrics_scale(metrics, fontScale));
 }
 
 //------------------------------------------------------------------------------------------
@@ -939,7 +1728,13 @@ oc_canvas oc_canvas_create()
         canvas->matrixStackSize = 0;
         canvas->clipStackSize = 0;
         canvas->primitiveCount = 0;
+        canvas->culledCount = 0;
+        canvas->mergedCount = 0;
         canvas->clearColor = (oc_color){ 0, 0, 0, 0 };
+        canvas->stats = (oc_canvas_stats){ 0 };
+        canvas->glyphDefGeneration = ++oc_graphicsData.glyphDefGeneration;
+        canvas->pathHasGlyphDefs = false;
+        canvas->pathHasGlyphs = false;
 
         canvas->attributes = (oc_attributes){ 0 };
         canvas->attributes.color = (oc_color){ 0, 0, 0, 1 };
@@ -981,20 +1776,82 @@ void oc_render(oc_canvas canvas)
 {
     oc_surface selectedSurface = oc_surface_get_selected();
     oc_canvas_data* canvasData = oc_canvas_data_from_handle(canvas);
-    if(canvasData && !oc_surface_is_nil(selectedSurface))
+    if(canvasData)
     {
+        //NOTE(martin): without a selected surface, the canvas acts as a recording canvas: commands are
+        //              counted in the stats and discarded, which allows measuring command emission headlessly
+        bool headless = oc_surface_is_nil(selectedSurface);
+
+        //NOTE(martin): cull primitives that are entirely outside the surface
+        u32 culledCount = canvasData->culledCount;
+        u32 primitiveCount = canvasData->primitiveCount;
+
+        if(!headless)
+        {
+            oc_vec2 surfaceSize = oc_surface_get_size(selectedSurface);
+            primitiveCount = 0;
+
+            for(u32 i = 0; i < canvasData->primitiveCount; i++)
+            {
+                oc_vec4 bounds = canvasData->primitiveBounds[i];
+                if(bounds.z < 0 || bounds.w < 0 || bounds.x > surfaceSize.x || bounds.y > surfaceSize.y)
+                {
+                    culledCount++;
+                }
+                else
+                {
+                    if(primitiveCount != i)
+                    {
+                        canvasData->primitives[primitiveCount] = canvasData->primitives[i];
+                    }
+                    primitiveCount++;
+                }
+            }
+        }
+
         int eltCount = canvasData->path.startIndex + canvasData->path.count;
-        oc_surface_render_commands(selectedSurface,
-                                   canvasData->clearColor,
-                                   canvasData->primitiveCount,
-                                   canvasData->primitives,
-                                   eltCount,
-                                   canvasData->pathElements);
+        if(!headless)
+        {
+            oc_surface_render_commands(selectedSurface,
+                                       canvasData->clearColor,
+                                       primitiveCount,
+                                       canvasData->primitives,
+                                       eltCount,
+                                       canvasData->pathElements);
+        }
+
+        canvasData->stats = (oc_canvas_stats){
+            .primitiveCount = primitiveCount,
+            .culledPrimitiveCount = culledCount,
+            .mergedPrimitiveCount = canvasData->mergedCount,
+            .eltCount = eltCount,
+        };
 
         canvasData->primitiveCount = 0;
+        canvasData->culledCount = 0;
+        canvasData->mergedCount = 0;
         canvasData->path.startIndex = 0;
         canvasData->path.count = 0;
+        canvasData->glyphDefGeneration = ++oc_graphicsData.glyphDefGeneration;
+        canvasData->pathHasGlyphDefs = false;
+        canvasData->pathHasGlyphs = false;
+
+        if(!headless && oc_graphicsData.glyphAtlas.flushRequested)
+        {
+            oc_glyph_atlas_flush();
+        }
+    }
+}
+
+oc_canvas_stats oc_canvas_get_stats(oc_canvas canvas)
+{
+    oc_canvas_stats stats = { 0 };
+    oc_canvas_data* canvasData = oc_canvas_data_from_handle(canvas);
+    if(canvasData)
+    {
+        stats = canvasData->stats;
     }
+    return (stats);
 }
 
 //------------------------------------------------------------------------------------------
@@ -1351,6 +2208,7 @@ void oc_move_to(f32 x, f32 y)
     {
         return;
     }
+    oc_path_check_open_subpath(canvas);
     oc_path_push_element(canvas, ((oc_path_elt){ .type = OC_PATH_MOVE, .p[0] = { x, y } }));
     canvas->subPathStartPoint = (oc_vec2){ x, y };
     canvas->subPathLastPoint = (oc_vec2){ x, y };
@@ -1408,11 +2266,15 @@ oc_rect oc_glyph_outlines_from_font_data(oc_font_data* fontData, oc_str32 glyphI
 {
     oc_canvas_data* canvas = __mgCurrentCanvas;
 
+    //NOTE(martin): glyphs start new subpaths from the current point
+    oc_path_check_open_subpath(canvas);
+
     f32 startX = canvas->subPathLastPoint.x;
     f32 startY = canvas->subPathLastPoint.y;
     f32 maxWidth = 0;
 
     f32 scale = canvas->attributes.fontSize / fontData->unitsPerEm;
+    bool pushedGlyphs = false;
 
     for(int i = 0; i < glyphIndices.len; i++)
     {
@@ -1469,21 +2331,52 @@ oc_rect oc_glyph_outlines_from_font_data(oc_font_data* fontData, oc_str32 glyphI
 
         oc_glyph_data* glyph = oc_font_get_glyph_data(fontData, glyphIndex);
 
-        oc_path_push_elements(canvas, glyph->pathDescriptor.count, fontData->outlines + glyph->pathDescriptor.startIndex);
-
-        oc_path_elt* elements = canvas->pathElements + canvas->path.count + canvas->path.startIndex - glyph->pathDescriptor.count;
-        for(int eltIndex = 0; eltIndex < glyph->pathDescriptor.count; eltIndex++)
+        if(glyph->pathDescriptor.count)
         {
-            for(int pIndex = 0; pIndex < 3; pIndex++)
+            if(glyph->defGeneration != canvas->glyphDefGeneration)
             {
-                elements[eltIndex].p[pIndex].x = elements[eltIndex].p[pIndex].x * scale + xOffset;
-                elements[eltIndex].p[pIndex].y = elements[eltIndex].p[pIndex].y * scale * flip + yOffset;
+                //NOTE(martin): first use of this glyph since the element buffer was reset, push its outlines
+                //              definition. The bounding box is the glyph box in font units, y up.
+                glyph->defGeneration = canvas->glyphDefGeneration;
+                glyph->defIndex = canvas->path.startIndex + canvas->path.count;
+
+                oc_path_elt def = {
+                    .type = OC_PATH_GLYPH_DEF,
+                    .glyphDef = {
+                        .count = glyph->pathDescriptor.count,
+                        .min = { glyph->metrics.ink.x, -glyph->metrics.ink.y - glyph->metrics.ink.h },
+                        .max = { glyph->metrics.ink.x + glyph->metrics.ink.w, -glyph->metrics.ink.y },
+                    },
+                };
+                oc_path_push_element(canvas, def);
+                oc_path_push_elements(canvas, glyph->pathDescriptor.count, glyph->outlines);
+                canvas->pathHasGlyphDefs = true;
             }
+
+            oc_path_elt elt = {
+                .type = OC_PATH_GLYPH,
+                .glyph = {
+                    .origin = { xOffset, yOffset },
+                    .scale = { scale, scale * flip },
+                    .defIndex = glyph->defIndex,
+                    .outlineHash = glyph->outlineHash,
+                },
+            };
+            oc_path_push_element(canvas, elt);
+            canvas->pathHasGlyphs = true;
         }
-        oc_move_to(xOffset + scale * glyph->metrics.advance.x, yOffset);
+
+        //NOTE(martin): advance the pen without pushing a move element, a single move is pushed after the run
+        canvas->subPathLastPoint = (oc_vec2){ xOffset + scale * glyph->metrics.advance.x, yOffset };
+        canvas->subPathStartPoint = canvas->subPathLastPoint;
+        pushedGlyphs = true;
 
         maxWidth = oc_max(maxWidth, xOffset + scale * glyph->metrics.advance.x - startX);
     }
+    if(pushedGlyphs)
+    {
+        oc_move_to(canvas->subPathLastPoint.x, canvas->subPathLastPoint.y);
+    }
     f32 lineHeight = (fontData->metrics.ascent + fontData->metrics.descent) * scale;
     oc_rect box = { startX, startY, maxWidth, canvas->subPathLastPoint.y - startY + lineHeight };
     return (box);
@@ -1519,13 +2412,167 @@ void oc_codepoints_outlines(oc_str32 codePoints)
 
     oc_arena_scope scratch = oc_scratch_begin();
 
-    oc_str32 glyphIndices = oc_font_push_glyph_indices(scratch.arena, canvas->attributes.font, codePoints);
-    oc_glyph_outlines_from_font_data(fontData, glyphIndices);
+    oc_str32 glyphIndices = oc_font_push_glyph_indices(scratch.arena, canvas->attributes.font, codePoints);
+    oc_glyph_outlines_from_font_data(fontData, glyphIndices);
+
+    oc_scratch_end(scratch);
+}
+
+void oc_text_outlines(oc_str8 text)
+{
+    oc_canvas_data* canvas = __mgCurrentCanvas;
+    if(!canvas)
+    {
+        return;
+    }
+    oc_font_data* fontData = oc_font_data_from_handle(canvas->attributes.font);
+    if(!fontData)
+    {
+        return;
+    }
+
+    oc_arena_scope scratch = oc_scratch_begin();
+    oc_str32 codePoints = oc_utf8_push_to_codepoints(scratch.arena, text);
+    oc_str32 glyphIndices = oc_font_push_glyph_indices(scratch.arena, canvas->attributes.font, codePoints);
+
+    oc_glyph_outlines_from_font_data(fontData, glyphIndices);
+
+    oc_scratch_end(scratch);
+}
+
+void oc_glyph_atlas_push_quad(oc_canvas_data* canvas, oc_rect dst, oc_rect src)
+{
+    oc_image oldImage = canvas->attributes.image;
+    oc_rect oldSrcRegion = canvas->attributes.srcRegion;
+
+    canvas->attributes.image = oc_graphicsData.glyphAtlas.image;
+    canvas->attributes.srcRegion = src;
+
+    canvas->path.startPoint = (oc_vec2){ dst.x, dst.y };
+    oc_path_push_element(canvas, ((oc_path_elt){ .type = OC_PATH_LINE, .p[0] = { dst.x + dst.w, dst.y } }));
+    oc_path_push_element(canvas, ((oc_path_elt){ .type = OC_PATH_LINE, .p[0] = { dst.x + dst.w, dst.y + dst.h } }));
+    oc_path_push_element(canvas, ((oc_path_elt){ .type = OC_PATH_LINE, .p[0] = { dst.x, dst.y + dst.h } }));
+    oc_path_push_element(canvas, ((oc_path_elt){ .type = OC_PATH_LINE, .p[0] = { dst.x, dst.y } }));
+
+    oc_push_command(canvas, (oc_primitive){ .cmd = OC_CMD_FILL, .path = canvas->path });
+    canvas->path.startIndex += canvas->path.count;
+    canvas->path.count = 0;
+
+    canvas->attributes.image = oldImage;
+    canvas->attributes.srcRegion = oldSrcRegion;
+}
+
+void oc_glyph_fill_from_font_data(oc_font font, oc_font_data* fontData, oc_str32 glyphIndices)
+{
+    oc_canvas_data* canvas = __mgCurrentCanvas;
+    oc_glyph_atlas* atlas = &oc_graphicsData.glyphAtlas;
+    oc_mat2x3 transform = oc_matrix_stack_top(canvas);
+
+    //NOTE(martin): glyphs are drawn as one primitive each, so we also fall back to outlines
+    //              if they wouldn't fit in the remaining primitives
+    if(!atlas->enabled
+       || canvas->attributes.fontSize > atlas->maxFontSize
+       || transform.m[0] != 1 || transform.m[1] != 0
+       || transform.m[3] != 0 || transform.m[4] != 1
+       || canvas->primitiveCount + glyphIndices.len >= OC_MAX_PRIMITIVE_COUNT)
+    {
+        oc_glyph_outlines_from_font_data(fontData, glyphIndices);
+        oc_fill();
+        return;
+    }
+
+    //NOTE(martin): drop pending moves, and fill any other pending path with the current attributes
+    bool pendingMovesOnly = true;
+    for(int eltIndex = 0; eltIndex < canvas->path.count; eltIndex++)
+    {
+        if(canvas->pathElements[canvas->path.startIndex + eltIndex].type != OC_PATH_MOVE)
+        {
+            pendingMovesOnly = false;
+            break;
+        }
+    }
+    if(pendingMovesOnly)
+    {
+        canvas->path.count = 0;
+    }
+    else
+    {
+        oc_fill();
+    }
+
+    f32 pixelSize = canvas->attributes.fontSize * atlas->scaling;
+    u32 sizeBucket = (u32)(pixelSize * OC_GLYPH_ATLAS_SIZE_STEPS + 0.5);
+    f32 scale = canvas->attributes.fontSize / fontData->unitsPerEm;
+
+    for(int i = 0; i < glyphIndices.len; i++)
+    {
+        u32 glyphIndex = glyphIndices.ptr[i];
+        oc_vec2 pen = canvas->subPathLastPoint;
+
+        //NOTE(martin): snap the baseline to the pixel grid, and quantize the horizontal subpixel position
+        f32 penX = (pen.x + transform.m[2]) * atlas->scaling;
+        f32 penY = floor((pen.y + transform.m[5]) * atlas->scaling + 0.5);
+        f32 penXFloor = floor(penX);
+        u32 subpixel = oc_min((u32)((penX - penXFloor) * OC_GLYPH_ATLAS_SUBPIXEL_COUNT), OC_GLYPH_ATLAS_SUBPIXEL_COUNT - 1);
+
+        oc_glyph_data* glyph = 0;
+        oc_glyph_atlas_entry* entry = 0;
+
+        if(glyphIndex && glyphIndex < fontData->glyphCount && sizeBucket)
+        {
+            glyph = oc_font_get_glyph_data(fontData, glyphIndex);
+            if(glyph->exists)
+            {
+                entry = oc_glyph_atlas_find(font, glyphIndex, sizeBucket, subpixel);
+                if(!entry)
+                {
+                    entry = oc_glyph_atlas_rasterize(font, fontData, glyphIndex, glyph, sizeBucket, subpixel);
+                }
+            }
+        }
+
+        if(!entry)
+        {
+            //NOTE(martin): missing glyph or full atlas, draw outlines instead
+            oc_glyph_outlines_from_font_data(fontData, (oc_str32){ .ptr = &glyphIndices.ptr[i], .len = 1 });
+            oc_fill();
+            continue;
+        }
+
+        if(entry->rect.w)
+        {
+            oc_rect src = entry->rect;
+            oc_rect dst = {
+                penXFloor + entry->offset.x,
+                penY + entry->offset.y,
+                entry->rect.w,
+                entry->rect.h,
+            };
+
+            if(canvas->textFlip)
+            {
+                //NOTE(martin): y axis points up, flip the quad around the baseline and sample the image upside down
+                dst.y = penY - entry->offset.y - entry->rect.h;
+                src.y += src.h;
+                src.h = -src.h;
+            }
+
+            dst.x = dst.x / atlas->scaling - transform.m[2];
+            dst.y = dst.y / atlas->scaling - transform.m[5];
+            dst.w /= atlas->scaling;
+            dst.h /= atlas->scaling;
+
+            oc_glyph_atlas_push_quad(canvas, dst, src);
+        }
+
+        canvas->subPathLastPoint = (oc_vec2){ pen.x + scale * glyph->metrics.advance.x, pen.y };
+    }
 
-    oc_scratch_end(scratch);
+    canvas->subPathStartPoint = canvas->subPathLastPoint;
+    canvas->path.startPoint = canvas->subPathLastPoint;
 }
 
-void oc_text_outlines(oc_str8 text)
+void oc_codepoints_fill(oc_str32 codePoints)
 {
     oc_canvas_data* canvas = __mgCurrentCanvas;
     if(!canvas)
@@ -1539,10 +2586,9 @@ void oc_text_outlines(oc_str8 text)
     }
 
     oc_arena_scope scratch = oc_scratch_begin();
-    oc_str32 codePoints = oc_utf8_push_to_codepoints(scratch.arena, text);
-    oc_str32 glyphIndices = oc_font_push_glyph_indices(scratch.arena, canvas->attributes.font, codePoints);
 
-    oc_glyph_outlines_from_font_data(fontData, glyphIndices);
+    oc_str32 glyphIndices = oc_font_push_glyph_indices(scratch.arena, canvas->attributes.font, codePoints);
+    oc_glyph_fill_from_font_data(canvas->attributes.font, fontData, glyphIndices);
 
     oc_scratch_end(scratch);
 }
@@ -1557,6 +2603,8 @@ void oc_clear()
     if(canvas)
     {
         canvas->primitiveCount = 0;
+        canvas->culledCount = 0;
+        canvas->mergedCount = 0;
         canvas->clearColor = canvas->attributes.color;
     }
 }
@@ -1571,11 +2619,67 @@ void oc_fill()
     }
 }
 
+void oc_path_expand_glyphs(oc_canvas_data* canvas)
+{
+    //NOTE(martin): backends only stroke plain path elements, so we replace glyph elements with
+    //              their transformed outlines. This overwrites the definitions held by the current
+    //              path, so we also start a new definitions generation.
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    u32 startIndex = canvas->path.startIndex;
+    u32 count = canvas->path.count;
+    oc_path_elt* elements = oc_arena_push_array(scratch.arena, oc_path_elt, count);
+    memcpy(elements, canvas->pathElements + startIndex, count * sizeof(oc_path_elt));
+
+    canvas->path.count = 0;
+
+    for(u32 eltIndex = 0; eltIndex < count; eltIndex++)
+    {
+        oc_path_elt* elt = &elements[eltIndex];
+        if(elt->type == OC_PATH_GLYPH_DEF)
+        {
+            eltIndex += elt->glyphDef.count;
+        }
+        else if(elt->type == OC_PATH_GLYPH)
+        {
+            u32 defIndex = elt->glyph.defIndex;
+            oc_path_elt* def = (defIndex >= startIndex)
+                                 ? &elements[defIndex - startIndex]
+                                 : &canvas->pathElements[defIndex];
+
+            for(u32 outlineIndex = 0; outlineIndex < def->glyphDef.count; outlineIndex++)
+            {
+                oc_path_elt outline = def[outlineIndex + 1];
+                for(int pIndex = 0; pIndex < 3; pIndex++)
+                {
+                    outline.p[pIndex].x = outline.p[pIndex].x * elt->glyph.scale.x + elt->glyph.origin.x;
+                    outline.p[pIndex].y = outline.p[pIndex].y * elt->glyph.scale.y + elt->glyph.origin.y;
+                }
+                oc_path_push_element(canvas, outline);
+            }
+        }
+        else
+        {
+            oc_path_push_element(canvas, *elt);
+        }
+    }
+
+    oc_scratch_end(scratch);
+
+    canvas->glyphDefGeneration = ++oc_graphicsData.glyphDefGeneration;
+    canvas->pathHasGlyphDefs = false;
+    canvas->pathHasGlyphs = false;
+}
+
 void oc_stroke()
 {
     oc_canvas_data* canvas = __mgCurrentCanvas;
     if(canvas && canvas->path.count)
     {
+        if(canvas->pathHasGlyphs)
+        {
+            oc_path_expand_glyphs(canvas);
+        }
         oc_push_command(canvas, (oc_primitive){ .cmd = OC_CMD_STROKE, .path = canvas->path });
         oc_new_path(canvas);
     }
@@ -1708,8 +2812,11 @@ void oc_arc(f32 x, f32 y, f32 r, f32 arcAngle, f32 startAngle)
 void oc_text_fill(f32 x, f32 y, oc_str8 text)
 {
     oc_move_to(x, y);
-    oc_text_outlines(text);
-    oc_fill();
+
+    oc_arena_scope scratch = oc_scratch_begin();
+    oc_str32 codePoints = oc_utf8_push_to_codepoints(scratch.arena, text);
+    oc_codepoints_fill(codePoints);
+    oc_scratch_end(scratch);
 }
 
 //------------------------------------------------------------------------------------------
@@ -1730,26 +2837,141 @@ oc_image oc_image_create_from_rgba8(oc_surface surface, u32 width, u32 height, u
     return (image);
 }
 
-oc_image oc_image_create_from_memory(oc_surface surface, oc_str8 mem, bool flip)
+//NOTE(martin): we flip rows ourselves rather than using stbi_set_flip_vertically_on_load(),
+// because that flag is process-wide and images can be decoded concurrently by the async decoder
+void oc_image_flip_rows_rgba8(u8* pixels, int width, int height)
+{
+    u64 pitch = (u64)width * 4;
+    for(int top = 0, bottom = height - 1; top < bottom; top++, bottom--)
+    {
+        u8* a = pixels + top * pitch;
+        u8* b = pixels + bottom * pitch;
+        for(u64 i = 0; i < pitch; i++)
+        {
+            u8 tmp = a[i];
+            a[i] = b[i];
+            b[i] = tmp;
+        }
+    }
+}
+
+//NOTE(martin): box filter used to shrink decoded images. Each destination pixel averages the block of source
+// pixels it covers. Colors are weighted by alpha so that transparent pixels don't bleed into their neighbours.
+// The vertical pass accumulates whole source rows into column sums, which keeps the inner loop contiguous and
+// lets the compiler vectorize it.
+void oc_image_box_downscale_rgba8(u8* dst, u32 dstWidth, u32 dstHeight, u8* src, u32 srcWidth, u32 srcHeight)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+    u32* columnSums = oc_arena_push_array(scratch.arena, u32, srcWidth * 4);
+
+    for(u32 dy = 0; dy < dstHeight; dy++)
+    {
+        u32 y0 = (u64)dy * srcHeight / dstHeight;
+        u32 y1 = oc_max((u64)(dy + 1) * srcHeight / dstHeight, y0 + 1);
+
+        memset(columnSums, 0, srcWidth * 4 * sizeof(u32));
+        for(u32 y = y0; y < y1; y++)
+        {
+            u8* row = src + (u64)y * srcWidth * 4;
+            for(u32 x = 0; x < srcWidth; x++)
+            {
+                u32 a = row[4 * x + 3];
+                columnSums[4 * x + 0] += (row[4 * x + 0] * a + 127) / 255;
+                columnSums[4 * x + 1] += (row[4 * x + 1] * a + 127) / 255;
+                columnSums[4 * x + 2] += (row[4 * x + 2] * a + 127) / 255;
+                columnSums[4 * x + 3] += a;
+            }
+        }
+
+        u8* dstRow = dst + (u64)dy * dstWidth * 4;
+        for(u32 dx = 0; dx < dstWidth; dx++)
+        {
+            u32 x0 = (u64)dx * srcWidth / dstWidth;
+            u32 x1 = oc_max((u64)(dx + 1) * srcWidth / dstWidth, x0 + 1);
+
+            u64 sums[4] = { 0 };
+            for(u32 x = x0; x < x1; x++)
+            {
+                sums[0] += columnSums[4 * x + 0];
+                sums[1] += columnSums[4 * x + 1];
+                sums[2] += columnSums[4 * x + 2];
+                sums[3] += columnSums[4 * x + 3];
+            }
+
+            u64 count = (u64)(x1 - x0) * (y1 - y0);
+            u8* pixel = dstRow + 4 * dx;
+            if(sums[3])
+            {
+                pixel[0] = oc_min((sums[0] * 255 + sums[3] / 2) / sums[3], 255);
+                pixel[1] = oc_min((sums[1] * 255 + sums[3] / 2) / sums[3], 255);
+                pixel[2] = oc_min((sums[2] * 255 + sums[3] / 2) / sums[3], 255);
+                pixel[3] = (sums[3] + count / 2) / count;
+            }
+            else
+            {
+                memset(pixel, 0, 4);
+            }
+        }
+    }
+    oc_scratch_end(scratch);
+}
+
+oc_image oc_image_create_from_memory_with_options(oc_surface surface, oc_str8 mem, oc_image_options options)
 {
     oc_image image = oc_image_nil();
     int width, height, channels;
 
-    stbi_set_flip_vertically_on_load(flip ? 1 : 0);
     u8* pixels = stbi_load_from_memory((u8*)mem.ptr, mem.len, &width, &height, &channels, 4);
 
     if(pixels)
     {
-        image = oc_image_create_from_rgba8(surface, width, height, pixels);
+        if(options.flip)
+        {
+            oc_image_flip_rows_rgba8(pixels, width, height);
+        }
+
+        if(options.maxDimension && ((u32)width > options.maxDimension || (u32)height > options.maxDimension))
+        {
+            f32 ratio = (f32)options.maxDimension / oc_max(width, height);
+            int scaledWidth = oc_clamp((int)(width * ratio + 0.5f), 1, (int)options.maxDimension);
+            int scaledHeight = oc_clamp((int)(height * ratio + 0.5f), 1, (int)options.maxDimension);
+
+            u8* scaledPixels = malloc((u64)scaledWidth * scaledHeight * 4);
+            oc_image_box_downscale_rgba8(scaledPixels, scaledWidth, scaledHeight, pixels, width, height);
+
+            free(pixels);
+            pixels = scaledPixels;
+            width = scaledWidth;
+            height = scaledHeight;
+        }
+
+        if(options.mipmaps)
+        {
+            image = oc_image_create_mipmapped(surface, width, height);
+            if(!oc_image_is_nil(image))
+            {
+                oc_image_upload_region_rgba8(image, (oc_rect){ 0, 0, width, height }, pixels);
+            }
+        }
+        else
+        {
+            image = oc_image_create_from_rgba8(surface, width, height, pixels);
+        }
         free(pixels);
     }
     else
     {
-        oc_log_error("stbi_load_from_memory() failed: %s\n", stbi_failure_reason());
+        const char* reason = stbi_failure_reason();
+        oc_log_error("stbi_load_from_memory() failed: %s.\n", reason ? reason : "no failure reason");
     }
     return (image);
 }
 
+oc_image oc_image_create_from_memory(oc_surface surface, oc_str8 mem, bool flip)
+{
+    return (oc_image_create_from_memory_with_options(surface, mem, (oc_image_options){ .flip = flip }));
+}
+
 oc_image oc_image_create_from_file(oc_surface surface, oc_file file, bool flip)
 {
     oc_image image = oc_image_nil();
@@ -1826,51 +3048,376 @@ void oc_image_draw(oc_image image, oc_rect rect)
 //NOTE(martin): atlasing
 //------------------------------------------------------------------------------------------
 
-//NOTE: rectangle allocator
+//NOTE: rectangle allocator. The atlas is cut into horizontal shelves, whose heights are rounded up to a
+//      few size classes. Each shelf keeps a list of free spans sorted by x, and recycled rectangles are
+//      merged back into adjacent spans. Shelves that become empty are merged with neighbouring free
+//      shelves, so that their space can be reused for a different size class. Rectangles are padded by
+//      one pixel on their right and bottom sides to avoid sampling bleed.
+typedef struct oc_rect_atlas_span
+{
+    oc_list_elt listElt;
+    i32 x;
+    i32 w;
+
+} oc_rect_atlas_span;
+
+typedef struct oc_rect_atlas_shelf
+{
+    oc_list_elt listElt;
+    i32 y;
+    i32 h;
+    bool isFree;
+    u32 allocCount;
+    oc_list freeSpans;
+
+} oc_rect_atlas_shelf;
+
 typedef struct oc_rect_atlas
 {
     oc_arena* arena;
     oc_vec2i size;
-    oc_vec2i pos;
-    u32 lineHeight;
+
+    oc_list shelves; // sorted by y, covering the whole atlas height
+    oc_list shelfFreeList;
+    oc_list spanFreeList;
+
+    u32 allocCount;
+    i64 usedArea;
 
 } oc_rect_atlas;
 
+static i32 oc_rect_atlas_shelf_height(i32 h)
+{
+    //NOTE: round heights up to a step proportional to the height, to limit the number of size classes
+    i32 step = 4;
+    while(step * 8 < h)
+    {
+        step *= 2;
+    }
+    return ((h + step - 1) / step * step);
+}
+
+static oc_rect_atlas_shelf* oc_rect_atlas_shelf_alloc(oc_rect_atlas* atlas, i32 y, i32 h)
+{
+    oc_rect_atlas_shelf* shelf = oc_list_pop_entry(&atlas->shelfFreeList, oc_rect_atlas_shelf, listElt);
+    if(!shelf)
+    {
+        shelf = oc_arena_push_type(atlas->arena, oc_rect_atlas_shelf);
+    }
+    memset(shelf, 0, sizeof(oc_rect_atlas_shelf));
+    shelf->y = y;
+    shelf->h = h;
+    shelf->isFree = true;
+    return (shelf);
+}
+
+static oc_rect_atlas_span* oc_rect_atlas_span_alloc(oc_rect_atlas* atlas, i32 x, i32 w)
+{
+    oc_rect_atlas_span* span = oc_list_pop_entry(&atlas->spanFreeList, oc_rect_atlas_span, listElt);
+    if(!span)
+    {
+        span = oc_arena_push_type(atlas->arena, oc_rect_atlas_span);
+    }
+    span->x = x;
+    span->w = w;
+    return (span);
+}
+
+static void oc_rect_atlas_shelf_release_spans(oc_rect_atlas* atlas, oc_rect_atlas_shelf* shelf)
+{
+    oc_list_for_safe(shelf->freeSpans, span, oc_rect_atlas_span, listElt)
+    {
+        oc_list_remove(&shelf->freeSpans, &span->listElt);
+        oc_list_push(&atlas->spanFreeList, &span->listElt);
+    }
+}
+
+void oc_rect_atlas_clear(oc_rect_atlas* atlas)
+{
+    oc_list_for_safe(atlas->shelves, shelf, oc_rect_atlas_shelf, listElt)
+    {
+        oc_rect_atlas_shelf_release_spans(atlas, shelf);
+        oc_list_remove(&atlas->shelves, &shelf->listElt);
+        oc_list_push(&atlas->shelfFreeList, &shelf->listElt);
+    }
+    atlas->allocCount = 0;
+    atlas->usedArea = 0;
+
+    oc_rect_atlas_shelf* shelf = oc_rect_atlas_shelf_alloc(atlas, 0, atlas->size.y);
+    oc_list_push(&atlas->shelves, &shelf->listElt);
+}
+
 oc_rect_atlas* oc_rect_atlas_create(oc_arena* arena, i32 width, i32 height)
 {
     oc_rect_atlas* atlas = oc_arena_push_type(arena, oc_rect_atlas);
     memset(atlas, 0, sizeof(oc_rect_atlas));
     atlas->arena = arena;
     atlas->size = (oc_vec2i){ width, height };
+    oc_rect_atlas_clear(atlas);
     return (atlas);
 }
 
+static oc_rect_atlas_span* oc_rect_atlas_shelf_find_span(oc_rect_atlas_shelf* shelf, i32 w)
+{
+    oc_list_for(shelf->freeSpans, span, oc_rect_atlas_span, listElt)
+    {
+        if(span->w >= w)
+        {
+            return (span);
+        }
+    }
+    return (0);
+}
+
 oc_rect oc_rect_atlas_alloc(oc_rect_atlas* atlas, i32 width, i32 height)
 {
     oc_rect rect = { 0, 0, 0, 0 };
-    if(width > 0 && height > 0)
+    if(width <= 0 || height <= 0)
     {
-        if(atlas->pos.x + width >= atlas->size.x)
+        return (rect);
+    }
+
+    i32 w = width + 1;
+    i32 h = oc_rect_atlas_shelf_height(height + 1);
+
+    //NOTE: look for a span in a shelf of the same size class, then for a free shelf to split,
+    //      and finally for a span in the smallest taller shelf, up to twice the needed height
+    oc_rect_atlas_shelf* shelf = 0;
+    oc_rect_atlas_span* span = 0;
+    oc_rect_atlas_shelf* freeShelf = 0;
+    oc_rect_atlas_shelf* tallerShelf = 0;
+    oc_rect_atlas_span* tallerSpan = 0;
+
+    oc_list_for(atlas->shelves, it, oc_rect_atlas_shelf, listElt)
+    {
+        if(it->isFree)
+        {
+            if(!freeShelf && it->h >= h)
+            {
+                freeShelf = it;
+            }
+        }
+        else if(it->h == h)
+        {
+            span = oc_rect_atlas_shelf_find_span(it, w);
+            if(span)
+            {
+                shelf = it;
+                break;
+            }
+        }
+        else if(it->h > h && it->h <= 2 * h && (!tallerShelf || it->h < tallerShelf->h))
         {
-            atlas->pos.x = 0;
-            atlas->pos.y += (atlas->lineHeight + 1);
-            atlas->lineHeight = 0;
+            oc_rect_atlas_span* candidate = oc_rect_atlas_shelf_find_span(it, w);
+            if(candidate)
+            {
+                tallerShelf = it;
+                tallerSpan = candidate;
+            }
         }
-        if(atlas->pos.x + width < atlas->size.x
-           && atlas->pos.y + height < atlas->size.y)
+    }
+
+    if(!shelf && freeShelf && w <= atlas->size.x)
+    {
+        //NOTE: carve a new shelf from the top of the free shelf
+        if(freeShelf->h > h)
         {
-            rect = (oc_rect){ atlas->pos.x, atlas->pos.y, width, height };
+            oc_rect_atlas_shelf* rest = oc_rect_atlas_shelf_alloc(atlas, freeShelf->y + h, freeShelf->h - h);
+            oc_list_insert(&atlas->shelves, &freeShelf->listElt, &rest->listElt);
+            freeShelf->h = h;
+        }
+        shelf = freeShelf;
+        shelf->isFree = false;
+        span = oc_rect_atlas_span_alloc(atlas, 0, atlas->size.x);
+        oc_list_push(&shelf->freeSpans, &span->listElt);
+    }
+
+    if(!shelf && tallerShelf)
+    {
+        shelf = tallerShelf;
+        span = tallerSpan;
+    }
 
-            atlas->pos.x += (width + 1);
-            atlas->lineHeight = oc_max(atlas->lineHeight, height);
+    if(shelf)
+    {
+        rect = (oc_rect){ span->x, shelf->y, width, height };
+
+        span->x += w;
+        span->w -= w;
+        if(span->w == 0)
+        {
+            oc_list_remove(&shelf->freeSpans, &span->listElt);
+            oc_list_push(&atlas->spanFreeList, &span->listElt);
         }
+
+        shelf->allocCount++;
+        atlas->allocCount++;
+        atlas->usedArea += (i64)w * (height + 1);
     }
     return (rect);
 }
 
 void oc_rect_atlas_recycle(oc_rect_atlas* atlas, oc_rect rect)
 {
-    //TODO
+    if(rect.w <= 0 || rect.h <= 0)
+    {
+        return;
+    }
+
+    i32 x = rect.x;
+    i32 y = rect.y;
+    i32 w = rect.w + 1;
+
+    oc_rect_atlas_shelf* shelf = 0;
+    oc_list_for(atlas->shelves, it, oc_rect_atlas_shelf, listElt)
+    {
+        if(it->y == y && !it->isFree)
+        {
+            shelf = it;
+            break;
+        }
+    }
+    if(!shelf)
+    {
+        return;
+    }
+
+    atlas->allocCount--;
+    atlas->usedArea -= (i64)w * (rect.h + 1);
+    shelf->allocCount--;
+
+    if(shelf->allocCount == 0)
+    {
+        //NOTE: the shelf is empty, free it and merge it with its free neighbours
+        oc_rect_atlas_shelf_release_spans(atlas, shelf);
+        shelf->isFree = true;
+
+        oc_rect_atlas_shelf* next = oc_list_next_entry(atlas->shelves, shelf, oc_rect_atlas_shelf, listElt);
+        if(next && next->isFree)
+        {
+            shelf->h += next->h;
+            oc_list_remove(&atlas->shelves, &next->listElt);
+            oc_list_push(&atlas->shelfFreeList, &next->listElt);
+        }
+        oc_rect_atlas_shelf* prev = oc_list_prev_entry(atlas->shelves, shelf, oc_rect_atlas_shelf, listElt);
+        if(prev && prev->isFree)
+        {
+            prev->h += shelf->h;
+            oc_list_remove(&atlas->shelves, &shelf->listElt);
+            oc_list_push(&atlas->shelfFreeList, &shelf->listElt);
+        }
+        return;
+    }
+
+    //NOTE: insert the span in x order, merging it with adjacent free spans
+    oc_rect_atlas_span* prev = 0;
+    oc_rect_atlas_span* next = 0;
+    oc_list_for(shelf->freeSpans, it, oc_rect_atlas_span, listElt)
+    {
+        if(it->x > x)
+        {
+            next = it;
+            break;
+        }
+        prev = it;
+    }
+
+    if(prev && prev->x + prev->w == x)
+    {
+        prev->w += w;
+        if(next && prev->x + prev->w == next->x)
+        {
+            prev->w += next->w;
+            oc_list_remove(&shelf->freeSpans, &next->listElt);
+            oc_list_push(&atlas->spanFreeList, &next->listElt);
+        }
+    }
+    else if(next && x + w == next->x)
+    {
+        next->x = x;
+        next->w += w;
+    }
+    else
+    {
+        oc_rect_atlas_span* span = oc_rect_atlas_span_alloc(atlas, x, w);
+        if(prev)
+        {
+            oc_list_insert(&shelf->freeSpans, &prev->listElt, &span->listElt);
+        }
+        else
+        {
+            oc_list_push(&shelf->freeSpans, &span->listElt);
+        }
+    }
+}
+
+oc_rect_atlas_stats oc_rect_atlas_get_stats(oc_rect_atlas* atlas)
+{
+    oc_rect_atlas_stats stats = { .allocCount = atlas->allocCount };
+
+    i64 freeArea = 0;
+    i64 largestFreeArea = 0;
+    oc_list_for(atlas->shelves, shelf, oc_rect_atlas_shelf, listElt)
+    {
+        if(shelf->isFree)
+        {
+            i64 area = (i64)atlas->size.x * shelf->h;
+            freeArea += area;
+            largestFreeArea = oc_max(largestFreeArea, area);
+            stats.freeRectCount++;
+        }
+        else
+        {
+            oc_list_for(shelf->freeSpans, span, oc_rect_atlas_span, listElt)
+            {
+                i64 area = (i64)span->w * shelf->h;
+                freeArea += area;
+                largestFreeArea = oc_max(largestFreeArea, area);
+                stats.freeRectCount++;
+            }
+        }
+    }
+
+    //NOTE: the free area doesn't include the space lost above rectangles shorter than their shelf
+    i64 totalArea = (i64)atlas->size.x * atlas->size.y;
+    stats.occupancy = totalArea ? (f32)atlas->usedArea / totalArea : 0;
+    stats.fragmentation = freeArea ? 1 - (f32)largestFreeArea / freeArea : 0;
+    return (stats);
+}
+
+u32 oc_rect_atlas_defragment(oc_rect_atlas* atlas, u32 count, oc_rect* rects)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    //NOTE: repack from scratch, placing taller rectangles first
+    u32* order = oc_arena_push_array(scratch.arena, u32, count);
+    for(u32 i = 0; i < count; i++)
+    {
+        u32 j = i;
+        while(j > 0 && (rects[order[j - 1]].h < rects[i].h
+                        || (rects[order[j - 1]].h == rects[i].h && rects[order[j - 1]].w < rects[i].w)))
+        {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    oc_rect_atlas_clear(atlas);
+
+    u32 placedCount = 0;
+    for(u32 i = 0; i < count; i++)
+    {
+        oc_rect* rect = &rects[order[i]];
+        *rect = oc_rect_atlas_alloc(atlas, rect->w, rect->h);
+        if(rect->w)
+        {
+            placedCount++;
+        }
+    }
+
+    oc_scratch_end(scratch);
+    return (placedCount);
 }
 
 oc_image_region oc_image_atlas_alloc_from_rgba8(oc_rect_atlas* atlas, oc_image backingImage, u32 width, u32 height, u8* pixels)
@@ -1893,10 +3440,13 @@ oc_image_region oc_image_atlas_alloc_from_memory(oc_rect_atlas* atlas, oc_image
 
     int width, height, channels;
 
-    stbi_set_flip_vertically_on_load(flip ? 1 : 0);
     u8* pixels = stbi_load_from_memory((u8*)mem.ptr, mem.len, &width, &height, &channels, 4);
     if(pixels)
     {
+        if(flip)
+        {
+            oc_image_flip_rows_rgba8(pixels, width, height);
+        }
         imageRgn = oc_image_atlas_alloc_from_rgba8(atlas, backingImage, width, height, pixels);
         free(pixels);
     }
@@ -1947,3 +3497,28 @@ void oc_image_atlas_recycle(oc_rect_atlas* atlas, oc_image_region imageRgn)
 {
     oc_rect_atlas_recycle(atlas, imageRgn.rect);
 }
+
+u32 oc_image_atlas_defragment(oc_rect_atlas* atlas, u32 count, oc_image_region* regions, u8** pixels)
+{
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    oc_rect* rects = oc_arena_push_array(scratch.arena, oc_rect, count);
+    for(u32 i = 0; i < count; i++)
+    {
+        rects[i] = regions[i].rect;
+    }
+
+    u32 placedCount = oc_rect_atlas_defragment(atlas, count, rects);
+
+    for(u32 i = 0; i < count; i++)
+    {
+        regions[i].rect = rects[i];
+        if(rects[i].w)
+        {
+            oc_image_upload_region_rgba8(regions[i].image, rects[i], pixels[i]);
+        }
+    }
+
+    oc_scratch_end(scratch);
+    return (placedCount);
+}
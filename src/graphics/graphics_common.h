@@ -18,13 +18,38 @@ typedef enum
     OC_PATH_MOVE,
     OC_PATH_LINE,
     OC_PATH_QUADRATIC,
-    OC_PATH_CUBIC
+    OC_PATH_CUBIC,
+    OC_PATH_GLYPH_DEF,
+    OC_PATH_GLYPH,
 } oc_path_elt_type;
 
+//NOTE: glyph runs are encoded as one OC_PATH_GLYPH element per glyph, referencing the outlines of the glyph
+//      in font units. Outlines are stored once per frame, in an OC_PATH_GLYPH_DEF element followed by its
+//      outline elements, which are not drawn by themselves. Glyph elements only appear in fill paths.
 typedef struct oc_path_elt
 {
     oc_path_elt_type type;
-    oc_vec2 p[3];
+
+    union
+    {
+        oc_vec2 p[3];
+
+        struct
+        {
+            oc_vec2 origin;
+            oc_vec2 scale;
+            u32 defIndex;    // index of the OC_PATH_GLYPH_DEF element in the element buffer
+            u32 outlineHash; // hash of the glyph's outlines, stable across frames unlike defIndex
+        } glyph;
+
+        struct
+        {
+            u32 count; // number of outline elements following this element
+            u32 reserved;
+            oc_vec2 min; // bounding box of the outlines, in font units
+            oc_vec2 max;
+        } glyphDef;
+    };
 
 } oc_path_elt;
 
@@ -77,6 +102,15 @@ typedef struct oc_primitive
 
 } oc_primitive;
 
+enum
+{
+    //NOTE: maximum number of times backends split a stroked curve to get its offset within tolerance
+    OC_STROKE_MAX_SPLIT_DEPTH = 16,
+};
+
+ORCA_API oc_vec4 oc_primitive_screen_bounds(oc_primitive* primitive, oc_path_elt* elements);
+ORCA_API f32 oc_primitive_stroke_tolerance(oc_primitive* primitive, oc_vec4 screenBounds);
+
 ORCA_API void oc_surface_render_commands(oc_surface surface,
                                          oc_color clearColor,
                                          u32 primitiveCount,
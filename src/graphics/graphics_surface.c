@@ -7,6 +7,7 @@
 **************************************************************************/
 
 #include "graphics_surface.h"
+#include "platform/platform_thread.h"
 
 //---------------------------------------------------------------
 // per-thread selected surface
@@ -47,6 +48,249 @@ oc_image_data* oc_image_data_from_handle(oc_image handle)
     return (data);
 }
 
+//---------------------------------------------------------------
+// asynchronous image decoding
+//---------------------------------------------------------------
+
+enum
+{
+    OC_IMAGE_DECODE_WORKER_COUNT = 2,
+};
+
+typedef struct oc_image_decode_job
+{
+    oc_list_elt listElt;
+    oc_image image;
+    oc_surface surface;
+    oc_str8 mem;
+    bool flip;
+
+    u8* pixels;
+    int width;
+    int height;
+
+    bool orphaned; // the surface was destroyed while the job was being decoded, protected by mutex
+
+} oc_image_decode_job;
+
+typedef struct oc_image_decoder
+{
+    bool init;
+    oc_mutex* mutex;
+    oc_condition* condition;
+    oc_thread* workers[OC_IMAGE_DECODE_WORKER_COUNT];
+
+    oc_list pendingJobs;   // waiting for a worker, protected by mutex
+    oc_list activeJobs;    // being decoded by a worker, protected by mutex
+    oc_list completedJobs; // decoded (or failed), waiting to be uploaded, protected by mutex
+    u32 jobCount;          // jobs that haven't been finalized yet, only touched by the rendering thread
+    bool quit;             // protected by mutex
+
+} oc_image_decoder;
+
+static oc_image_decoder oc_imageDecoder = { 0 };
+
+static void oc_image_decode_job_free(oc_image_decode_job* job)
+{
+    free(job->mem.ptr);
+    free(job->pixels);
+    free(job);
+}
+
+i32 oc_image_decode_worker(void* userPointer)
+{
+    while(true)
+    {
+        oc_mutex_lock(oc_imageDecoder.mutex);
+        while(oc_list_empty(oc_imageDecoder.pendingJobs) && !oc_imageDecoder.quit)
+        {
+            oc_condition_wait(oc_imageDecoder.condition, oc_imageDecoder.mutex);
+        }
+        if(oc_imageDecoder.quit)
+        {
+            oc_mutex_unlock(oc_imageDecoder.mutex);
+            break;
+        }
+        oc_image_decode_job* job = oc_list_pop_entry(&oc_imageDecoder.pendingJobs, oc_image_decode_job, listElt);
+        oc_list_push_back(&oc_imageDecoder.activeJobs, &job->listElt);
+        oc_mutex_unlock(oc_imageDecoder.mutex);
+
+        int channels = 0;
+        job->pixels = stbi_load_from_memory((u8*)job->mem.ptr, job->mem.len, &job->width, &job->height, &channels, 4);
+        if(job->pixels && job->flip)
+        {
+            oc_image_flip_rows_rgba8(job->pixels, job->width, job->height);
+        }
+        free(job->mem.ptr);
+        job->mem = (oc_str8){ 0 };
+
+        oc_mutex_lock(oc_imageDecoder.mutex);
+        oc_list_remove(&oc_imageDecoder.activeJobs, &job->listElt);
+        bool orphaned = job->orphaned;
+        if(orphaned)
+        {
+            oc_image_decode_job_free(job);
+        }
+        else
+        {
+            oc_list_push_back(&oc_imageDecoder.completedJobs, &job->listElt);
+        }
+        oc_mutex_unlock(oc_imageDecoder.mutex);
+
+        if(!orphaned)
+        {
+            //NOTE: the image is only swapped in by the next render of its surface, so wake up a runloop
+            //      that is idling in oc_wait_events()
+            oc_wakeup_events();
+        }
+    }
+    return (0);
+}
+
+void oc_image_decoder_init()
+{
+    oc_imageDecoder.mutex = oc_mutex_create();
+    oc_imageDecoder.condition = oc_condition_create();
+    for(int i = 0; i < OC_IMAGE_DECODE_WORKER_COUNT; i++)
+    {
+        oc_imageDecoder.workers[i] = oc_thread_create(oc_image_decode_worker, 0);
+    }
+    oc_imageDecoder.init = true;
+}
+
+void oc_image_decoder_cleanup()
+{
+    if(!oc_imageDecoder.init)
+    {
+        return;
+    }
+
+    //NOTE: workers finish the job they're decoding before exiting, the remaining jobs are dropped
+    oc_mutex_lock(oc_imageDecoder.mutex);
+    oc_imageDecoder.quit = true;
+    oc_condition_broadcast(oc_imageDecoder.condition);
+    oc_mutex_unlock(oc_imageDecoder.mutex);
+
+    for(int i = 0; i < OC_IMAGE_DECODE_WORKER_COUNT; i++)
+    {
+        oc_thread_join(oc_imageDecoder.workers[i], NULL);
+    }
+
+    oc_list_for_safe(oc_imageDecoder.pendingJobs, job, oc_image_decode_job, listElt)
+    {
+        oc_image_decode_job_free(job);
+    }
+    oc_list_for_safe(oc_imageDecoder.completedJobs, job, oc_image_decode_job, listElt)
+    {
+        oc_image_decode_job_free(job);
+    }
+
+    oc_condition_destroy(oc_imageDecoder.condition);
+    oc_mutex_destroy(oc_imageDecoder.mutex);
+    memset(&oc_imageDecoder, 0, sizeof(oc_image_decoder));
+}
+
+static void oc_image_decoder_drop_surface_jobs(oc_surface surface)
+{
+    //NOTE: free the jobs of a destroyed surface. Jobs that are being decoded are freed by their worker when it's done.
+    if(!oc_imageDecoder.jobCount)
+    {
+        return;
+    }
+
+    oc_mutex_lock(oc_imageDecoder.mutex);
+    oc_list_for_safe(oc_imageDecoder.pendingJobs, job, oc_image_decode_job, listElt)
+    {
+        if(job->surface.h == surface.h)
+        {
+            oc_list_remove(&oc_imageDecoder.pendingJobs, &job->listElt);
+            oc_image_decode_job_free(job);
+            oc_imageDecoder.jobCount--;
+        }
+    }
+    oc_list_for_safe(oc_imageDecoder.completedJobs, job, oc_image_decode_job, listElt)
+    {
+        if(job->surface.h == surface.h)
+        {
+            oc_list_remove(&oc_imageDecoder.completedJobs, &job->listElt);
+            oc_image_decode_job_free(job);
+            oc_imageDecoder.jobCount--;
+        }
+    }
+    oc_list_for(oc_imageDecoder.activeJobs, job, oc_image_decode_job, listElt)
+    {
+        if(job->surface.h == surface.h)
+        {
+            job->orphaned = true;
+            oc_imageDecoder.jobCount--;
+        }
+    }
+    oc_mutex_unlock(oc_imageDecoder.mutex);
+}
+
+void oc_image_decoder_finalize_jobs(oc_surface surface)
+{
+    //NOTE: swap decoded images in place of their placeholder. This must be called with the surface selected.
+    if(!oc_imageDecoder.jobCount)
+    {
+        return;
+    }
+
+    oc_list completed = { 0 };
+
+    oc_mutex_lock(oc_imageDecoder.mutex);
+    oc_list_for_safe(oc_imageDecoder.completedJobs, job, oc_image_decode_job, listElt)
+    {
+        if(job->surface.h == surface.h)
+        {
+            oc_list_remove(&oc_imageDecoder.completedJobs, &job->listElt);
+            oc_list_push_back(&completed, &job->listElt);
+        }
+    }
+    oc_mutex_unlock(oc_imageDecoder.mutex);
+
+    if(oc_list_empty(completed))
+    {
+        return;
+    }
+
+    oc_surface_data* surfaceData = oc_surface_data_from_handle(surface);
+
+    oc_list_for_safe(completed, job, oc_image_decode_job, listElt)
+    {
+        //NOTE: if the image was destroyed while decoding, its handle doesn't resolve anymore and we just drop the result
+        oc_image_data* placeholder = oc_image_data_from_handle(job->image);
+        if(placeholder && placeholder->pending && surfaceData && surfaceData->backend)
+        {
+            oc_canvas_backend* backend = surfaceData->backend;
+            placeholder->pending = false;
+
+            if(job->pixels)
+            {
+                oc_image_data* imageData = backend->imageCreate(backend, (oc_vec2){ job->width, job->height }, 1);
+                if(imageData)
+                {
+                    imageData->surface = surface;
+                    imageData->pending = false;
+                    backend->imageUploadRegion(backend, imageData, (oc_rect){ 0, 0, job->width, job->height }, job->pixels);
+
+                    oc_graphics_handle_set_data(job->image.h, imageData);
+                    backend->imageDestroy(backend, placeholder);
+                }
+            }
+            else
+            {
+                oc_log_error("couldn't decode image, leaving it empty.\n");
+            }
+        }
+        oc_image_decode_job_free(job);
+        oc_imageDecoder.jobCount--;
+    }
+
+    //NOTE: the frame that was just rendered still drew the placeholders, so we need another one to show the images
+    oc_wakeup_events();
+}
+
 //---------------------------------------------------------------
 // surface API
 //---------------------------------------------------------------
@@ -166,6 +410,8 @@ void oc_surface_destroy(oc_surface handle)
             oc_surface_deselect();
         }
 
+        oc_image_decoder_drop_surface_jobs(handle);
+
         if(surface->backend && surface->backend->destroy)
         {
             surface->backend->destroy(surface->backend);
@@ -296,13 +542,57 @@ void oc_surface_render_commands(oc_surface surface,
     }
     else if(surfaceData && surfaceData->backend)
     {
+        if(oc_imageDecoder.jobCount)
+        {
+            //NOTE: draws of images that are still being decoded are skipped
+            for(u32 i = 0; i < primitiveCount; i++)
+            {
+                oc_primitive* primitive = &primitives[i];
+                if(!oc_image_is_nil(primitive->attributes.image))
+                {
+                    oc_image_data* imageData = oc_image_data_from_handle(primitive->attributes.image);
+                    if(imageData && imageData->pending)
+                    {
+                        primitive->attributes.image = oc_image_nil();
+                        primitive->attributes.color.a = 0;
+                    }
+                }
+            }
+        }
+
         surfaceData->backend->render(surfaceData->backend,
                                      clearColor,
                                      primitiveCount,
                                      primitives,
                                      eltCount,
                                      elements);
+
+        //NOTE: decoded images are swapped in after rendering, so that the commands of a frame
+        //      always see a consistent image size
+        oc_image_decoder_finalize_jobs(surface);
+    }
+}
+
+u32 oc_surface_get_damage(oc_surface surface, u32 maxRectCount, oc_rect* rects)
+{
+    u32 count = 0;
+    oc_surface_data* surfaceData = oc_surface_data_from_handle(surface);
+    if(surfaceData && maxRectCount)
+    {
+        if(surfaceData->backend && surfaceData->backend->getDamage)
+        {
+            count = surfaceData->backend->getDamage(surfaceData->backend, maxRectCount, rects);
+        }
+        else
+        {
+            //NOTE: backends that don't track damage redraw the whole surface
+            oc_vec2 size = oc_surface_get_size(surface);
+            oc_vec2 scaling = oc_surface_contents_scaling(surface);
+            rects[0] = (oc_rect){ 0, 0, size.x * scaling.x, size.y * scaling.y };
+            count = 1;
+        }
     }
+    return (count);
 }
 
 void oc_surface_bring_to_front(oc_surface handle)
@@ -331,14 +621,48 @@ oc_vec2 oc_image_size(oc_image image)
 {
     oc_vec2 res = { 0 };
     oc_image_data* imageData = oc_image_data_from_handle(image);
-    if(imageData)
+    if(imageData && !imageData->pending)
     {
         res = imageData->size;
     }
     return (res);
 }
 
-oc_image oc_image_create(oc_surface surface, u32 width, u32 height)
+u32 oc_image_mip_level_count(oc_vec2 size)
+{
+    u32 levelCount = 1;
+    u32 maxSize = oc_max(size.x, size.y);
+    while(maxSize > 1)
+    {
+        maxSize >>= 1;
+        levelCount++;
+    }
+    return (levelCount);
+}
+
+f32 oc_image_sample_lod(oc_image image, oc_mat2x3 uvTransform, f32 scale)
+{
+    //NOTE: uvTransform maps user space to normalized texture coordinates. We pick the level whose texels
+    //      best match the texel footprint of one device pixel, using the largest of the two screen axes.
+    f32 lod = 0;
+    oc_image_data* imageData = oc_image_data_from_handle(image);
+    if(imageData && imageData->levelCount > 1)
+    {
+        f32 dudx = uvTransform.m[0] * imageData->size.x / scale;
+        f32 dvdx = uvTransform.m[3] * imageData->size.y / scale;
+        f32 dudy = uvTransform.m[1] * imageData->size.x / scale;
+        f32 dvdy = uvTransform.m[4] * imageData->size.y / scale;
+
+        f32 footprint = oc_max(dudx * dudx + dvdx * dvdx, dudy * dudy + dvdy * dvdy);
+        if(footprint > 1)
+        {
+            lod = oc_min(0.5f * log2f(footprint), (f32)(imageData->levelCount - 1));
+        }
+    }
+    return (lod);
+}
+
+static oc_image oc_image_create_with_levels(oc_surface surface, u32 width, u32 height, u32 levelCount)
 {
     oc_image image = oc_image_nil();
     oc_surface_data* surfaceData = oc_surface_data_from_handle(surface);
@@ -351,16 +675,28 @@ oc_image oc_image_create(oc_surface surface, u32 width, u32 height)
     {
         OC_DEBUG_ASSERT(surfaceData->api == OC_CANVAS);
 
-        oc_image_data* imageData = surfaceData->backend->imageCreate(surfaceData->backend, (oc_vec2){ width, height });
+        oc_image_data* imageData = surfaceData->backend->imageCreate(surfaceData->backend, (oc_vec2){ width, height }, levelCount);
         if(imageData)
         {
             imageData->surface = surface;
+            imageData->pending = false;
             image = oc_image_handle_alloc(imageData);
         }
     }
     return (image);
 }
 
+oc_image oc_image_create(oc_surface surface, u32 width, u32 height)
+{
+    return (oc_image_create_with_levels(surface, width, height, 1));
+}
+
+oc_image oc_image_create_mipmapped(oc_surface surface, u32 width, u32 height)
+{
+    u32 levelCount = oc_image_mip_level_count((oc_vec2){ width, height });
+    return (oc_image_create_with_levels(surface, width, height, levelCount));
+}
+
 void oc_image_destroy(oc_image image)
 {
     oc_image_data* imageData = oc_image_data_from_handle(image);
@@ -393,6 +729,10 @@ void oc_image_upload_region_rgba8(oc_image image, oc_rect region, u8* pixels)
         {
             oc_log_error("surface is not selected. Make sure to call oc_surface_select() before modifying graphics resources.\n");
         }
+        else if(imageData->pending)
+        {
+            oc_log_error("image is still being decoded. Make sure oc_image_is_ready() returns true before modifying it.\n");
+        }
         else
         {
             oc_surface_data* surfaceData = oc_surface_data_from_handle(imageData->surface);
@@ -404,3 +744,46 @@ void oc_image_upload_region_rgba8(oc_image image, oc_rect region, u8* pixels)
         }
     }
 }
+
+oc_image oc_image_create_from_memory_async(oc_surface surface, oc_str8 mem, bool flip)
+{
+    //NOTE: create a transparent 1x1 placeholder now, and queue the decoding on a worker thread.
+    //      The placeholder is replaced by the decoded image after the next render of its surface.
+    oc_image image = oc_image_create(surface, 1, 1);
+    if(!oc_image_is_nil(image))
+    {
+        u8 transparent[4] = { 0 };
+        oc_image_upload_region_rgba8(image, (oc_rect){ 0, 0, 1, 1 }, transparent);
+
+        oc_image_data* imageData = oc_image_data_from_handle(image);
+        imageData->pending = true;
+
+        if(!oc_imageDecoder.init)
+        {
+            oc_image_decoder_init();
+        }
+
+        oc_image_decode_job* job = oc_malloc_type(oc_image_decode_job);
+        memset(job, 0, sizeof(oc_image_decode_job));
+        job->image = image;
+        job->surface = surface;
+        job->flip = flip;
+        job->mem.ptr = malloc(mem.len);
+        job->mem.len = mem.len;
+        memcpy(job->mem.ptr, mem.ptr, mem.len);
+
+        oc_imageDecoder.jobCount++;
+
+        oc_mutex_lock(oc_imageDecoder.mutex);
+        oc_list_push_back(&oc_imageDecoder.pendingJobs, &job->listElt);
+        oc_condition_signal(oc_imageDecoder.condition);
+        oc_mutex_unlock(oc_imageDecoder.mutex);
+    }
+    return (image);
+}
+
+bool oc_image_is_ready(oc_image image)
+{
+    oc_image_data* imageData = oc_image_data_from_handle(image);
+    return (imageData && !imageData->pending);
+}
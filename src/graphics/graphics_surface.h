@@ -65,6 +65,9 @@ void oc_surface_init_for_window(oc_surface_data* surface, oc_window_data* window
 void oc_surface_cleanup(oc_surface_data* surface);
 void* oc_surface_native_layer(oc_surface surface);
 
+//NOTE: stops the image decoding workers and frees the remaining jobs, called by oc_terminate()
+void oc_image_decoder_cleanup(void);
+
 //---------------------------------------------------------------
 // canvas backend interface
 //---------------------------------------------------------------
@@ -74,12 +77,14 @@ typedef struct oc_image_data
     u32 generation;
     oc_surface surface;
     oc_vec2 size;
+    u32 levelCount; // number of mip levels, 1 for images that aren't mipmapped
+    bool pending;   // contents are still being decoded, see oc_image_create_from_memory_async()
 
 } oc_image_data;
 
 typedef void (*oc_canvas_backend_destroy_proc)(oc_canvas_backend* backend);
 
-typedef oc_image_data* (*oc_canvas_backend_image_create_proc)(oc_canvas_backend* backend, oc_vec2 size);
+typedef oc_image_data* (*oc_canvas_backend_image_create_proc)(oc_canvas_backend* backend, oc_vec2 size, u32 levelCount);
 typedef void (*oc_canvas_backend_image_destroy_proc)(oc_canvas_backend* backend, oc_image_data* image);
 typedef void (*oc_canvas_backend_image_upload_region_proc)(oc_canvas_backend* backend,
                                                            oc_image_data* image,
@@ -93,6 +98,8 @@ typedef void (*oc_canvas_backend_render_proc)(oc_canvas_backend* backend,
                                               u32 eltCount,
                                               oc_path_elt* pathElements);
 
+typedef u32 (*oc_canvas_backend_get_damage_proc)(oc_canvas_backend* backend, u32 maxRectCount, oc_rect* rects);
+
 typedef struct oc_canvas_backend
 {
     oc_canvas_backend_destroy_proc destroy;
@@ -102,9 +109,13 @@ typedef struct oc_canvas_backend
     oc_canvas_backend_image_upload_region_proc imageUploadRegion;
 
     oc_canvas_backend_render_proc render;
+    oc_canvas_backend_get_damage_proc getDamage;
 
 } oc_canvas_backend;
 
+u32 oc_image_mip_level_count(oc_vec2 size);
+f32 oc_image_sample_lod(oc_image image, oc_mat2x3 uvTransform, f32 scale);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
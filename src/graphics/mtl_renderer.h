@@ -24,6 +24,7 @@ typedef struct oc_mtl_path
     vector_float4 box;
     vector_float4 clip;
     int texture;
+    float lod;
 } oc_mtl_path;
 
 typedef enum
@@ -68,6 +68,7 @@ typedef struct oc_mtl_canvas_backend
     int pathBatchStart;
 
     oc_primitive* primitive;
+    f32 tolerance; // stroke flattening tolerance of the current primitive, in user space
     oc_vec4 pathScreenExtents;
     oc_vec4 pathUserExtents;
 
@@ -253,6 +254,11 @@ void oc_mtl_encode_path(oc_mtl_canvas_backend* backend, oc_primitive* primitive,
         path->uvTransform = simd_matrix(simd_make_float3(uvTransform.m[0] / scale, uvTransform.m[3] / scale, 0),
                                         simd_make_float3(uvTransform.m[1] / scale, uvTransform.m[4] / scale, 0),
                                         simd_make_float3(uvTransform.m[2], uvTransform.m[5], 1));
+        path->lod = oc_image_sample_lod(primitive->attributes.image, uvTransform, scale);
+    }
+    else
+    {
+        path->lod = 0;
     }
     path->texture = backend->currentImageIndex;
 
@@ -481,10 +487,10 @@ void oc_mtl_render_stroke_line(oc_mtl_canvas_backend* backend, oc_vec2* p)
     oc_mtl_canvas_encode_element(backend, OC_PATH_LINE, joint1);
 }
 
-void oc_mtl_render_stroke_quadratic(oc_mtl_canvas_backend* backend, oc_vec2* p)
+void oc_mtl_render_stroke_quadratic(oc_mtl_canvas_backend* backend, oc_vec2* p, int depth)
 {
     f32 width = backend->primitive->attributes.width;
-    f32 tolerance = oc_min(backend->primitive->attributes.tolerance, 0.5 * width);
+    f32 tolerance = backend->tolerance;
 
     //NOTE: check for degenerate line case
     const f32 equalEps = 1e-3;
@@ -505,13 +511,21 @@ void oc_mtl_render_stroke_quadratic(oc_mtl_canvas_backend* backend, oc_vec2* p)
     if(!oc_offset_hull(3, p, leftHull, width / 2)
        || !oc_offset_hull(3, p, rightHull, -width / 2))
     {
-        //TODO split and recurse
-        //NOTE: offsetting the hull failed, split the curve
-        oc_vec2 splitLeft[3];
-        oc_vec2 splitRight[3];
-        oc_quadratic_split(p, 0.5, splitLeft, splitRight);
-        oc_mtl_render_stroke_quadratic(backend, splitLeft);
-        oc_mtl_render_stroke_quadratic(backend, splitRight);
+        if(depth >= OC_STROKE_MAX_SPLIT_DEPTH)
+        {
+            //NOTE: stop splitting and stroke the chord
+            oc_vec2 line[2] = { p[0], p[2] };
+            oc_mtl_render_stroke_line(backend, line);
+        }
+        else
+        {
+            //NOTE: offsetting the hull failed, split the curve
+            oc_vec2 splitLeft[3];
+            oc_vec2 splitRight[3];
+            oc_quadratic_split(p, 0.5, splitLeft, splitRight);
+            oc_mtl_render_stroke_quadratic(backend, splitLeft, depth + 1);
+            oc_mtl_render_stroke_quadratic(backend, splitRight, depth + 1);
+        }
     }
     else
     {
@@ -546,13 +560,14 @@ void oc_mtl_render_stroke_quadratic(oc_mtl_canvas_backend* backend, oc_vec2* p)
             }
         }
 
-        if(maxOvershoot > 0)
+        //NOTE: past the maximum depth, the hull is used as is even if it's not within tolerance
+        if(maxOvershoot > 0 && depth < OC_STROKE_MAX_SPLIT_DEPTH)
         {
             oc_vec2 splitLeft[3];
             oc_vec2 splitRight[3];
             oc_quadratic_split(p, maxOvershootParameter, splitLeft, splitRight);
-            oc_mtl_render_stroke_quadratic(backend, splitLeft);
-            oc_mtl_render_stroke_quadratic(backend, splitRight);
+            oc_mtl_render_stroke_quadratic(backend, splitLeft, depth + 1);
+            oc_mtl_render_stroke_quadratic(backend, splitRight, depth + 1);
         }
         else
         {
@@ -571,10 +586,10 @@ void oc_mtl_render_stroke_quadratic(oc_mtl_canvas_backend* backend, oc_vec2* p)
     }
 }
 
-void oc_mtl_render_stroke_cubic(oc_mtl_canvas_backend* backend, oc_vec2* p)
+void oc_mtl_render_stroke_cubic(oc_mtl_canvas_backend* backend, oc_vec2* p, int depth)
 {
     f32 width = backend->primitive->attributes.width;
-    f32 tolerance = oc_min(backend->primitive->attributes.tolerance, 0.5 * width);
+    f32 tolerance = backend->tolerance;
 
     //NOTE: check degenerate line cases
     f32 equalEps = 1e-3;
@@ -606,13 +621,21 @@ void oc_mtl_render_stroke_cubic(oc_mtl_canvas_backend* backend, oc_vec2* p)
     if(!oc_offset_hull(4, p, leftHull, width / 2)
        || !oc_offset_hull(4, p, rightHull, -width / 2))
     {
-        //TODO split and recurse
-        //NOTE: offsetting the hull failed, split the curve
-        oc_vec2 splitLeft[4];
-        oc_vec2 splitRight[4];
-        oc_cubic_split(p, 0.5, splitLeft, splitRight);
-        oc_mtl_render_stroke_cubic(backend, splitLeft);
-        oc_mtl_render_stroke_cubic(backend, splitRight);
+        if(depth >= OC_STROKE_MAX_SPLIT_DEPTH)
+        {
+            //NOTE: stop splitting and stroke the chord
+            oc_vec2 line[2] = { p[0], p[3] };
+            oc_mtl_render_stroke_line(backend, line);
+        }
+        else
+        {
+            //NOTE: offsetting the hull failed, split the curve
+            oc_vec2 splitLeft[4];
+            oc_vec2 splitRight[4];
+            oc_cubic_split(p, 0.5, splitLeft, splitRight);
+            oc_mtl_render_stroke_cubic(backend, splitLeft, depth + 1);
+            oc_mtl_render_stroke_cubic(backend, splitRight, depth + 1);
+        }
     }
     else
     {
@@ -647,13 +670,14 @@ void oc_mtl_render_stroke_cubic(oc_mtl_canvas_backend* backend, oc_vec2* p)
             }
         }
 
-        if(maxOvershoot > 0)
+        //NOTE: past the maximum depth, the hull is used as is even if it's not within tolerance
+        if(maxOvershoot > 0 && depth < OC_STROKE_MAX_SPLIT_DEPTH)
         {
             oc_vec2 splitLeft[4];
             oc_vec2 splitRight[4];
             oc_cubic_split(p, maxOvershootParameter, splitLeft, splitRight);
-            oc_mtl_render_stroke_cubic(backend, splitLeft);
-            oc_mtl_render_stroke_cubic(backend, splitRight);
+            oc_mtl_render_stroke_cubic(backend, splitLeft, depth + 1);
+            oc_mtl_render_stroke_cubic(backend, splitRight, depth + 1);
         }
         else
         {
@@ -693,12 +717,12 @@ void oc_mtl_render_stroke_element(oc_mtl_canvas_backend* backend,
             break;
 
         case OC_PATH_QUADRATIC:
-            oc_mtl_render_stroke_quadratic(backend, controlPoints);
+            oc_mtl_render_stroke_quadratic(backend, controlPoints, 0);
             endPointIndex = 2;
             break;
 
         case OC_PATH_CUBIC:
-            oc_mtl_render_stroke_cubic(backend, controlPoints);
+            oc_mtl_render_stroke_cubic(backend, controlPoints, 0);
             endPointIndex = 3;
             break;
 
@@ -923,6 +947,92 @@ void oc_mtl_render_stroke(oc_mtl_canvas_backend* backend,
     }
 }
 
+static oc_vec2 oc_mtl_encode_fill_element(oc_mtl_canvas_backend* backend, oc_path_elt_type type, oc_vec2 currentPos, oc_vec2* points)
+{
+    oc_vec2 p[4] = { currentPos, points[0], points[1], points[2] };
+
+    switch(type)
+    {
+        case OC_PATH_MOVE:
+            currentPos = points[0];
+            break;
+
+        case OC_PATH_LINE:
+            oc_mtl_canvas_encode_element(backend, type, p);
+            currentPos = points[0];
+            break;
+
+        case OC_PATH_QUADRATIC:
+            oc_mtl_canvas_encode_element(backend, type, p);
+            currentPos = points[1];
+            break;
+
+        case OC_PATH_CUBIC:
+            oc_mtl_canvas_encode_element(backend, type, p);
+            currentPos = points[2];
+            break;
+
+        default:
+            break;
+    }
+    return (currentPos);
+}
+
+void oc_mtl_encode_fill(oc_mtl_canvas_backend* backend,
+                        oc_path_elt* elements,
+                        u32 eltCount,
+                        oc_path_descriptor* path)
+{
+    //NOTE: start from the path's start point rather than from the end of the previous primitive,
+    //      so that primitives can be culled or skipped without affecting the next ones
+    oc_vec2 currentPos = path->startPoint;
+
+    for(u32 eltIndex = 0;
+        (eltIndex < path->count) && (path->startIndex + eltIndex < eltCount);
+        eltIndex++)
+    {
+        oc_path_elt* elt = &elements[path->startIndex + eltIndex];
+
+        if(elt->type == OC_PATH_GLYPH_DEF)
+        {
+            //NOTE: skip glyph outlines definitions, they are only drawn through glyph elements
+            eltIndex += elt->glyphDef.count;
+        }
+        else if(elt->type == OC_PATH_GLYPH)
+        {
+            //NOTE: encode the referenced glyph outlines, applying the glyph's scale and origin
+            u32 defIndex = elt->glyph.defIndex;
+            oc_path_elt* def = &elements[defIndex];
+
+            if(defIndex < eltCount
+               && def->type == OC_PATH_GLYPH_DEF
+               && defIndex + def->glyphDef.count < eltCount)
+            {
+                oc_vec2 origin = elt->glyph.origin;
+                oc_vec2 scale = elt->glyph.scale;
+                oc_vec2 glyphPos = origin;
+
+                for(u32 outlineIndex = 1; outlineIndex <= def->glyphDef.count; outlineIndex++)
+                {
+                    oc_path_elt* outline = &def[outlineIndex];
+                    oc_vec2 points[3];
+                    for(int i = 0; i < 3; i++)
+                    {
+                        points[i] = (oc_vec2){ origin.x + scale.x * outline->p[i].x,
+                                               origin.y + scale.y * outline->p[i].y };
+                    }
+                    glyphPos = oc_mtl_encode_fill_element(backend, outline->type, glyphPos, points);
+                }
+            }
+            currentPos = elt->glyph.origin;
+        }
+        else
+        {
+            currentPos = oc_mtl_encode_fill_element(backend, elt->type, currentPos, elt->p);
+        }
+    }
+}
+
 void oc_mtl_grow_buffer_if_needed(oc_mtl_canvas_backend* backend, id<MTLBuffer>* buffer, u64 wantedSize)
 {
     u64 bufferSize = [(*buffer) length];
@@ -1249,7 +1359,6 @@ void oc_mtl_canvas_render(oc_canvas_backend* interface,
     backend->maxTileQueueCount = 0;
 
     //NOTE: encode and render batches
-    oc_vec2 currentPos = { 0 };
     oc_image images[OC_MTL_MAX_IMAGES_PER_BATCH] = { 0 };
     int imageCount = 0;
 
@@ -1305,40 +1414,13 @@ void oc_mtl_canvas_render(oc_canvas_backend* interface,
 
             if(primitive->cmd == OC_CMD_STROKE)
             {
+                oc_vec4 box = oc_primitive_screen_bounds(primitive, pathElements);
+                backend->tolerance = oc_primitive_stroke_tolerance(primitive, box);
                 oc_mtl_render_stroke(backend, pathElements + primitive->path.startIndex, &primitive->path);
             }
             else
             {
-                for(int eltIndex = 0;
-                    (eltIndex < primitive->path.count) && (primitive->path.startIndex + eltIndex < eltCount);
-                    eltIndex++)
-                {
-                    oc_path_elt* elt = &pathElements[primitive->path.startIndex + eltIndex];
-
-                    if(elt->type != OC_PATH_MOVE)
-                    {
-                        oc_vec2 p[4] = { currentPos, elt->p[0], elt->p[1], elt->p[2] };
-                        oc_mtl_canvas_encode_element(backend, elt->type, p);
-                    }
-                    switch(elt->type)
-                    {
-                        case OC_PATH_MOVE:
-                            currentPos = elt->p[0];
-                            break;
-
-                        case OC_PATH_LINE:
-                            currentPos = elt->p[0];
-                            break;
-
-                        case OC_PATH_QUADRATIC:
-                            currentPos = elt->p[1];
-                            break;
-
-                        case OC_PATH_CUBIC:
-                            currentPos = elt->p[2];
-                            break;
-                    }
-                }
+                oc_mtl_encode_fill(backend, pathElements, eltCount, &primitive->path);
             }
             //NOTE: encode path
             oc_mtl_encode_path(backend, primitive, scale);
@@ -1400,7 +1482,7 @@ void oc_mtl_canvas_destroy(oc_canvas_backend* interface)
     free(backend);
 }
 
-oc_image_data* oc_mtl_canvas_image_create(oc_canvas_backend* interface, oc_vec2 size)
+oc_image_data* oc_mtl_canvas_image_create(oc_canvas_backend* interface, oc_vec2 size, u32 levelCount)
 {
     oc_mtl_image_data* image = 0;
     oc_mtl_canvas_backend* backend = (oc_mtl_canvas_backend*)interface;
@@ -1418,12 +1500,14 @@ oc_image_data* oc_mtl_canvas_image_create(oc_canvas_backend* interface, oc_vec2
             texDesc.pixelFormat = MTLPixelFormatRGBA8Unorm;
             texDesc.width = size.x;
             texDesc.height = size.y;
+            texDesc.mipmapLevelCount = levelCount;
 
             image->texture = [surface->device newTextureWithDescriptor:texDesc];
             if(image->texture != nil)
             {
                 [image->texture retain];
                 image->interface.size = size;
+                image->interface.levelCount = levelCount;
             }
             else
             {
@@ -1455,6 +1539,16 @@ void oc_mtl_canvas_image_upload_region(oc_canvas_backend* backendInterface, oc_i
                           mipmapLevel:0
                             withBytes:(void*)pixels
                           bytesPerRow:4 * region.w];
+
+        if(image->interface.levelCount > 1)
+        {
+            oc_mtl_canvas_backend* backend = (oc_mtl_canvas_backend*)backendInterface;
+            id<MTLCommandBuffer> commandBuffer = [backend->surface->commandQueue commandBuffer];
+            id<MTLBlitCommandEncoder> blitEncoder = [commandBuffer blitCommandEncoder];
+            [blitEncoder generateMipmapsForTexture:image->texture];
+            [blitEncoder endEncoding];
+            [commandBuffer commit];
+        }
     }
 }
 
@@ -1633,7 +1633,8 @@ kernel void mtl_raster(const device oc_mtl_screen_tile* screenTilesBuffer [[buff
             int textureIndex = pathBuffer[pathIndex].texture;
             if(textureIndex >= 0 && textureIndex < OC_MTL_MAX_IMAGES_PER_BATCH)
             {
-                constexpr sampler smp(mip_filter::nearest, mag_filter::linear, min_filter::linear);
+                constexpr sampler smp(mip_filter::linear, mag_filter::linear, min_filter::linear);
+                float lod = pathBuffer[pathIndex].lod;
 
                 float4 texColor = { 0 };
                 for(int sampleIndex = 0; sampleIndex < srcSampleCount; sampleIndex++)
@@ -1642,7 +1643,7 @@ kernel void mtl_raster(const device oc_mtl_screen_tile* screenTilesBuffer [[buff
                     float3 ph = float3(sampleCoord.xy, 1);
                     float2 uv = (pathBuffer[pathIndex].uvTransform * ph).xy;
 
-                    texColor += srcTextures[textureIndex].sample(smp, uv);
+                    texColor += srcTextures[textureIndex].sample(smp, uv, level(lod));
                 }
                 texColor /= srcSampleCount;
                 texColor.rgb *= texColor.a;
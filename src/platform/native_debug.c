@@ -8,6 +8,9 @@
 #include <stdio.h>
 
 #include "app/app.h"
+#include "platform_clock.h"
+#include "platform_thread.h"
+#include "util/hash.h"
 #include "platform_debug.c"
 //----------------------------------------------------------------
 // Logging
@@ -43,14 +46,189 @@ typedef struct oc_log_output
 static oc_log_output oc_logDefaultOutput = { 0 };
 oc_log_output* OC_LOG_DEFAULT_OUTPUT = &oc_logDefaultOutput;
 
-void platform_log_push(oc_log_output* output,
-                       oc_log_level level,
-                       const char* function,
-                       const char* file,
-                       int line,
-                       const char* fmt,
-                       va_list ap)
+//NOTE: log calls don't format or print anything on the calling thread. Messages are formatted to bytes and
+//      serialized, along with their level, function, file, line and timestamp, into a lock-free multiple
+//      producers single consumer byte ring. A background writer thread drains the ring, prints the records,
+//      and optionally dumps them to a compact binary log file (see scripts/decode_log.py).
+//
+//      Producers reserve space by advancing writeIndex with a compare and swap, fill their record, then
+//      publish it by storing its state with release semantics. The consumer processes records in reservation
+//      order, stopping at the first one that isn't published yet, and zeroes consumed bytes so that the state
+//      of future records starts unpublished. Records are never split across the end of the ring, the space
+//      left there is marked with a padding record when a header fits in it.
+
+enum
+{
+    OC_LOG_RING_SIZE = 1 << 20,
+    OC_LOG_RING_MASK = OC_LOG_RING_SIZE - 1,
+    OC_LOG_MAX_RECORD_SIZE = OC_LOG_RING_SIZE / 4,
+    OC_LOG_MAX_FUNCTION_LEN = 256,
+    OC_LOG_MAX_FILE_LEN = 1024,
+    OC_LOG_FORMAT_BUFFER_SIZE = 512,
+    OC_LOG_WRITER_POLL_INTERVAL = 1000000, // in nanoseconds
+    OC_LOG_WRITER_IDLE_POLLS = 100,
+    OC_LOG_FULL_RING_POLL_INTERVAL = 10000, // in nanoseconds
+};
+
+static const f64 OC_LOG_FULL_RING_TIMEOUT = 1; // in seconds
+
+typedef enum oc_log_record_state
+{
+    OC_LOG_RECORD_PENDING = 0,
+    OC_LOG_RECORD_COMMITTED,
+    OC_LOG_RECORD_PADDING,
+} oc_log_record_state;
+
+typedef struct oc_log_record
+{
+    _Atomic(u32) state;
+    u32 size;
+    oc_log_level level;
+    i32 line;
+    u32 functionLen;
+    u32 fileLen;
+    u32 msgLen;
+    u32 reserved;
+    f64 timestamp;
+    oc_log_output* output;
+
+    // followed by function, file and message bytes
+
+} oc_log_record;
+
+typedef struct oc_log_string_slot
+{
+    u64 hash;
+    oc_str8 string;
+    u32 id;
+} oc_log_string_slot;
+
+typedef enum oc_log_writer_status
+{
+    OC_LOG_WRITER_STOPPED = 0,
+    OC_LOG_WRITER_STARTING,
+    OC_LOG_WRITER_RUNNING,
+} oc_log_writer_status;
+
+typedef struct oc_log_queue
+{
+    _Atomic(u64) writeIndex;
+    _Atomic(u64) readIndex;
+
+    //NOTE: consuming is guarded by a spin flag rather than a mutex, so that a flush can still
+    //      make progress at exit if the writer thread was killed while not consuming
+    _Atomic(bool) consuming;
+    _Atomic(bool) writerSleeping;
+    _Atomic(u32) writerStatus;
+    _Atomic(u32) droppedCount;
+
+    oc_thread* writer;
+    oc_mutex* mutex;
+    oc_condition* condition;
+
+    //NOTE: only accessed by the consumer
+    FILE* binaryFile;
+    oc_arena stringArena;
+    oc_log_string_slot* strings;
+    u32 stringCap;
+    u32 stringCount;
+
+    char buffer[OC_LOG_RING_SIZE];
+
+} oc_log_queue;
+
+static oc_log_queue oc_logQueue = { 0 };
+
+//NOTE: binary log file format, all values are little-endian:
+//      - header: the 4 bytes "OCLG", followed by a u32 version.
+//      - string record: u8 tag (1), u32 id, u32 length, string bytes.
+//      - log record: u8 tag (2), u8 level, u32 function id, u32 file id, i32 line, f64 timestamp,
+//        u32 message length, message bytes.
+//      Function and file names are written once in a string record, and referenced by id in log records.
+
+enum
+{
+    OC_LOG_BINARY_VERSION = 1,
+    OC_LOG_BINARY_STRING = 1,
+    OC_LOG_BINARY_ENTRY = 2,
+};
+
+static u32 oc_log_binary_string_id(oc_log_queue* queue, oc_str8 string)
+{
+    if(queue->stringCount * 2 >= queue->stringCap)
+    {
+        //NOTE: grow and rehash the string table
+        u32 oldCap = queue->stringCap;
+        oc_log_string_slot* oldSlots = queue->strings;
+
+        queue->stringCap = oc_max(oldCap * 2, 256);
+        queue->strings = oc_malloc_array(oc_log_string_slot, queue->stringCap);
+        memset(queue->strings, 0, queue->stringCap * sizeof(oc_log_string_slot));
+
+        for(u32 i = 0; i < oldCap; i++)
+        {
+            if(oldSlots[i].string.ptr)
+            {
+                u32 index = oldSlots[i].hash & (queue->stringCap - 1);
+                while(queue->strings[index].string.ptr)
+                {
+                    index = (index + 1) & (queue->stringCap - 1);
+                }
+                queue->strings[index] = oldSlots[i];
+            }
+        }
+        free(oldSlots);
+    }
+
+    u64 hash = oc_hash_xx64_string(string);
+    u32 index = hash & (queue->stringCap - 1);
+    while(queue->strings[index].string.ptr)
+    {
+        oc_log_string_slot* slot = &queue->strings[index];
+        if(slot->hash == hash && !oc_str8_cmp(slot->string, string))
+        {
+            return (slot->id);
+        }
+        index = (index + 1) & (queue->stringCap - 1);
+    }
+
+    oc_log_string_slot* slot = &queue->strings[index];
+    slot->hash = hash;
+    slot->string = oc_str8_push_copy(&queue->stringArena, string);
+    slot->id = queue->stringCount;
+    queue->stringCount++;
+
+    u8 tag = OC_LOG_BINARY_STRING;
+    u32 len = string.len;
+    fwrite(&tag, 1, 1, queue->binaryFile);
+    fwrite(&slot->id, 4, 1, queue->binaryFile);
+    fwrite(&len, 4, 1, queue->binaryFile);
+    fwrite(string.ptr, 1, len, queue->binaryFile);
+
+    return (slot->id);
+}
+
+static void oc_log_binary_write(oc_log_queue* queue, oc_log_record* record, char* function, char* file, char* msg)
 {
+    u32 functionId = oc_log_binary_string_id(queue, oc_str8_from_buffer(record->functionLen, function));
+    u32 fileId = oc_log_binary_string_id(queue, oc_str8_from_buffer(record->fileLen, file));
+
+    u8 header[26];
+    header[0] = OC_LOG_BINARY_ENTRY;
+    header[1] = record->level;
+    memcpy(header + 2, &functionId, 4);
+    memcpy(header + 6, &fileId, 4);
+    memcpy(header + 10, &record->line, 4);
+    memcpy(header + 14, &record->timestamp, 8);
+    memcpy(header + 22, &record->msgLen, 4);
+
+    fwrite(header, 1, 26, queue->binaryFile);
+    fwrite(msg, 1, record->msgLen, queue->binaryFile);
+}
+
+static void oc_log_print(oc_log_record* record, char* function, char* file, char* msg)
+{
+    oc_log_output* output = record->output;
     if(output == OC_LOG_DEFAULT_OUTPUT && output->f == 0)
     {
         output->f = stdout;
@@ -60,24 +238,349 @@ void platform_log_push(oc_log_output* output,
     if(isatty(fd))
     {
         fprintf(output->f,
-                "%s%s:%s %s() in %s:%i: ",
-                OC_LOG_FORMATS[level],
-                OC_LOG_HEADINGS[level],
+                "%s%s:%s %.*s() in %.*s:%i: ",
+                OC_LOG_FORMATS[record->level],
+                OC_LOG_HEADINGS[record->level],
                 OC_LOG_FORMAT_STOP,
+                record->functionLen,
                 function,
+                record->fileLen,
                 file,
-                line);
+                record->line);
     }
     else
     {
         fprintf(output->f,
-                "%s: %s() in %s:%i: ",
-                OC_LOG_HEADINGS[level],
+                "%s: %.*s() in %.*s:%i: ",
+                OC_LOG_HEADINGS[record->level],
+                record->functionLen,
                 function,
+                record->fileLen,
                 file,
-                line);
+                record->line);
     }
-    vfprintf(output->f, fmt, ap);
+    fwrite(msg, 1, record->msgLen, output->f);
+}
+
+static bool oc_log_try_consume(oc_log_queue* queue)
+{
+    //NOTE: process all published records, returns false if the consumer is busy on another thread
+    bool expected = false;
+    if(!atomic_compare_exchange_strong(&queue->consuming, &expected, true))
+    {
+        return (false);
+    }
+
+    u64 startIndex = atomic_load_explicit(&queue->readIndex, memory_order_relaxed);
+    u64 readIndex = startIndex;
+    u64 writeIndex = atomic_load_explicit(&queue->writeIndex, memory_order_acquire);
+
+    while(readIndex < writeIndex)
+    {
+        u64 offset = readIndex & OC_LOG_RING_MASK;
+        if(offset + sizeof(oc_log_record) > OC_LOG_RING_SIZE)
+        {
+            //NOTE: implicit padding, the remaining space couldn't hold a record header
+            readIndex += OC_LOG_RING_SIZE - offset;
+            continue;
+        }
+
+        oc_log_record* record = (oc_log_record*)(queue->buffer + offset);
+        u32 state = atomic_load_explicit(&record->state, memory_order_acquire);
+        if(state == OC_LOG_RECORD_PENDING)
+        {
+            break;
+        }
+        else if(state == OC_LOG_RECORD_COMMITTED)
+        {
+            char* function = (char*)record + sizeof(oc_log_record);
+            char* file = function + record->functionLen;
+            char* msg = file + record->fileLen;
+
+            oc_log_print(record, function, file, msg);
+            if(queue->binaryFile)
+            {
+                oc_log_binary_write(queue, record, function, file, msg);
+            }
+        }
+
+        u32 size = record->size;
+        memset(record, 0, size);
+        readIndex += size;
+
+        atomic_store_explicit(&queue->readIndex, readIndex, memory_order_release);
+    }
+    atomic_store_explicit(&queue->readIndex, readIndex, memory_order_release);
+
+    //NOTE: producers keep dropping records until we make progress, see platform_log_push()
+    if(readIndex != startIndex && atomic_load(&queue->droppedCount))
+    {
+        u32 droppedCount = atomic_exchange(&queue->droppedCount, 0);
+        fprintf(stderr, "Warning: %u log records were dropped because the log queue was full.\n", droppedCount);
+    }
+
+    atomic_store(&queue->consuming, false);
+    return (true);
+}
+
+static bool oc_log_queue_empty(oc_log_queue* queue)
+{
+    return (atomic_load(&queue->readIndex) == atomic_load(&queue->writeIndex));
+}
+
+static i32 oc_log_writer_proc(void* user)
+{
+    oc_log_queue* queue = (oc_log_queue*)user;
+    u32 idleCount = 0;
+    while(1)
+    {
+        u64 readIndex = atomic_load(&queue->readIndex);
+        if(oc_log_try_consume(queue) && atomic_load(&queue->readIndex) != readIndex)
+        {
+            fflush(NULL);
+            idleCount = 0;
+        }
+        else
+        {
+            idleCount++;
+        }
+
+        if(idleCount < OC_LOG_WRITER_IDLE_POLLS)
+        {
+            //NOTE: while logging is active we poll the ring, so that producers never have to signal us
+            oc_sleep_nano(OC_LOG_WRITER_POLL_INTERVAL);
+        }
+        else
+        {
+            //NOTE: after a while without records we sleep until a producer signals us. Producers check
+            //      writerSleeping after publishing their record, so either they see it and signal us while
+            //      we wait, or we see their record here. The timeout is just a safety net.
+            oc_mutex_lock(queue->mutex);
+            atomic_store(&queue->writerSleeping, true);
+            if(oc_log_queue_empty(queue))
+            {
+                oc_condition_timedwait(queue->condition, queue->mutex, 0.1);
+            }
+            atomic_store(&queue->writerSleeping, false);
+            oc_mutex_unlock(queue->mutex);
+            idleCount = 0;
+        }
+    }
+    return (0);
+}
+
+static void oc_log_wake_writer(oc_log_queue* queue)
+{
+    if(atomic_load(&queue->writerSleeping))
+    {
+        oc_mutex_lock(queue->mutex);
+        oc_condition_signal(queue->condition);
+        oc_mutex_unlock(queue->mutex);
+    }
+}
+
+static void oc_log_start_writer(oc_log_queue* queue)
+{
+    u32 expected = OC_LOG_WRITER_STOPPED;
+    if(atomic_compare_exchange_strong(&queue->writerStatus, &expected, OC_LOG_WRITER_STARTING))
+    {
+        oc_arena_init(&queue->stringArena);
+        queue->mutex = oc_mutex_create();
+        queue->condition = oc_condition_create();
+        queue->writer = oc_thread_create_with_name(oc_log_writer_proc, queue, OC_STR8("log writer"));
+        atomic_store(&queue->writerStatus, OC_LOG_WRITER_RUNNING);
+
+        atexit(oc_log_flush);
+    }
+}
+
+void oc_log_flush(void)
+{
+    oc_log_queue* queue = &oc_logQueue;
+
+    //NOTE: wait until the records queued so far have been written, consuming them on this thread
+    //      if the writer isn't busy. We give up after a while in case the writer thread was killed
+    //      while consuming, which can happen when flushing from a Windows DLL at process exit.
+    u64 target = atomic_load(&queue->writeIndex);
+    for(int i = 0; i < 20000 && atomic_load(&queue->readIndex) < target; i++)
+    {
+        if(!oc_log_try_consume(queue))
+        {
+            oc_sleep_nano(50000);
+        }
+    }
+    fflush(NULL);
+}
+
+int oc_log_set_binary_file(const char* path)
+{
+    oc_log_queue* queue = &oc_logQueue;
+
+    FILE* file = 0;
+    if(path)
+    {
+        file = fopen(path, "wb");
+        if(!file)
+        {
+            return (-1);
+        }
+        char magic[4] = { 'O', 'C', 'L', 'G' };
+        u32 version = OC_LOG_BINARY_VERSION;
+        fwrite(magic, 1, 4, file);
+        fwrite(&version, 4, 1, file);
+    }
+
+    //NOTE: take the consumer role to swap files, records already queued go to the previous file
+    oc_log_start_writer(queue);
+    oc_log_flush();
+
+    bool expected = false;
+    while(!atomic_compare_exchange_weak(&queue->consuming, &expected, true))
+    {
+        expected = false;
+        oc_sleep_nano(50000);
+    }
+
+    if(queue->binaryFile)
+    {
+        fclose(queue->binaryFile);
+    }
+    queue->binaryFile = file;
+
+    //NOTE: string ids are per-file
+    if(queue->strings)
+    {
+        memset(queue->strings, 0, queue->stringCap * sizeof(oc_log_string_slot));
+    }
+    queue->stringCount = 0;
+    oc_arena_clear(&queue->stringArena);
+
+    atomic_store(&queue->consuming, false);
+    return (0);
+}
+
+void platform_log_push(oc_log_output* output,
+                       oc_log_level level,
+                       const char* function,
+                       const char* file,
+                       int line,
+                       const char* fmt,
+                       va_list ap)
+{
+    oc_log_queue* queue = &oc_logQueue;
+
+    if(atomic_load_explicit(&queue->writerStatus, memory_order_relaxed) == OC_LOG_WRITER_STOPPED)
+    {
+        oc_log_start_writer(queue);
+    }
+
+    //NOTE: format short messages in a stack buffer, longer ones are formatted directly into the ring
+    char formatBuffer[OC_LOG_FORMAT_BUFFER_SIZE];
+    va_list apCopy;
+    va_copy(apCopy, ap);
+    int formatLen = vsnprintf(formatBuffer, OC_LOG_FORMAT_BUFFER_SIZE, fmt, apCopy);
+    va_end(apCopy);
+
+    u32 functionLen = oc_min(strlen(function), OC_LOG_MAX_FUNCTION_LEN);
+    u32 fileLen = oc_min(strlen(file), OC_LOG_MAX_FILE_LEN);
+    u32 msgLen = oc_clamp(formatLen, 0, (int)(OC_LOG_MAX_RECORD_SIZE - sizeof(oc_log_record) - OC_LOG_MAX_FUNCTION_LEN - OC_LOG_MAX_FILE_LEN - 1));
+
+    //NOTE: keep one extra byte for the null terminator written by vsnprintf
+    u64 size = sizeof(oc_log_record) + functionLen + fileLen + msgLen + 1;
+    size = (size + 7) & ~7ULL;
+
+    //NOTE: reserve space in the ring
+    u64 writeIndex = atomic_load_explicit(&queue->writeIndex, memory_order_relaxed);
+    u64 offset = 0;
+    u64 padding = 0;
+    f64 fullStartTime = 0;
+    while(1)
+    {
+        offset = writeIndex & OC_LOG_RING_MASK;
+        padding = (offset + size > OC_LOG_RING_SIZE) ? OC_LOG_RING_SIZE - offset : 0;
+
+        u64 readIndex = atomic_load_explicit(&queue->readIndex, memory_order_acquire);
+        if(writeIndex + padding + size - readIndex > OC_LOG_RING_SIZE)
+        {
+            //NOTE: the ring is full. Drain it on this thread unless the writer is already doing it, otherwise
+            //      give the writer some time. If there's still no room after a while, eg. because a producer
+            //      stalled before publishing its record or the writer was killed while consuming, we drop the
+            //      record rather than block forever. Once a record was dropped, the following ones are dropped
+            //      without waiting until the consumer makes progress again and reports how many were lost.
+            if(oc_log_try_consume(queue) && atomic_load(&queue->readIndex) != readIndex)
+            {
+                fflush(NULL);
+            }
+            else if(atomic_load(&queue->droppedCount))
+            {
+                atomic_fetch_add(&queue->droppedCount, 1);
+                return;
+            }
+            else
+            {
+                oc_log_wake_writer(queue);
+                oc_sleep_nano(OC_LOG_FULL_RING_POLL_INTERVAL);
+            }
+
+            f64 time = oc_clock_time(OC_CLOCK_MONOTONIC);
+            if(!fullStartTime)
+            {
+                fullStartTime = time;
+            }
+            else if(time - fullStartTime > OC_LOG_FULL_RING_TIMEOUT)
+            {
+                atomic_fetch_add(&queue->droppedCount, 1);
+                return;
+            }
+
+            writeIndex = atomic_load_explicit(&queue->writeIndex, memory_order_relaxed);
+            continue;
+        }
+        if(atomic_compare_exchange_weak(&queue->writeIndex, &writeIndex, writeIndex + padding + size))
+        {
+            break;
+        }
+    }
+
+    if(padding)
+    {
+        if(padding >= sizeof(oc_log_record))
+        {
+            oc_log_record* pad = (oc_log_record*)(queue->buffer + offset);
+            pad->size = padding;
+            atomic_store_explicit(&pad->state, OC_LOG_RECORD_PADDING, memory_order_release);
+        }
+        offset = 0;
+    }
+
+    oc_log_record* record = (oc_log_record*)(queue->buffer + offset);
+    record->size = size;
+    record->level = level;
+    record->line = line;
+    record->functionLen = functionLen;
+    record->fileLen = fileLen;
+    record->msgLen = msgLen;
+    record->timestamp = oc_clock_time(OC_CLOCK_MONOTONIC);
+    record->output = output;
+
+    char* payload = (char*)record + sizeof(oc_log_record);
+    memcpy(payload, function, functionLen);
+    payload += functionLen;
+    memcpy(payload, file, fileLen);
+    payload += fileLen;
+
+    if(formatLen < OC_LOG_FORMAT_BUFFER_SIZE)
+    {
+        memcpy(payload, formatBuffer, msgLen);
+    }
+    else
+    {
+        vsnprintf(payload, msgLen + 1, fmt, ap);
+    }
+
+    atomic_store_explicit(&record->state, OC_LOG_RECORD_COMMITTED, memory_order_release);
+
+    oc_log_wake_writer(queue);
 }
 
 //----------------------------------------------------------------
@@ -102,6 +605,7 @@ _Noreturn void oc_abort_ext(const char* file, const char* function, int line, co
                                 note.ptr);
 
     oc_log_error(msg.ptr);
+    oc_log_flush();
 
     oc_str8_list options = { 0 };
     oc_str8_list_push(scratch.arena, &options, OC_STR8("OK"));
@@ -130,6 +634,7 @@ _Noreturn void oc_assert_fail(const char* file, const char* function, int line,
                                 oc_str8_ip(note));
 
     oc_log_error(msg.ptr);
+    oc_log_flush();
 
     oc_str8_list options = { 0 };
     oc_str8_list_push(scratch.arena, &options, OC_STR8("OK"));
@@ -18,6 +18,11 @@ static oc_log_config __logConfig = { 0, OC_LOG_LEVEL_INFO };
 
 void oc_log_set_output(oc_log_output* output)
 {
+#if !OC_PLATFORM_ORCA
+    //NOTE: queued records reference the output they were logged to, and are written later by the log writer
+    //      thread. Write them now, so that the caller can release the previous output once we return.
+    oc_log_flush();
+#endif
     __logConfig.output = output;
 }
 
@@ -38,6 +38,9 @@ typedef struct oc_log_output oc_log_output;
 extern oc_log_output* OC_LOG_DEFAULT_OUTPUT;
 
 ORCA_API void oc_log_set_level(oc_log_level level);
+
+//NOTE: the previous output must stay valid until oc_log_set_output() returns, which flushes the records
+//      queued to it. It must not be called while other threads are logging.
 ORCA_API void oc_log_set_output(oc_log_output* output);
 ORCA_API void oc_log_ext(oc_log_level level,
                          const char* function,
@@ -46,6 +49,15 @@ ORCA_API void oc_log_ext(oc_log_level level,
                          const char* fmt,
                          ...);
 
+#if !OC_PLATFORM_ORCA
+//NOTE: log records are queued and written by a background thread. oc_log_flush() blocks until the records
+//      queued so far have been written. oc_log_set_binary_file() additionally dumps records to a compact
+//      binary file, which can be decoded with scripts/decode_log.py. Passing a null path closes the file.
+//      Returns 0 on success and -1 if the file couldn't be opened.
+ORCA_API void oc_log_flush(void);
+ORCA_API int oc_log_set_binary_file(const char* path);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
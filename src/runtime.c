@@ -123,6 +123,17 @@ void oc_bridge_window_set_size(oc_vec2 size)
     oc_window_set_content_size(__orcaApp.window, size);
 }
 
+oc_image oc_bridge_image_create_from_memory_async(oc_surface surface, oc_wasm_str8 mem, bool flip)
+{
+    oc_image image = oc_image_nil();
+    oc_str8 nativeMem = oc_wasm_str8_to_native(mem);
+    if(nativeMem.ptr)
+    {
+        image = oc_image_create_from_memory_async(surface, nativeMem, flip);
+    }
+    return (image);
+}
+
 oc_wasm_str8 oc_bridge_clipboard_get_string(oc_wasm_addr wasmArena)
 {
     return oc_runtime_clipboard_get_string(&__orcaApp.clipboard, wasmArena);
@@ -133,6 +144,43 @@ void oc_bridge_clipboard_set_string(oc_wasm_str8 value)
     oc_runtime_clipboard_set_string(&__orcaApp.clipboard, value);
 }
 
+//------------------------------------------------------------------------------------
+// Debug overlay log ring
+//------------------------------------------------------------------------------------
+
+static oc_str8 log_entry_function(log_entry* entry)
+{
+    return (oc_str8_from_buffer(entry->functionLen, (char*)entry + sizeof(log_entry)));
+}
+
+static oc_str8 log_entry_file(log_entry* entry)
+{
+    return (oc_str8_from_buffer(entry->fileLen, (char*)entry + sizeof(log_entry) + entry->functionLen + 1));
+}
+
+static oc_str8 log_entry_msg(log_entry* entry)
+{
+    return (oc_str8_from_buffer(entry->msgLen, (char*)entry + sizeof(log_entry) + entry->functionLen + entry->fileLen + 2));
+}
+
+static log_entry* log_ring_entry(oc_debug_overlay* debug, u64* pos)
+{
+    //NOTE: returns the record at *pos, first skipping the padding at the end of the ring if there's any
+    u64 offset = *pos & (OC_DEBUG_LOG_RING_SIZE - 1);
+    if(offset + sizeof(log_entry) > OC_DEBUG_LOG_RING_SIZE)
+    {
+        *pos += OC_DEBUG_LOG_RING_SIZE - offset;
+        offset = 0;
+    }
+    log_entry* entry = (log_entry*)(debug->logRing + offset);
+    if(entry->padding)
+    {
+        *pos += entry->size;
+        entry = (log_entry*)debug->logRing;
+    }
+    return (entry);
+}
+
 void oc_bridge_log(oc_log_level level,
                    int functionLen,
                    char* function,
@@ -144,78 +192,106 @@ void oc_bridge_log(oc_log_level level,
 {
     oc_debug_overlay* debug = &__orcaApp.debugOverlay;
 
-    //NOTE: recycle first entry if we exceeded the max entry count
-    debug->entryCount++;
-    if(debug->entryCount > debug->maxEntries)
+    //NOTE: truncate strings so that a record never takes more than a quarter of the ring
+    functionLen = oc_min(functionLen, OC_DEBUG_LOG_MAX_FUNCTION_LEN);
+    fileLen = oc_min(fileLen, OC_DEBUG_LOG_MAX_FILE_LEN);
+    msgLen = oc_min(msgLen, (int)(OC_DEBUG_LOG_RING_SIZE / 4 - sizeof(log_entry) - functionLen - fileLen - 2));
+
+    u64 size = sizeof(log_entry) + functionLen + fileLen + msgLen + 2;
+    size = (size + 7) & ~7ULL;
+
+    //NOTE: records are contiguous, if the record doesn't fit before the end of the ring it is written at the start
+    u64 offset = debug->logTail & (OC_DEBUG_LOG_RING_SIZE - 1);
+    u64 padding = 0;
+    if(offset + size > OC_DEBUG_LOG_RING_SIZE)
     {
-        log_entry* e = oc_list_pop_entry(&debug->logEntries, log_entry, listElt);
-        if(e)
-        {
-            oc_list_push(&debug->logFreeList, &e->listElt);
-            debug->entryCount--;
-        }
+        padding = OC_DEBUG_LOG_RING_SIZE - offset;
     }
 
-    u64 cap = sizeof(log_entry) + fileLen + functionLen + msgLen;
-
-    //NOTE: allocate a new entry
-    //TODO: should probably use a buddy allocator over the arena or something
-    log_entry* entry = 0;
-    oc_list_for(debug->logFreeList, elt, log_entry, listElt)
+    //NOTE: overwrite the oldest records until there is enough room
+    while(debug->logTail + padding + size - debug->logHead > OC_DEBUG_LOG_RING_SIZE)
     {
-        if(elt->cap >= cap)
-        {
-            oc_list_remove(&debug->logFreeList, &elt->listElt);
-            entry = elt;
-            break;
-        }
+        log_entry* oldest = log_ring_entry(debug, &debug->logHead);
+        debug->logHead += oldest->size;
+        debug->entryCount--;
     }
 
-    if(!entry)
+    if(padding)
     {
-        char* mem = oc_arena_push(&debug->logArena, cap);
-        entry = (log_entry*)mem;
-        entry->cap = cap;
+        if(padding >= sizeof(log_entry))
+        {
+            log_entry* pad = (log_entry*)(debug->logRing + offset);
+            *pad = (log_entry){ .size = padding, .padding = true };
+        }
+        debug->logTail += padding;
+        offset = 0;
     }
-    char* payload = (char*)entry + sizeof(log_entry);
 
-    entry->function.len = functionLen;
-    entry->function.ptr = payload;
-    payload += entry->function.len;
+    log_entry* entry = (log_entry*)(debug->logRing + offset);
+    *entry = (log_entry){
+        .size = size,
+        .level = level,
+        .line = line,
+        .functionLen = functionLen,
+        .fileLen = fileLen,
+        .msgLen = msgLen,
+        .recordIndex = debug->logEntryTotalCount,
+    };
 
-    entry->file.len = fileLen;
-    entry->file.ptr = payload;
-    payload += entry->file.len;
+    char* payload = (char*)entry + sizeof(log_entry);
+    memcpy(payload, function, functionLen);
+    payload[functionLen] = '\0';
+    payload += functionLen + 1;
 
-    entry->msg.len = msgLen;
-    entry->msg.ptr = payload;
-    payload += entry->msg.len;
+    memcpy(payload, file, fileLen);
+    payload[fileLen] = '\0';
+    payload += fileLen + 1;
 
-    memcpy(entry->file.ptr, file, fileLen);
-    memcpy(entry->function.ptr, function, functionLen);
-    memcpy(entry->msg.ptr, msg, msgLen);
+    memcpy(payload, msg, msgLen);
 
-    entry->level = level;
-    entry->line = line;
-    entry->recordIndex = debug->logEntryTotalCount;
+    debug->logTail += size;
+    debug->entryCount++;
     debug->logEntryTotalCount++;
 
-    oc_list_push_back(&debug->logEntries, &entry->listElt);
-
+    //NOTE: the message is formatted into the log queue on this thread, and only printed by the log writer thread
     oc_log_ext(level,
-               function,
-               file,
+               log_entry_function(entry).ptr,
+               log_entry_file(entry).ptr,
                line,
                "%.*s\n",
                msgLen,
                msg);
 }
 
+void debug_log_clear(oc_debug_overlay* debug)
+{
+    debug->logHead = debug->logTail;
+    debug->entryCount = 0;
+}
+
 void oc_bridge_request_quit(void)
 {
     __orcaApp.quit = true;
 }
 
+void oc_bridge_request_frame(void)
+{
+    __orcaApp.frameRequested = true;
+}
+
+static void oc_runtime_request_frame_at(f64 time)
+{
+    if(!__orcaApp.frameDeadline || time < __orcaApp.frameDeadline)
+    {
+        __orcaApp.frameDeadline = time;
+    }
+}
+
+void oc_bridge_request_frame_after(f64 delay)
+{
+    oc_runtime_request_frame_at(oc_clock_time(OC_CLOCK_MONOTONIC) + oc_max(delay, 0));
+}
+
 typedef struct orca_surface_create_data
 {
     oc_window window;
@@ -356,16 +432,48 @@ void log_entry_ui(oc_debug_overlay* overlay, log_entry* entry)
 
             oc_str8 loc = oc_str8_pushf(scratch.arena,
                                         "%.*s() in %.*s:%i:",
-                                        oc_str8_ip(entry->function),
-                                        oc_str8_ip(entry->file),
+                                        oc_str8_ip(log_entry_function(entry)),
+                                        oc_str8_ip(log_entry_file(entry)),
                                         entry->line);
             oc_ui_label_str8(loc);
         }
-        oc_ui_label_str8(entry->msg);
+        oc_ui_label_str8(log_entry_msg(entry));
     }
     oc_scratch_end(scratch);
 }
 
+typedef struct log_view_cursor
+{
+    oc_debug_overlay* overlay;
+    bool started;
+    u64 pos;
+    u32 index;
+} log_view_cursor;
+
+void log_view_row(u32 index, void* user)
+{
+    //NOTE: rows are built in increasing order, so we walk the log ring from the last built row
+    log_view_cursor* cursor = (log_view_cursor*)user;
+    oc_debug_overlay* overlay = cursor->overlay;
+    if(!cursor->started || index < cursor->index)
+    {
+        cursor->pos = overlay->logHead;
+        cursor->index = 0;
+        cursor->started = true;
+    }
+    while(cursor->pos < overlay->logTail && cursor->index < index)
+    {
+        log_entry* entry = log_ring_entry(overlay, &cursor->pos);
+        cursor->pos += entry->size;
+        cursor->index++;
+    }
+    if(cursor->pos < overlay->logTail)
+    {
+        u64 pos = cursor->pos;
+        log_entry_ui(overlay, log_ring_entry(overlay, &pos));
+    }
+}
+
 char m3_type_to_tag(M3ValueType type)
 {
     switch(type)
@@ -577,8 +685,31 @@ i32 orca_runloop(void* user)
 
     oc_ui_set_context(&app->debugOverlay.ui);
 
+    app->frameRequested = true;
+
     while(!app->quit)
     {
+        //NOTE: frames are only refreshed on events or when requested with oc_request_frame() or
+        //      oc_request_frame_after(), otherwise we sleep until the next event instead of spinning
+        //      at the refresh rate
+        if(!app->frameRequested)
+        {
+            if(app->frameDeadline)
+            {
+                f64 timeout = app->frameDeadline - oc_clock_time(OC_CLOCK_MONOTONIC);
+                if(timeout > 0)
+                {
+                    oc_wait_events(timeout);
+                }
+            }
+            else
+            {
+                oc_wait_events(-1);
+            }
+        }
+        app->frameRequested = false;
+        app->frameDeadline = 0;
+
         scratch = oc_scratch_begin();
         oc_event* event = 0;
 
@@ -764,11 +895,12 @@ i32 orca_runloop(void* user)
             }
         }
 
-        oc_surface_select(app->debugOverlay.surface);
-        oc_canvas_select(app->debugOverlay.canvas);
-
         if(app->debugOverlay.show)
         {
+            app->debugOverlay.cleared = false;
+
+            oc_surface_select(app->debugOverlay.surface);
+            oc_canvas_select(app->debugOverlay.canvas);
             oc_surface_bring_to_front(app->debugOverlay.surface);
 
             oc_ui_style debugUIDefaultStyle = { .bgColor = { 0 },
@@ -833,12 +965,7 @@ i32 orca_runloop(void* user)
                         oc_ui_style_match_after(oc_ui_pattern_all(), &buttonStyle, buttonStyleMask);
                         if(oc_ui_button("Clear").clicked)
                         {
-                            oc_list_for_safe(app->debugOverlay.logEntries, entry, log_entry, listElt)
-                            {
-                                oc_list_remove(&app->debugOverlay.logEntries, &entry->listElt);
-                                oc_list_push(&app->debugOverlay.logFreeList, &entry->listElt);
-                                app->debugOverlay.entryCount--;
-                            }
+                            debug_log_clear(&app->debugOverlay);
                         }
                     }
 
@@ -861,25 +988,19 @@ i32 orca_runloop(void* user)
                         scrollY = panel->scroll.y;
                     }
 
-                    oc_ui_panel("log view", OC_UI_FLAG_SCROLL_WHEEL_Y)
-                    {
-                        panel = oc_ui_box_top()->parent;
-
-                        oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
-                                                         .size.height = { OC_UI_SIZE_CHILDREN },
-                                                         .layout.axis = OC_UI_AXIS_Y,
-                                                         .layout.margin.y = 5 },
-                                         OC_UI_STYLE_SIZE
-                                             | OC_UI_STYLE_LAYOUT_AXIS);
-
-                        oc_ui_container("contents", 0)
-                        {
-                            oc_list_for(app->debugOverlay.logEntries, entry, log_entry, listElt)
-                            {
-                                log_entry_ui(&app->debugOverlay, entry);
-                            }
-                        }
-                    }
+                    //NOTE: only build the log entries that are visible
+                    log_view_cursor cursor = { .overlay = &app->debugOverlay };
+                    oc_ui_list_info listInfo = {
+                        .rowCount = app->debugOverlay.entryCount,
+                        .rowHeight = 40,
+                        .estimateHeight = true,
+                        .overscan = 2,
+                        .proc = log_view_row,
+                        .user = &cursor,
+                    };
+                    oc_ui_list("log view", &listInfo);
+
+                    panel = oc_ui_box_lookup("log view");
                     if(app->debugOverlay.logScrollToLast)
                     {
                         if(panel->scroll.y >= scrollY)
@@ -899,15 +1020,33 @@ i32 orca_runloop(void* user)
             }
 
             oc_ui_draw();
+
+            oc_render(app->debugOverlay.canvas);
+            oc_surface_present(app->debugOverlay.surface);
+
+            if(app->debugOverlay.ui.frameRequested)
+            {
+                app->frameRequested = true;
+            }
+            else if(app->debugOverlay.ui.frameDeadline)
+            {
+                oc_runtime_request_frame_at(app->debugOverlay.ui.frameDeadline);
+            }
         }
-        else
+        else if(!app->debugOverlay.cleared)
         {
+            //NOTE: the hidden overlay only needs to be cleared and presented once
+            oc_surface_select(app->debugOverlay.surface);
+            oc_canvas_select(app->debugOverlay.canvas);
+
             oc_set_color_rgba(0, 0, 0, 0);
             oc_clear();
-        }
 
-        oc_render(app->debugOverlay.canvas);
-        oc_surface_present(app->debugOverlay.surface);
+            oc_render(app->debugOverlay.canvas);
+            oc_surface_present(app->debugOverlay.surface);
+
+            app->debugOverlay.cleared = true;
+        }
 
         oc_scratch_end(scratch);
 
@@ -936,6 +1075,13 @@ int main(int argc, char** argv)
 {
     oc_log_set_level(OC_LOG_LEVEL_INFO);
 
+    //NOTE: optionally dump logs to a binary file, which can be decoded with scripts/decode_log.py
+    char* binaryLogPath = getenv("ORCA_BINARY_LOG");
+    if(binaryLogPath && oc_log_set_binary_file(binaryLogPath) != 0)
+    {
+        oc_log_error("Couldn't open binary log file %s\n", binaryLogPath);
+    }
+
     oc_init();
     oc_clock_init();
 
@@ -950,8 +1096,7 @@ int main(int argc, char** argv)
     app->debugOverlay.canvas = oc_canvas_create();
     app->debugOverlay.fontReg = orca_font_create("../resources/Menlo.ttf");
     app->debugOverlay.fontBold = orca_font_create("../resources/Menlo Bold.ttf");
-    app->debugOverlay.maxEntries = 200;
-    oc_arena_init(&app->debugOverlay.logArena);
+    app->debugOverlay.logRing = oc_malloc_array(char, OC_DEBUG_LOG_RING_SIZE);
 
 #if OC_PLATFORM_WINDOWS
     //NOTE(martin): on windows we set all surfaces to non-synced, and do a single "manual" wait here.
@@ -979,6 +1124,7 @@ int main(int argc, char** argv)
     }
 
     oc_thread_join(runloopThread, NULL);
+    free(app->debugOverlay.logRing);
 
     oc_canvas_destroy(app->debugOverlay.canvas);
     oc_surface_destroy(app->debugOverlay.surface);
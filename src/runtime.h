@@ -78,16 +78,26 @@ typedef struct oc_wasm_env
 
 } oc_wasm_env;
 
+enum
+{
+    OC_DEBUG_LOG_RING_SIZE = 1 << 18,
+    OC_DEBUG_LOG_MAX_FUNCTION_LEN = 256,
+    OC_DEBUG_LOG_MAX_FILE_LEN = 1024,
+};
+
+//NOTE: log entries are variable-length records stored in a fixed-capacity byte ring, followed by their
+//      null-terminated function and file names and their message. Records are never split across the end
+//      of the ring, the space left there is marked with a padding record when a header fits in it.
 typedef struct log_entry
 {
-    oc_list_elt listElt;
-    u64 cap;
+    u32 size;
+    bool padding;
 
     oc_log_level level;
-    oc_str8 file;
-    oc_str8 function;
     int line;
-    oc_str8 msg;
+    u32 functionLen;
+    u32 fileLen;
+    u32 msgLen;
 
     u64 recordIndex;
 
@@ -102,19 +112,23 @@ typedef struct oc_debug_overlay
     oc_font fontBold;
     oc_ui_context ui;
 
-    oc_arena logArena;
-    oc_list logEntries;
-    oc_list logFreeList;
+    //NOTE: positions in the log ring are absolute byte offsets, the oldest record is at logHead
+    //      and the next one is written at logTail.
+    char* logRing;
+    u64 logHead;
+    u64 logTail;
     u32 entryCount;
-    u32 maxEntries;
     u64 logEntryTotalCount;
     bool logScrollToLast;
+    bool cleared;
 
 } oc_debug_overlay;
 
 typedef struct oc_runtime
 {
     bool quit;
+    bool frameRequested;
+    f64 frameDeadline; // time of the next frame requested with oc_request_frame_after(), or 0
     oc_window window;
     oc_debug_overlay debugOverlay;
 
@@ -203,22 +203,119 @@ bool oc_ui_key_equal(oc_ui_key a, oc_ui_key b)
     return (a.hash == b.hash);
 }
 
+static void oc_ui_box_map_insert(oc_ui_context* ui, oc_ui_box* box)
+{
+    u32 mask = ui->boxMapCap - 1;
+    u32 index = box->key.hash & mask;
+    while(ui->boxMap[index].box)
+    {
+        index = (index + 1) & mask;
+    }
+    ui->boxMap[index] = (oc_ui_box_map_entry){ .hash = box->key.hash, .box = box };
+}
+
+static void oc_ui_box_map_rebuild(oc_ui_context* ui, u32 cap)
+{
+    //NOTE: the previous map is left in the table arena until the next compaction
+    ui->boxMap = oc_arena_push_array(&ui->boxTableArena, oc_ui_box_map_entry, cap);
+    memset(ui->boxMap, 0, cap * sizeof(oc_ui_box_map_entry));
+    ui->boxMapCap = cap;
+
+    for(u32 i = 0; i < ui->boxCount; i++)
+    {
+        oc_ui_box_map_insert(ui, ui->boxes[i]);
+    }
+}
+
+static void oc_ui_box_map_remove(oc_ui_context* ui, oc_ui_box* box)
+{
+    u32 mask = ui->boxMapCap - 1;
+    u32 index = box->key.hash & mask;
+    while(ui->boxMap[index].box != box)
+    {
+        OC_DEBUG_ASSERT(ui->boxMap[index].box, "removing a box that is not in the box map");
+        index = (index + 1) & mask;
+    }
+
+    //NOTE: backward shift deletion, move up entries of the probe sequence that can fill the hole
+    u32 next = index;
+    while(1)
+    {
+        next = (next + 1) & mask;
+        if(!ui->boxMap[next].box)
+        {
+            break;
+        }
+        u32 ideal = ui->boxMap[next].hash & mask;
+        bool movable = (index <= next)
+                         ? (ideal <= index || ideal > next)
+                         : (ideal <= index && ideal > next);
+        if(movable)
+        {
+            ui->boxMap[index] = ui->boxMap[next];
+            index = next;
+        }
+    }
+    ui->boxMap[index] = (oc_ui_box_map_entry){ 0 };
+}
+
 void oc_ui_box_cache(oc_ui_context* ui, oc_ui_box* box)
 {
-    u64 index = box->key.hash & (OC_UI_BOX_MAP_BUCKET_COUNT - 1);
-    oc_list_append(&(ui->boxMap[index]), &box->bucketElt);
+    if(ui->boxCount >= ui->boxesCap)
+    {
+        u32 cap = oc_max(ui->boxesCap * 2, OC_UI_BOX_MAP_MIN_CAP);
+        oc_ui_box** boxes = oc_arena_push_array(&ui->boxTableArena, oc_ui_box*, cap);
+        if(ui->boxCount)
+        {
+            memcpy(boxes, ui->boxes, ui->boxCount * sizeof(oc_ui_box*));
+        }
+        ui->boxes = boxes;
+        ui->boxesCap = cap;
+    }
+    box->denseIndex = ui->boxCount;
+    ui->boxes[ui->boxCount] = box;
+    ui->boxCount++;
+
+    //NOTE: keep the map at most half full
+    if(ui->boxCount * 2 > ui->boxMapCap)
+    {
+        oc_ui_box_map_rebuild(ui, oc_max(ui->boxMapCap * 2, OC_UI_BOX_MAP_MIN_CAP));
+    }
+    else
+    {
+        oc_ui_box_map_insert(ui, box);
+    }
+}
+
+static void oc_ui_box_touch(oc_ui_context* ui, oc_ui_box* box)
+{
+    //NOTE: move the box to the front part of the dense array, which holds the boxes made this frame
+    u32 front = ui->touchedBoxCount;
+    oc_ui_box* other = ui->boxes[front];
+
+    ui->boxes[box->denseIndex] = other;
+    other->denseIndex = box->denseIndex;
+
+    ui->boxes[front] = box;
+    box->denseIndex = front;
+
+    ui->touchedBoxCount++;
 }
 
 oc_ui_box* oc_ui_box_lookup_key(oc_ui_key key)
 {
     oc_ui_context* ui = oc_ui_get_context();
-    u64 index = key.hash & (OC_UI_BOX_MAP_BUCKET_COUNT - 1);
-
-    oc_list_for(ui->boxMap[index], box, oc_ui_box, bucketElt)
+    if(ui->boxMapCap)
     {
-        if(oc_ui_key_equal(key, box->key))
+        u32 mask = ui->boxMapCap - 1;
+        u32 index = key.hash & mask;
+        while(ui->boxMap[index].box)
         {
-            return (box);
+            if(ui->boxMap[index].hash == key.hash)
+            {
+                return (ui->boxMap[index].box);
+            }
+            index = (index + 1) & mask;
         }
     }
     return (0);
@@ -230,6 +327,147 @@ oc_ui_box* oc_ui_box_lookup_str8(oc_str8 string)
     return (oc_ui_box_lookup_key(key));
 }
 
+//-----------------------------------------------------------------------------
+// style interning
+//-----------------------------------------------------------------------------
+
+static void oc_ui_style_map_insert(oc_ui_context* ui, oc_ui_style_record* record)
+{
+    u32 mask = ui->styleMapCap - 1;
+    u32 index = record->hash & mask;
+    while(ui->styleMap[index].record)
+    {
+        index = (index + 1) & mask;
+    }
+    ui->styleMap[index] = (oc_ui_style_map_entry){ .hash = record->hash, .record = record };
+}
+
+static void oc_ui_style_map_rebuild(oc_ui_context* ui, u32 cap)
+{
+    if(cap != ui->styleMapCap)
+    {
+        //NOTE: the map only grows, so the previous one can be left in the table arena
+        ui->styleMap = oc_arena_push_array(&ui->styleTableArena, oc_ui_style_map_entry, cap);
+        ui->styleMapCap = cap;
+    }
+    memset(ui->styleMap, 0, cap * sizeof(oc_ui_style_map_entry));
+
+    for(u32 i = 0; i < ui->styleCount; i++)
+    {
+        oc_ui_style_map_insert(ui, ui->styles[i]);
+    }
+}
+
+static oc_ui_style_record* oc_ui_style_intern(oc_ui_context* ui, oc_ui_style* style)
+{
+    //NOTE: copy the style attribute by attribute into a zeroed style, so that padding bytes are zero
+    //      and the style can be hashed and compared as a whole
+    oc_ui_style canonical;
+    memset(&canonical, 0, sizeof(oc_ui_style));
+    oc_ui_apply_style_with_mask(&canonical, style, ~0ULL);
+
+    u64 hash = oc_hash_xx64_string(oc_str8_from_buffer(sizeof(oc_ui_style), (char*)&canonical));
+
+    if(ui->styleMapCap)
+    {
+        u32 mask = ui->styleMapCap - 1;
+        u32 index = hash & mask;
+        while(ui->styleMap[index].record)
+        {
+            oc_ui_style_record* record = ui->styleMap[index].record;
+            if(ui->styleMap[index].hash == hash
+               && !memcmp(&record->style, &canonical, sizeof(oc_ui_style)))
+            {
+                record->frame = ui->frameCounter;
+                return (record);
+            }
+            index = (index + 1) & mask;
+        }
+    }
+
+    oc_ui_style_record* record = oc_pool_alloc_type(&ui->stylePool, oc_ui_style_record);
+    record->hash = hash;
+    record->frame = ui->frameCounter;
+    record->style = canonical;
+
+    if(ui->styleCount >= ui->stylesCap)
+    {
+        u32 cap = oc_max(ui->stylesCap * 2, OC_UI_STYLE_MAP_MIN_CAP);
+        oc_ui_style_record** styles = oc_arena_push_array(&ui->styleTableArena, oc_ui_style_record*, cap);
+        if(ui->styleCount)
+        {
+            memcpy(styles, ui->styles, ui->styleCount * sizeof(oc_ui_style_record*));
+        }
+        ui->styles = styles;
+        ui->stylesCap = cap;
+    }
+    ui->styles[ui->styleCount] = record;
+    ui->styleCount++;
+
+    //NOTE: keep the map at most half full
+    if(ui->styleCount * 2 > ui->styleMapCap)
+    {
+        oc_ui_style_map_rebuild(ui, oc_max(ui->styleMapCap * 2, OC_UI_STYLE_MAP_MIN_CAP));
+    }
+    else
+    {
+        oc_ui_style_map_insert(ui, record);
+    }
+    return (record);
+}
+
+static void oc_ui_style_sweep(oc_ui_context* ui)
+{
+    //NOTE: release the records that no box used this frame
+    u32 kept = 0;
+    for(u32 i = 0; i < ui->styleCount; i++)
+    {
+        oc_ui_style_record* record = ui->styles[i];
+        if(record->frame == ui->frameCounter)
+        {
+            ui->styles[kept] = record;
+            kept++;
+        }
+        else
+        {
+            oc_pool_recycle(&ui->stylePool, record);
+        }
+    }
+    if(kept != ui->styleCount)
+    {
+        ui->styleCount = kept;
+        oc_ui_style_map_rebuild(ui, ui->styleMapCap);
+    }
+}
+
+static oc_ui_style* oc_ui_style_default(oc_ui_context* ui)
+{
+    //NOTE: non-inherited attributes are set to default values, inherited ones are overwritten by the parent
+    if(!ui->defaultStyle
+       || ui->defaultStyle->frame != ui->frameCounter
+       || ui->defaultStyleTheme != ui->theme)
+    {
+        oc_ui_style defaultStyle = {
+            .size.width = { .kind = OC_UI_SIZE_CHILDREN,
+                            .value = 0,
+                            .relax = 0 },
+            .size.height = { .kind = OC_UI_SIZE_CHILDREN,
+                             .value = 0,
+                             .relax = 0 },
+
+            .layout = { .axis = OC_UI_AXIS_Y,
+                        .align = { OC_UI_ALIGN_START,
+                                   OC_UI_ALIGN_START } },
+            .bgColor = ui->theme->bg0,
+            .color = ui->theme->text0,
+            .fontSize = 14,
+        };
+        ui->defaultStyle = oc_ui_style_intern(ui, &defaultStyle);
+        ui->defaultStyleTheme = ui->theme;
+    }
+    return (&ui->defaultStyle->style);
+}
+
 //-----------------------------------------------------------------------------
 // styling
 //-----------------------------------------------------------------------------
@@ -238,6 +476,10 @@ void oc_ui_pattern_push(oc_arena* arena, oc_ui_pattern* pattern, oc_ui_selector
 {
     oc_ui_selector* copy = oc_arena_push_type(arena, oc_ui_selector);
     *copy = selector;
+    if(copy->kind == OC_UI_SEL_TEXT)
+    {
+        copy->textHash = oc_hash_xx64_string(copy->text);
+    }
     oc_list_append(&pattern->l, &copy->listElt);
 }
 
@@ -371,9 +613,9 @@ bool oc_ui_box_hovering(oc_ui_box* box, oc_vec2 p)
 {
     oc_ui_context* ui = oc_ui_get_context();
 
-    oc_rect clip = oc_ui_clip_top();
-    oc_rect rect = oc_ui_intersect_rects(clip, box->rect);
-    bool hit = oc_ui_rect_hit(rect, p);
+    //NOTE: hitRect is the box's rect clipped by its ancestors, as computed when building the hit grid.
+    //      Boxes that weren't laid out during the last frame can't be hovered.
+    bool hit = (box->hitFrame == ui->hitGrid.frame) && oc_ui_rect_hit(box->hitRect, p);
     bool result = hit && (!ui->hovered || box->z >= ui->hovered->z);
     return (result);
 }
@@ -387,6 +629,10 @@ oc_ui_box* oc_ui_box_make_str8(oc_str8 string, oc_ui_flags flags)
 
     if(!box)
     {
+        if(ui->freeBoxCount)
+        {
+            ui->freeBoxCount--;
+        }
         box = oc_pool_alloc_type(&ui->boxPool, oc_ui_box);
         memset(box, 0, sizeof(oc_ui_box));
 
@@ -402,6 +648,8 @@ oc_ui_box* oc_ui_box_make_str8(oc_str8 string, oc_ui_flags flags)
     //NOTE: setup hierarchy
     if(box->frameCounter != ui->frameCounter)
     {
+        oc_ui_box_touch(ui, box);
+
         oc_list_init(&box->children);
         box->parent = oc_ui_box_top();
         if(box->parent)
@@ -423,27 +671,26 @@ oc_ui_box* oc_ui_box_make_str8(oc_str8 string, oc_ui_flags flags)
 
     //NOTE: setup per-frame state
     box->frameCounter = ui->frameCounter;
-    box->string = oc_str8_push_copy(&ui->frameArena, string);
     box->flags = flags;
 
-    //NOTE: create style and setup non-inherited attributes to default values
-    box->targetStyle = oc_arena_push_type(&ui->frameArena, oc_ui_style);
-    oc_ui_style defaultStyle = {
-        .size.width = { .kind = OC_UI_SIZE_CHILDREN,
-                        .value = 0,
-                        .relax = 0 },
-        .size.height = { .kind = OC_UI_SIZE_CHILDREN,
-                         .value = 0,
-                         .relax = 0 },
-
-        .layout = { .axis = OC_UI_AXIS_Y,
-                    .align = { OC_UI_ALIGN_START,
-                               OC_UI_ALIGN_START } },
-        .bgColor = ui->theme->bg0,
-        .color = ui->theme->text0,
-        .fontSize = 14,
-    };
-    oc_ui_apply_style_with_mask(box->targetStyle, &defaultStyle, ~0ULL);
+    //NOTE: the box string is kept across frames and only copied when it changed
+    if(box->string.len != string.len
+       || (string.len && memcmp(box->string.ptr, string.ptr, string.len)))
+    {
+        if(string.len > box->stringCap)
+        {
+            u64 cap = oc_max(string.len, 2 * box->stringCap);
+            box->string.ptr = oc_arena_push_array(&ui->boxStringArena, char, cap);
+            ui->boxStringBytes += cap;
+            ui->liveBoxStringBytes += cap - box->stringCap;
+            box->stringCap = cap;
+        }
+        memcpy(box->string.ptr, string.ptr, string.len);
+        box->string.len = string.len;
+    }
+
+    //NOTE: start from the shared default style. The target style is resolved and interned during the styling prepass
+    box->targetStyle = oc_ui_style_default(ui);
 
     //NOTE: set tags, before rules and last box
     box->tags = ui->nextBoxTags;
@@ -612,6 +859,30 @@ bool oc_ui_box_hidden(oc_ui_box* box)
 // Auto-layout
 //-----------------------------------------------------------------------------
 
+static void oc_ui_request_frame(oc_ui_context* ui)
+{
+    //NOTE: animations need another frame even if no event comes in
+    if(!ui->frameRequested)
+    {
+        ui->frameRequested = true;
+#if OC_PLATFORM_ORCA
+        oc_request_frame();
+#endif
+    }
+}
+
+static void oc_ui_request_frame_at(oc_ui_context* ui, f64 time)
+{
+    //NOTE: request a frame at a given time, without refreshing frames until then
+    if(!ui->frameDeadline || time < ui->frameDeadline)
+    {
+        ui->frameDeadline = time;
+#if OC_PLATFORM_ORCA
+        oc_request_frame_after(time - oc_clock_time(OC_CLOCK_MONOTONIC));
+#endif
+    }
+}
+
 void oc_ui_animate_f32(oc_ui_context* ui, f32* value, f32 target, f32 animationTime)
 {
     if(animationTime < 1e-6
@@ -632,7 +903,11 @@ void oc_ui_animate_f32(oc_ui_context* ui, f32* value, f32 target, f32 animationT
         f32 alpha = 3 / animationTime;
         f32 dt = ui->lastFrameDuration;
 
-        *value += (target - *value) * alpha * dt;
+        //NOTE: frames are not refreshed while idle, so the first frame after a pause can have a large dt.
+        //      Clamp the step so that we don't overshoot the target.
+        *value += (target - *value) * oc_min(alpha * dt, 1.f);
+
+        oc_ui_request_frame(ui);
     }
 }
 
@@ -830,7 +1105,7 @@ void oc_ui_apply_style_with_mask(oc_ui_style* dst, oc_ui_style* src, oc_ui_style
     }
 }
 
-bool oc_ui_style_selector_match(oc_ui_box* box, oc_ui_style_rule* rule, oc_ui_selector* selector)
+bool oc_ui_style_selector_match(oc_ui_box* box, u64 textHash, oc_ui_style_rule* rule, oc_ui_selector* selector)
 {
     bool res = false;
     switch(selector->kind)
@@ -844,7 +1119,7 @@ bool oc_ui_style_selector_match(oc_ui_box* box, oc_ui_style_rule* rule, oc_ui_se
             break;
 
         case OC_UI_SEL_TEXT:
-            res = !oc_str8_cmp(box->string, selector->text);
+            res = (textHash == selector->textHash) && !oc_str8_cmp(box->string, selector->text);
             break;
 
         case OC_UI_SEL_TAG:
@@ -890,15 +1165,79 @@ bool oc_ui_style_selector_match(oc_ui_box* box, oc_ui_style_rule* rule, oc_ui_se
     return (res);
 }
 
-void oc_ui_style_rule_match(oc_ui_context* ui, oc_ui_box* box, oc_ui_style_rule* rule, oc_list* buildList, oc_list* tmpList)
+//NOTE: active style rules are bucketed by the kind and hash of their first selector, so that each box
+//      only tests rules that can possibly match it. Rules whose first selector doesn't depend on the box's
+//      identity (any, status) go in the generic list. The order field reproduces the ordering of the
+//      original rule lists: before rules are appended, after rules of a box are prepended.
+enum
+{
+    OC_UI_RULE_INDEX_BUCKET_COUNT = 64,
+};
+
+typedef struct oc_ui_rule_index
+{
+    oc_list generic;
+    oc_list buckets[OC_UI_RULE_INDEX_BUCKET_COUNT];
+    i64 headOrder;
+    i64 tailOrder;
+    u32 textRuleCount;
+} oc_ui_rule_index;
+
+static oc_list* oc_ui_rule_index_bucket(oc_ui_rule_index* index, oc_ui_selector_kind kind, u64 hash)
+{
+    u64 slot = (hash ^ ((u64)kind * 0x9e3779b97f4a7c15ULL)) & (OC_UI_RULE_INDEX_BUCKET_COUNT - 1);
+    return (&index->buckets[slot]);
+}
+
+static void oc_ui_rule_index_insert(oc_ui_rule_index* index, oc_ui_style_rule* rule, bool front)
+{
+    oc_ui_selector* selector = oc_list_first_entry(rule->pattern.l, oc_ui_selector, listElt);
+
+    rule->bucket = &index->generic;
+    if(selector)
+    {
+        switch(selector->kind)
+        {
+            case OC_UI_SEL_OWNER:
+                rule->bucket = oc_ui_rule_index_bucket(index, OC_UI_SEL_OWNER, (u64)(uintptr_t)rule->owner);
+                break;
+            case OC_UI_SEL_TEXT:
+                rule->bucket = oc_ui_rule_index_bucket(index, OC_UI_SEL_TEXT, selector->textHash);
+                index->textRuleCount++;
+                break;
+            case OC_UI_SEL_TAG:
+                rule->bucket = oc_ui_rule_index_bucket(index, OC_UI_SEL_TAG, selector->tag.hash);
+                break;
+            case OC_UI_SEL_KEY:
+                rule->bucket = oc_ui_rule_index_bucket(index, OC_UI_SEL_KEY, selector->key.hash);
+                break;
+            default:
+                break;
+        }
+    }
+    rule->order = front ? --index->headOrder : index->tailOrder++;
+    oc_list_append(rule->bucket, &rule->buildElt);
+}
+
+static void oc_ui_rule_index_remove(oc_ui_rule_index* index, oc_ui_style_rule* rule)
+{
+    oc_ui_selector* selector = oc_list_first_entry(rule->pattern.l, oc_ui_selector, listElt);
+    if(selector && selector->kind == OC_UI_SEL_TEXT)
+    {
+        index->textRuleCount--;
+    }
+    oc_list_remove(rule->bucket, &rule->buildElt);
+}
+
+void oc_ui_style_rule_match(oc_ui_context* ui, oc_ui_box* box, oc_ui_style* style, u64 textHash, oc_ui_style_rule* rule, oc_ui_rule_index* index, oc_list* tmpList)
 {
     oc_ui_selector* selector = oc_list_first_entry(rule->pattern.l, oc_ui_selector, listElt);
-    bool match = oc_ui_style_selector_match(box, rule, selector);
+    bool match = oc_ui_style_selector_match(box, textHash, rule, selector);
 
     selector = oc_list_next_entry(rule->pattern.l, selector, oc_ui_selector, listElt);
     while(match && selector && selector->op == OC_UI_SEL_AND)
     {
-        match = match && oc_ui_style_selector_match(box, rule, selector);
+        match = match && oc_ui_style_selector_match(box, textHash, rule, selector);
         selector = oc_list_next_entry(rule->pattern.l, selector, oc_ui_selector, listElt);
     }
 
@@ -906,58 +1245,143 @@ void oc_ui_style_rule_match(oc_ui_context* ui, oc_ui_box* box, oc_ui_style_rule*
     {
         if(!selector)
         {
-            oc_ui_apply_style_with_mask(box->targetStyle, rule->style, rule->mask);
+            oc_ui_apply_style_with_mask(style, rule->style, rule->mask);
         }
         else
         {
             //NOTE create derived rule if there's more than one selector
             oc_ui_style_rule* derived = oc_arena_push_type(&ui->frameArena, oc_ui_style_rule);
+            derived->owner = rule->owner;
             derived->mask = rule->mask;
             derived->style = rule->style;
             derived->pattern.l = (oc_list){ &selector->listElt, rule->pattern.l.last };
 
-            oc_list_append(buildList, &derived->buildElt);
+            oc_ui_rule_index_insert(index, derived, false);
             oc_list_append(tmpList, &derived->tmpElt);
         }
     }
 }
 
-void oc_ui_styling_prepass(oc_ui_context* ui, oc_ui_box* box, oc_list* before, oc_list* after)
+static void oc_ui_rule_index_match(oc_ui_context* ui, oc_ui_box* box, oc_ui_style* style, u64 textHash, oc_ui_rule_index* index, oc_list* tmpList)
 {
+    //NOTE: collect the buckets that can hold rules matching this box
+    oc_arena_scope scratch = oc_scratch_begin();
+
+    u32 tagCount = 0;
+    oc_list_for(box->tags, elt, oc_ui_tag_elt, listElt)
+    {
+        tagCount++;
+    }
+
+    u32 listCount = 0;
+    oc_list** lists = oc_arena_push_array(scratch.arena, oc_list*, 4 + tagCount);
+
+    lists[listCount++] = &index->generic;
+    lists[listCount++] = oc_ui_rule_index_bucket(index, OC_UI_SEL_OWNER, (u64)(uintptr_t)box);
+    lists[listCount++] = oc_ui_rule_index_bucket(index, OC_UI_SEL_KEY, box->key.hash);
+    if(index->textRuleCount)
+    {
+        lists[listCount++] = oc_ui_rule_index_bucket(index, OC_UI_SEL_TEXT, textHash);
+    }
+    oc_list_for(box->tags, elt, oc_ui_tag_elt, listElt)
+    {
+        lists[listCount++] = oc_ui_rule_index_bucket(index, OC_UI_SEL_TAG, elt->tag.hash);
+    }
+
+    //NOTE: gather candidate rules and sort them in rule order
+    u32 candidateCount = 0;
+    for(u32 i = 0; i < listCount; i++)
+    {
+        oc_list_for(*lists[i], rule, oc_ui_style_rule, buildElt)
+        {
+            candidateCount++;
+        }
+    }
+
+    oc_ui_style_rule** candidates = oc_arena_push_array(scratch.arena, oc_ui_style_rule*, candidateCount);
+    u32 count = 0;
+    for(u32 i = 0; i < listCount; i++)
+    {
+        oc_list_for(*lists[i], rule, oc_ui_style_rule, buildElt)
+        {
+            u32 slot = count;
+            while(slot > 0 && candidates[slot - 1]->order > rule->order)
+            {
+                candidates[slot] = candidates[slot - 1];
+                slot--;
+            }
+            candidates[slot] = rule;
+            count++;
+        }
+    }
+
+    //NOTE: derived rules created while matching are also matched against this box, after all existing rules
+    i64 derivedOrder = index->tailOrder;
+
+    oc_ui_style_rule* prev = 0;
+    for(u32 i = 0; i < count; i++)
+    {
+        //NOTE: two lookups can hit the same bucket, skip duplicates
+        if(candidates[i] != prev)
+        {
+            oc_ui_style_rule_match(ui, box, style, textHash, candidates[i], index, tmpList);
+        }
+        prev = candidates[i];
+    }
+
+    oc_list_for(*tmpList, rule, oc_ui_style_rule, tmpElt)
+    {
+        if(rule->order >= derivedOrder)
+        {
+            oc_ui_style_rule_match(ui, box, style, textHash, rule, index, tmpList);
+        }
+    }
+
+    oc_scratch_end(scratch);
+}
+
+void oc_ui_styling_prepass(oc_ui_context* ui, oc_ui_box* box, oc_ui_rule_index* before, oc_ui_rule_index* after)
+{
+    //NOTE: resolve the target style in a working copy, starting from the box's default style
+    oc_ui_style targetStyle = *box->targetStyle;
+
     //NOTE: inherit style from parent
     if(box->parent)
     {
-        oc_ui_apply_style_with_mask(box->targetStyle,
+        oc_ui_apply_style_with_mask(&targetStyle,
                                     box->parent->targetStyle,
                                     OC_UI_STYLE_MASK_INHERITED);
     }
 
-    //NOTE: append box before rules to before and tmp
+    u64 stringHash = 0;
+    if(before->textRuleCount || after->textRuleCount)
+    {
+        stringHash = oc_hash_xx64_string(box->string);
+    }
+
+    //NOTE: add box before rules to before index and tmp
     oc_list tmpBefore = { 0 };
     oc_list_for(box->beforeRules, rule, oc_ui_style_rule, boxElt)
     {
-        oc_list_append(before, &rule->buildElt);
+        oc_ui_rule_index_insert(before, rule, false);
         oc_list_append(&tmpBefore, &rule->tmpElt);
     }
     //NOTE: match before rules
-    oc_list_for(*before, rule, oc_ui_style_rule, buildElt)
-    {
-        oc_ui_style_rule_match(ui, box, rule, before, &tmpBefore);
-    }
+    oc_ui_rule_index_match(ui, box, &targetStyle, stringHash, before, &tmpBefore);
 
-    //NOTE: prepend box after rules to after and append them to tmp
+    //NOTE: prepend box after rules to after index and append them to tmp
     oc_list tmpAfter = { 0 };
     oc_list_for_reverse(box->afterRules, rule, oc_ui_style_rule, boxElt)
     {
-        oc_list_push(after, &rule->buildElt);
+        oc_ui_rule_index_insert(after, rule, true);
         oc_list_append(&tmpAfter, &rule->tmpElt);
     }
 
     //NOTE: match after rules
-    oc_list_for(*after, rule, oc_ui_style_rule, buildElt)
-    {
-        oc_ui_style_rule_match(ui, box, rule, after, &tmpAfter);
-    }
+    oc_ui_rule_index_match(ui, box, &targetStyle, stringHash, after, &tmpAfter);
+
+    //NOTE: share the resolved style with the boxes that have the same one
+    box->targetStyle = &oc_ui_style_intern(ui, &targetStyle)->style;
 
     //NOTE: compute static sizes
     oc_ui_box_animate_style(ui, box);
@@ -969,16 +1393,26 @@ void oc_ui_styling_prepass(oc_ui_context* ui, oc_ui_box* box, oc_list* before, o
 
     oc_ui_style* style = &box->style;
 
-    oc_rect textBox = { 0 };
     oc_ui_size desiredSize[2] = { box->style.size.c[OC_UI_AXIS_X],
                                   box->style.size.c[OC_UI_AXIS_Y] };
 
     if(desiredSize[OC_UI_AXIS_X].kind == OC_UI_SIZE_TEXT
        || desiredSize[OC_UI_AXIS_Y].kind == OC_UI_SIZE_TEXT)
     {
-        textBox = oc_font_text_metrics(style->font, style->fontSize, box->string).logical;
+        //NOTE: only re-measure text when the string or font changed
+        u64 textHash = oc_hash_xx64_string_seed(oc_str8_from_buffer(sizeof(f32), (char*)&style->fontSize), style->font.h);
+        textHash = oc_hash_xx64_string_seed(box->string, textHash);
+
+        if(textHash != box->textHash)
+        {
+            oc_rect textBox = oc_font_text_metrics(style->font, style->fontSize, box->string).logical;
+            box->textSize = (oc_vec2){ textBox.w, textBox.h };
+            box->textHash = textHash;
+        }
     }
 
+    //NOTE: static sizes are kept out of the box's rect, so that the rects of unchanged subtrees
+    //      survive until we know whether their layout can be reused
     for(int i = 0; i < OC_UI_AXIS_COUNT; i++)
     {
         oc_ui_size size = desiredSize[i];
@@ -986,11 +1420,11 @@ void oc_ui_styling_prepass(oc_ui_context* ui, oc_ui_box* box, oc_list* before, o
         if(size.kind == OC_UI_SIZE_TEXT)
         {
             f32 margin = style->layout.margin.c[i];
-            box->rect.c[2 + i] = textBox.c[2 + i] + margin * 2;
+            box->staticSize[i] = box->textSize.c[i] + margin * 2;
         }
         else if(size.kind == OC_UI_SIZE_PIXELS)
         {
-            box->rect.c[2 + i] = size.value;
+            box->staticSize[i] = size.value;
         }
     }
 
@@ -1003,14 +1437,59 @@ void oc_ui_styling_prepass(oc_ui_context* ui, oc_ui_box* box, oc_list* before, o
     //NOTE: remove temporary rules
     oc_list_for(tmpBefore, rule, oc_ui_style_rule, tmpElt)
     {
-        oc_list_remove(before, &rule->buildElt);
+        oc_ui_rule_index_remove(before, rule);
     }
     oc_list_for(tmpAfter, rule, oc_ui_style_rule, tmpElt)
     {
-        oc_list_remove(after, &rule->buildElt);
+        oc_ui_rule_index_remove(after, rule);
     }
 }
 
+typedef struct oc_ui_layout_inputs
+{
+    oc_ui_box_size size;
+    oc_ui_layout layout;
+    oc_ui_box_floating floating;
+    oc_vec2 floatTarget;
+    oc_vec2 scroll;
+    oc_font font;
+    f32 fontSize;
+    oc_ui_flags flags;
+    u32 hidden;
+    u64 key;
+} oc_ui_layout_inputs;
+
+void oc_ui_layout_hash(oc_ui_context* ui, oc_ui_box* box)
+{
+    //NOTE: hash everything the layout of box's subtree depends on. If the hash didn't change since last frame,
+    //      the subtree's sizes and positions can be reused as long as the constraints set by its parent match.
+    oc_ui_layout_inputs inputs;
+    memset(&inputs, 0, sizeof(oc_ui_layout_inputs));
+
+    inputs.size = box->style.size;
+    inputs.layout = box->style.layout;
+    inputs.floating = box->style.floating;
+    inputs.floatTarget = box->style.floatTarget;
+    inputs.scroll = box->scroll;
+    inputs.font = box->style.font;
+    inputs.fontSize = box->style.fontSize;
+    inputs.flags = box->flags;
+    inputs.hidden = oc_ui_box_hidden(box);
+    inputs.key = box->key.hash;
+
+    u64 hash = oc_hash_xx64_string(oc_str8_from_buffer(sizeof(oc_ui_layout_inputs), (char*)&inputs));
+    hash = oc_hash_xx64_string_seed(box->string, hash);
+
+    oc_list_for(box->children, child, oc_ui_box, listElt)
+    {
+        oc_ui_layout_hash(ui, child);
+        hash = oc_hash_xx64_string_seed(oc_str8_from_buffer(sizeof(u64), (char*)&child->layoutHash), hash);
+    }
+
+    box->layoutReuse = (hash == box->layoutHash);
+    box->layoutHash = hash;
+}
+
 bool oc_ui_layout_downward_dependency(oc_ui_box* child, int axis)
 {
     return (!oc_ui_box_hidden(child)
@@ -1021,6 +1500,14 @@ bool oc_ui_layout_downward_dependency(oc_ui_box* child, int axis)
 
 void oc_ui_layout_downward_dependent_size(oc_ui_context* ui, oc_ui_box* box, int axis)
 {
+    if(box->layoutReuse)
+    {
+        //NOTE: the subtree didn't change, restore the sizes computed by the last downward pass
+        box->minSize[axis] = box->downwardMinSize[axis];
+        box->rect.c[2 + axis] = box->downwardSize[axis];
+        return;
+    }
+
     //NOTE: layout children and compute spacing and minimum size
     i32 count = 0;
     f32 minSum = 0;
@@ -1051,6 +1538,7 @@ void oc_ui_layout_downward_dependent_size(oc_ui_context* ui, oc_ui_box* box, int
     {
         case OC_UI_SIZE_TEXT:
         case OC_UI_SIZE_PIXELS:
+            box->rect.c[2 + axis] = box->staticSize[axis];
             box->minSize[axis] = box->rect.c[2 + axis];
             break;
 
@@ -1099,10 +1587,40 @@ void oc_ui_layout_downward_dependent_size(oc_ui_context* ui, oc_ui_box* box, int
         f32 margin = box->style.layout.margin.c[axis];
         box->rect.c[2 + axis] = sum + box->spacing[axis] + 2 * margin;
     }
+
+    box->downwardMinSize[axis] = box->minSize[axis];
+    box->downwardSize[axis] = box->rect.c[2 + axis];
 }
 
 void oc_ui_layout_upward_dependent_size(oc_ui_context* ui, oc_ui_box* box, int axis)
 {
+    if(box->layoutReuse)
+    {
+        if(box->upwardSize[axis] == box->rect.c[2 + axis]
+           && box->upwardMinSize[axis] == box->minSize[axis])
+        {
+            //NOTE: the subtree didn't change and its parent gives it the same constraints as last frame,
+            //      so the children's sizes and children sum are still valid
+            return;
+        }
+
+        //NOTE: the constraints changed, so we must solve them again. The downward pass skipped the children, which
+        //      still hold the sizes relaxed by last frame's upward pass, and a minimum size raised by it. Restore
+        //      their downward sizes first, so that a subtree shrunk last frame can grow back. Grand-children are
+        //      restored in the same way if their own constraints changed.
+        oc_list_for(box->children, child, oc_ui_box, listElt)
+        {
+            if(!oc_ui_box_hidden(child))
+            {
+                child->minSize[axis] = child->downwardMinSize[axis];
+                child->rect.c[2 + axis] = child->downwardSize[axis];
+            }
+        }
+    }
+    box->layoutReuse = false;
+    box->upwardSize[axis] = box->rect.c[2 + axis];
+    box->upwardMinSize[axis] = box->minSize[axis];
+
     //NOTE: re-compute/set size of children that depend on box's size
 
     f32 margin = box->style.layout.margin.c[axis];
@@ -1326,6 +1844,21 @@ void oc_ui_layout_compute_rect(oc_ui_context* ui, oc_ui_box* box, oc_vec2 pos)
         return;
     }
 
+    if(box->layoutReuse
+       && !box->layoutAnimating
+       && box->layoutPos.x == pos.x
+       && box->layoutPos.y == pos.y
+       && box->layoutZ == ui->z)
+    {
+        //NOTE: the subtree's sizes, position and z-order didn't change, its rects are still valid
+        ui->z += box->layoutZCount;
+        ui->reusedLayoutCount++;
+        return;
+    }
+    box->layoutPos = pos;
+    box->layoutZ = ui->z;
+    box->layoutAnimating = false;
+
     box->rect.x = pos.x;
     box->rect.y = pos.y;
     box->z = ui->z;
@@ -1391,11 +1924,17 @@ void oc_ui_layout_compute_rect(oc_ui_context* ui, oc_ui_box* box, oc_vec2 pos)
 
         oc_ui_layout_compute_rect(ui, child, childPos);
 
+        box->layoutAnimating = box->layoutAnimating
+                            || child->layoutAnimating
+                            || (child->style.floating.x && child->floatPos.x != child->style.floatTarget.x)
+                            || (child->style.floating.y && child->floatPos.y != child->style.floatTarget.y);
+
         if(!child->style.floating.c[layoutAxis])
         {
             currentPos.c[layoutAxis] += child->rect.c[2 + layoutAxis] + spacing;
         }
     }
+    box->layoutZCount = ui->z - box->layoutZ;
     if(isnan(box->rect.w) || isnan(box->rect.h))
     {
         oc_log_error("error in box %.*s\n", oc_str8_ip(box->string));
@@ -1403,41 +1942,170 @@ void oc_ui_layout_compute_rect(oc_ui_context* ui, oc_ui_box* box, oc_vec2 pos)
     }
 }
 
-void oc_ui_layout_find_next_hovered_recursive(oc_ui_context* ui, oc_ui_box* box, oc_vec2 p)
+//-----------------------------------------------------------------------------
+// Hit grid
+//-----------------------------------------------------------------------------
+
+static void oc_ui_hit_grid_collect(oc_ui_context* ui, oc_ui_box* box, oc_rect clip)
 {
     if(oc_ui_box_hidden(box))
     {
         return;
     }
+    oc_ui_hit_grid* grid = &ui->hitGrid;
 
-    bool hit = oc_ui_rect_hit(box->rect, p);
-    if(hit && (box->flags & OC_UI_FLAG_BLOCK_MOUSE))
+    oc_rect rect = oc_ui_intersect_rects(clip, box->rect);
+    box->hitRect = rect;
+    box->hitFrame = grid->frame;
+    box->hitIndex = ~0u;
+
+    bool empty = (rect.w <= 0 || rect.h <= 0);
+
+    if(!empty && (box->flags & OC_UI_FLAG_BLOCK_MOUSE))
     {
-        ui->hovered = box;
+        if(grid->boxCount >= grid->boxCap)
+        {
+            grid->boxCap = oc_max(2 * grid->boxCap, 256);
+            oc_ui_box** boxes = oc_arena_push_array(&grid->arena, oc_ui_box*, grid->boxCap);
+            memcpy(boxes, grid->boxes, grid->boxCount * sizeof(oc_ui_box*));
+            grid->boxes = boxes;
+        }
+        box->hitIndex = grid->boxCount;
+        grid->boxes[grid->boxCount] = box;
+        grid->boxCount++;
     }
-    if(hit || !(box->flags & OC_UI_FLAG_CLIP))
+
+    if(box->flags & OC_UI_FLAG_CLIP)
     {
-        oc_list_for(box->children, child, oc_ui_box, listElt)
+        if(empty)
         {
-            oc_ui_layout_find_next_hovered_recursive(ui, child, p);
+            //NOTE: the whole subtree is clipped out and can't be hovered
+            return;
+        }
+        clip = rect;
+    }
+
+    oc_list_for(box->children, child, oc_ui_box, listElt)
+    {
+        oc_ui_hit_grid_collect(ui, child, clip);
+    }
+}
+
+static i32 oc_ui_hit_grid_cell_coord(oc_ui_hit_grid* grid, f32 p, int axis)
+{
+    f32 coord = floor((p - grid->bounds.c[axis]) / grid->cellSize.c[axis]);
+    return ((i32)oc_clamp(coord, 0, OC_UI_HIT_GRID_DIM - 1));
+}
+
+static void oc_ui_hit_grid_cell_range(oc_ui_hit_grid* grid, oc_rect rect, i32* x0, i32* y0, i32* x1, i32* y1)
+{
+    *x0 = oc_ui_hit_grid_cell_coord(grid, rect.x, OC_UI_AXIS_X);
+    *y0 = oc_ui_hit_grid_cell_coord(grid, rect.y, OC_UI_AXIS_Y);
+    *x1 = oc_ui_hit_grid_cell_coord(grid, rect.x + rect.w, OC_UI_AXIS_X);
+    *y1 = oc_ui_hit_grid_cell_coord(grid, rect.y + rect.h, OC_UI_AXIS_Y);
+}
+
+static void oc_ui_hit_grid_build(oc_ui_context* ui)
+{
+    oc_ui_hit_grid* grid = &ui->hitGrid;
+
+    //NOTE: reserve room for as many boxes as the previous grid, so that the array rarely needs to grow
+    oc_arena_clear(&grid->arena);
+    grid->boxCap = oc_max(grid->boxCount, 256);
+    grid->boxes = oc_arena_push_array(&grid->arena, oc_ui_box*, grid->boxCap);
+
+    //NOTE: collect blocking boxes in traversal order, which is also increasing z order
+    grid->frame = ui->frameCounter;
+    grid->boxCount = 0;
+    grid->bounds = ui->root->rect;
+    grid->cellSize = (oc_vec2){ oc_max(grid->bounds.w, 1) / OC_UI_HIT_GRID_DIM,
+                                oc_max(grid->bounds.h, 1) / OC_UI_HIT_GRID_DIM };
+
+    oc_rect noClip = { -FLT_MAX / 2, -FLT_MAX / 2, FLT_MAX, FLT_MAX };
+    oc_ui_hit_grid_collect(ui, ui->root, noClip);
+
+    //NOTE: count boxes per cell, then turn counts into cell end offsets
+    const u32 cellCount = OC_UI_HIT_GRID_DIM * OC_UI_HIT_GRID_DIM;
+    memset(grid->cellStart, 0, sizeof(grid->cellStart));
+
+    for(u32 i = 0; i < grid->boxCount; i++)
+    {
+        i32 x0, y0, x1, y1;
+        oc_ui_hit_grid_cell_range(grid, grid->boxes[i]->hitRect, &x0, &y0, &x1, &y1);
+        for(i32 y = y0; y <= y1; y++)
+        {
+            for(i32 x = x0; x <= x1; x++)
+            {
+                grid->cellStart[y * OC_UI_HIT_GRID_DIM + x]++;
+            }
+        }
+    }
+
+    u32 itemCount = 0;
+    for(u32 cell = 0; cell < cellCount; cell++)
+    {
+        itemCount += grid->cellStart[cell];
+        grid->cellStart[cell] = itemCount;
+    }
+    grid->cellStart[cellCount] = itemCount;
+
+    grid->items = oc_arena_push_array(&grid->arena, u32, itemCount);
+
+    //NOTE: fill cells back to front, so that each cell ends up starting at its offset and sorted by z
+    for(i32 i = (i32)grid->boxCount - 1; i >= 0; i--)
+    {
+        i32 x0, y0, x1, y1;
+        oc_ui_hit_grid_cell_range(grid, grid->boxes[i]->hitRect, &x0, &y0, &x1, &y1);
+        for(i32 y = y0; y <= y1; y++)
+        {
+            for(i32 x = x0; x <= x1; x++)
+            {
+                u32 cell = y * OC_UI_HIT_GRID_DIM + x;
+                grid->cellStart[cell]--;
+                grid->items[grid->cellStart[cell]] = i;
+            }
         }
     }
 }
 
-void oc_ui_layout_find_next_hovered(oc_ui_context* ui, oc_vec2 p)
+oc_ui_box* oc_ui_hit_test(oc_vec2 p)
 {
-    ui->hovered = 0;
-    oc_ui_layout_find_next_hovered_recursive(ui, ui->root, p);
+    oc_ui_context* ui = oc_ui_get_context();
+    oc_ui_hit_grid* grid = &ui->hitGrid;
+
+    if(!grid->boxCount || !oc_ui_rect_hit(grid->bounds, p))
+    {
+        return (0);
+    }
+
+    i32 x = oc_ui_hit_grid_cell_coord(grid, p.x, OC_UI_AXIS_X);
+    i32 y = oc_ui_hit_grid_cell_coord(grid, p.y, OC_UI_AXIS_Y);
+    u32 cell = y * OC_UI_HIT_GRID_DIM + x;
+
+    //NOTE: return the topmost box of the cell containing p
+    for(u32 i = grid->cellStart[cell + 1]; i > grid->cellStart[cell]; i--)
+    {
+        oc_ui_box* box = grid->boxes[grid->items[i - 1]];
+        if(oc_ui_rect_hit(box->hitRect, p))
+        {
+            return (box);
+        }
+    }
+    return (0);
 }
 
 void oc_ui_solve_layout(oc_ui_context* ui)
 {
-    oc_list beforeRules = { 0 };
-    oc_list afterRules = { 0 };
+    oc_ui_rule_index beforeRules = { 0 };
+    oc_ui_rule_index afterRules = { 0 };
+
+    f64 startTime = oc_clock_time(OC_CLOCK_MONOTONIC);
 
     //NOTE: style and compute static sizes
     oc_ui_styling_prepass(ui, ui->root, &beforeRules, &afterRules);
 
+    f64 stylingEndTime = oc_clock_time(OC_CLOCK_MONOTONIC);
+
     //NOTE: reparent overlay boxes
     oc_list_for(ui->overlayList, box, oc_ui_box, overlayElt)
     {
@@ -1448,6 +2116,10 @@ void oc_ui_solve_layout(oc_ui_context* ui)
         }
     }
 
+    //NOTE: find subtrees whose layout can be reused from last frame
+    oc_ui_layout_hash(ui, ui->root);
+    ui->reusedLayoutCount = 0;
+
     //NOTE: compute layout
     for(int axis = 0; axis < OC_UI_AXIS_COUNT; axis++)
     {
@@ -1458,8 +2130,17 @@ void oc_ui_solve_layout(oc_ui_context* ui)
     }
     oc_ui_layout_compute_rect(ui, ui->root, (oc_vec2){ 0, 0 });
 
-    oc_vec2 p = oc_ui_mouse_position();
-    oc_ui_layout_find_next_hovered(ui, p);
+    f64 layoutEndTime = oc_clock_time(OC_CLOCK_MONOTONIC);
+
+    //NOTE: index blocking boxes for hover queries until the next layout
+    oc_ui_hit_grid_build(ui);
+    ui->hovered = oc_ui_hit_test(oc_ui_mouse_position());
+
+    f64 endTime = oc_clock_time(OC_CLOCK_MONOTONIC);
+
+    ui->stylingTime = stylingEndTime - startTime;
+    ui->layoutTime = layoutEndTime - stylingEndTime;
+    ui->hitTestTime = endTime - layoutEndTime;
 }
 
 //-----------------------------------------------------------------------------
@@ -1582,9 +2263,7 @@ void oc_ui_draw_box(oc_ui_box* box)
         oc_set_font_size(style->fontSize);
         oc_set_color(style->color);
 
-        oc_move_to(x, y);
-        oc_text_outlines(box->string);
-        oc_fill();
+        oc_text_fill(x, y, box->string);
     }
 
     if(box->flags & OC_UI_FLAG_CLIP)
@@ -1626,14 +2305,150 @@ void oc_ui_draw()
 // frame begin/end
 //-----------------------------------------------------------------------------
 
+static void oc_ui_box_recycle(oc_ui_context* ui, oc_ui_box* box)
+{
+    //NOTE: scrub the box so that no stale pointer to the frame arena or to other boxes survives in the pool
+    if(ui->focus == box)
+    {
+        ui->focus = 0;
+    }
+    if(ui->hovered == box)
+    {
+        ui->hovered = 0;
+    }
+    ui->liveBoxStringBytes -= box->stringCap;
+    memset(box, 0, sizeof(oc_ui_box));
+    oc_pool_recycle(&ui->boxPool, box);
+
+    ui->freeBoxCount++;
+}
+
+static void oc_ui_box_pool_compact(oc_ui_context* ui)
+{
+    //NOTE: move live boxes into a fresh pool and release the old one. This must be done between frames,
+    //      when the only persistent references to boxes are the box map, the dense box array and the
+    //      context's box pointers.
+    //      Hierarchy links are rebuilt when the boxes are made during the next frame.
+    oc_pool pool = { 0 };
+    oc_pool_init(&pool, sizeof(oc_ui_box));
+
+    oc_arena stringArena = { 0 };
+    oc_arena_init(&stringArena);
+    ui->boxStringBytes = 0;
+
+    oc_ui_box* focus = 0;
+    oc_ui_box* hovered = 0;
+
+    for(u32 i = 0; i < ui->boxCount; i++)
+    {
+        oc_ui_box* box = ui->boxes[i];
+        oc_ui_box* newBox = oc_pool_alloc_type(&pool, oc_ui_box);
+        memcpy(newBox, box, sizeof(oc_ui_box));
+
+        newBox->listElt = (oc_list_elt){ 0 };
+        newBox->children = (oc_list){ 0 };
+        newBox->parent = 0;
+        newBox->overlayElt = (oc_list_elt){ 0 };
+
+        newBox->string.ptr = oc_arena_push_array(&stringArena, char, box->string.len);
+        memcpy(newBox->string.ptr, box->string.ptr, box->string.len);
+        newBox->stringCap = box->string.len;
+        ui->boxStringBytes += box->string.len;
+
+        ui->boxes[i] = newBox;
+
+        if(ui->focus == box)
+        {
+            focus = newBox;
+        }
+        if(ui->hovered == box)
+        {
+            hovered = newBox;
+        }
+        if(box->hitFrame == ui->hitGrid.frame && box->hitIndex < ui->hitGrid.boxCount)
+        {
+            ui->hitGrid.boxes[box->hitIndex] = newBox;
+        }
+    }
+
+    //NOTE: move the dense array to a fresh table arena, and rebuild the map there, shrinking it if it got
+    //      much larger than needed. This releases the tables that were left behind when they grew.
+    oc_arena tableArena = ui->boxTableArena;
+    oc_arena_init(&ui->boxTableArena);
+
+    ui->boxesCap = oc_max(ui->boxCount, OC_UI_BOX_MAP_MIN_CAP);
+    oc_ui_box** boxes = oc_arena_push_array(&ui->boxTableArena, oc_ui_box*, ui->boxesCap);
+    memcpy(boxes, ui->boxes, ui->boxCount * sizeof(oc_ui_box*));
+    ui->boxes = boxes;
+
+    u32 mapCap = OC_UI_BOX_MAP_MIN_CAP;
+    while(mapCap < ui->boxCount * 2)
+    {
+        mapCap *= 2;
+    }
+    oc_ui_box_map_rebuild(ui, mapCap);
+
+    oc_arena_cleanup(&tableArena);
+
+    oc_pool_cleanup(&ui->boxPool);
+    ui->boxPool = pool;
+
+    oc_arena_cleanup(&ui->boxStringArena);
+    ui->boxStringArena = stringArena;
+    ui->liveBoxStringBytes = ui->boxStringBytes;
+
+    ui->focus = focus;
+    ui->hovered = hovered;
+    ui->root = 0;
+    ui->overlay = 0;
+    ui->freeBoxCount = 0;
+    ui->compactionCount++;
+}
+
+oc_ui_stats oc_ui_get_stats(void)
+{
+    oc_ui_context* ui = oc_ui_get_context();
+
+    oc_ui_stats stats = {
+        .boxCount = ui->boxCount,
+        .freeBoxCount = ui->freeBoxCount,
+        .compactionCount = ui->compactionCount,
+        .reusedLayoutCount = ui->reusedLayoutCount,
+        .styleCount = ui->styleCount,
+        .stylingTime = ui->stylingTime,
+        .layoutTime = ui->layoutTime,
+        .hitTestTime = ui->hitTestTime,
+        .frameArenaBytes = ui->frameArenaBytes,
+    };
+
+    oc_list_for(ui->boxPool.arena.chunks, chunk, oc_arena_chunk, listElt)
+    {
+        stats.poolBytes += chunk->committed;
+    }
+    return (stats);
+}
+
 void oc_ui_begin_frame(oc_vec2 size, oc_ui_style* defaultStyle, oc_ui_style_mask defaultMask)
 {
     oc_ui_context* ui = oc_ui_get_context();
 
+    //NOTE: release box pool memory after large UI teardowns, and box string memory after a lot of string churn
+    u32 poolBoxCount = ui->boxCount + ui->freeBoxCount;
+    if((poolBoxCount >= OC_UI_BOX_POOL_COMPACT_MIN
+        && ui->boxCount * OC_UI_BOX_POOL_COMPACT_RATIO < poolBoxCount)
+       || (ui->boxStringBytes >= OC_UI_BOX_STRING_COMPACT_MIN
+           && ui->liveBoxStringBytes * OC_UI_BOX_POOL_COMPACT_RATIO < ui->boxStringBytes))
+    {
+        oc_ui_box_pool_compact(ui);
+    }
+
     ui->frameCounter++;
+    ui->touchedBoxCount = 0;
     f64 time = oc_clock_time(OC_CLOCK_MONOTONIC);
     ui->lastFrameDuration = time - ui->frameTime;
     ui->frameTime = time;
+    ui->frameRequested = false;
+    ui->frameDeadline = 0;
 
     ui->clipStack = 0;
     ui->z = 0;
@@ -1693,16 +2508,23 @@ void oc_ui_end_frame(void)
     //NOTE: layout
     oc_ui_solve_layout(ui);
 
-    //NOTE: prune unused boxes
-    for(int i = 0; i < OC_UI_BOX_MAP_BUCKET_COUNT; i++)
+    //NOTE: prune unused boxes, which are all past the boxes touched this frame in the dense array
+    while(ui->boxCount > ui->touchedBoxCount)
     {
-        oc_list_for_safe(ui->boxMap[i], box, oc_ui_box, bucketElt)
-        {
-            if(box->frameCounter < ui->frameCounter)
-            {
-                oc_list_remove(&ui->boxMap[i], &box->bucketElt);
-            }
-        }
+        oc_ui_box* stale = ui->boxes[ui->boxCount - 1];
+        OC_DEBUG_ASSERT(stale->frameCounter < ui->frameCounter);
+
+        oc_ui_box_map_remove(ui, stale);
+        ui->boxCount--;
+        oc_ui_box_recycle(ui, stale);
+    }
+
+    oc_ui_style_sweep(ui);
+
+    ui->frameArenaBytes = 0;
+    oc_list_for(ui->frameArena.chunks, chunk, oc_arena_chunk, listElt)
+    {
+        ui->frameArenaBytes += chunk->offset;
     }
 
     oc_arena_clear(&ui->frameArena);
@@ -1719,6 +2541,12 @@ void oc_ui_init(oc_ui_context* ui)
     memset(ui, 0, sizeof(oc_ui_context));
     oc_arena_init(&ui->frameArena);
     oc_pool_init(&ui->boxPool, sizeof(oc_ui_box));
+    oc_arena_init(&ui->boxTableArena);
+    oc_arena_init(&ui->boxStringArena);
+    oc_pool_init(&ui->stylePool, sizeof(oc_ui_style_record));
+    oc_arena_init(&ui->styleTableArena);
+    oc_arena_init(&ui->hitGrid.arena);
+    oc_arena_init(&ui->editCache.arena);
     ui->init = true;
 
     oc_ui_set_context(ui);
@@ -1732,6 +2560,20 @@ void oc_ui_cleanup(void)
     oc_ui_context* ui = oc_ui_get_context();
     oc_arena_cleanup(&ui->frameArena);
     oc_pool_cleanup(&ui->boxPool);
+    oc_arena_cleanup(&ui->boxTableArena);
+    oc_arena_cleanup(&ui->boxStringArena);
+    oc_pool_cleanup(&ui->stylePool);
+    oc_arena_cleanup(&ui->styleTableArena);
+    oc_arena_cleanup(&ui->editCache.arena);
+    oc_arena_cleanup(&ui->hitGrid.arena);
+    ui->boxMap = 0;
+    ui->boxes = 0;
+    ui->hitGrid = (oc_ui_hit_grid){ 0 };
+    ui->styleMap = 0;
+    ui->styles = 0;
+    ui->styleCount = 0;
+    ui->defaultStyle = 0;
+    ui->editCache = (oc_ui_text_box_cache){ 0 };
     ui->init = false;
 }
 
@@ -2386,6 +3228,109 @@ void oc_ui_panel_end(void)
     oc_ui_box_end(); // panel
 }
 
+//------------------------------------------------------------------------------
+// virtualized list
+//------------------------------------------------------------------------------
+
+static oc_str8 oc_ui_list_row_key(oc_arena* arena, u32 index)
+{
+    return (oc_str8_pushf(arena, "row %u", index));
+}
+
+static void oc_ui_list_visible_range(oc_ui_box* panel, oc_ui_list_info* info, f32 rowHeight, u32* first, u32* end)
+{
+    f64 top = floor(panel->scroll.y / rowHeight) - info->overscan;
+    f64 bottom = ceil((panel->scroll.y + panel->rect.h) / rowHeight) + info->overscan;
+
+    *first = (u32)oc_clamp(top, 0., (f64)info->rowCount);
+    *end = (u32)oc_clamp(bottom, (f64)*first, (f64)info->rowCount);
+}
+
+void oc_ui_list(const char* name, oc_ui_list_info* info)
+{
+    oc_ui_panel_begin(name, 0);
+
+    //NOTE: rows are laid out in a column between two spacers standing for the rows that are not built,
+    //      so that the panel's children sum, and hence its scrollbar, covers the whole list
+    oc_ui_box* panel = oc_ui_box_top()->parent;
+
+    oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
+                                     .size.height = { OC_UI_SIZE_CHILDREN },
+                                     .layout.axis = OC_UI_AXIS_Y,
+                                     .layout.spacing = 0 },
+                     OC_UI_STYLE_SIZE
+                         | OC_UI_STYLE_LAYOUT_AXIS
+                         | OC_UI_STYLE_LAYOUT_SPACING);
+
+    oc_ui_box_begin("rows", 0);
+
+    //NOTE: find the rows intersecting the viewport, using last frame's scroll and panel size
+    f32 rowHeight = oc_max(info->rowHeight, 1.f);
+    u32 first = 0;
+    u32 end = 0;
+    oc_ui_list_visible_range(panel, info, rowHeight, &first, &end);
+
+    if(info->estimateHeight)
+    {
+        //NOTE: refine the estimate with the height of the rows that were built last frame
+        oc_arena_scope scratch = oc_scratch_begin();
+        f32 sum = 0;
+        u32 count = 0;
+        for(u32 index = first; index < end; index++)
+        {
+            oc_ui_box* row = oc_ui_box_lookup_str8(oc_ui_list_row_key(scratch.arena, index));
+            if(row && row->rect.h > 0)
+            {
+                sum += row->rect.h;
+                count++;
+            }
+        }
+        oc_scratch_end(scratch);
+
+        if(count)
+        {
+            rowHeight = sum / count;
+            oc_ui_list_visible_range(panel, info, rowHeight, &first, &end);
+        }
+    }
+
+    oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
+                                     .size.height = { OC_UI_SIZE_PIXELS, first * rowHeight } },
+                     OC_UI_STYLE_SIZE);
+    oc_ui_box_make("top spacer", 0);
+
+    for(u32 index = first; index < end; index++)
+    {
+        oc_ui_size height = { OC_UI_SIZE_PIXELS, info->rowHeight };
+        if(info->estimateHeight)
+        {
+            height = (oc_ui_size){ OC_UI_SIZE_CHILDREN };
+        }
+        oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
+                                         .size.height = height,
+                                         .layout.axis = OC_UI_AXIS_Y },
+                         OC_UI_STYLE_SIZE
+                             | OC_UI_STYLE_LAYOUT_AXIS);
+
+        oc_arena_scope scratch = oc_scratch_begin();
+        oc_ui_box_begin_str8(oc_ui_list_row_key(scratch.arena, index), 0);
+        oc_scratch_end(scratch);
+
+        info->proc(index, info->user);
+
+        oc_ui_box_end();
+    }
+
+    oc_ui_style_next(&(oc_ui_style){ .size.width = { OC_UI_SIZE_PARENT, 1 },
+                                     .size.height = { OC_UI_SIZE_PIXELS, (info->rowCount - end) * rowHeight } },
+                     OC_UI_STYLE_SIZE);
+    oc_ui_box_make("bottom spacer", 0);
+
+    oc_ui_box_end(); // rows
+
+    oc_ui_panel_end();
+}
+
 //------------------------------------------------------------------------------
 // tooltips
 //------------------------------------------------------------------------------
@@ -3726,94 +4671,235 @@ i32 oc_ui_edit_find_word_end(oc_ui_context* ui, oc_str32 codepoints, i32 startCh
     return c;
 }
 
-void oc_ui_text_box_render(oc_ui_box* box, void* data)
+static f32 oc_ui_text_box_codepoint_width(oc_font font, f32 fontSize, oc_utf32 codepoint)
 {
-    oc_str32 codepoints = *(oc_str32*)data;
-    oc_ui_context* ui = oc_ui_get_context();
+    return (oc_font_text_metrics_utf32(font, fontSize, oc_str32_from_buffer(1, &codepoint)).advance.x);
+}
+
+static void oc_ui_text_box_cache_update(oc_ui_context* ui, oc_str32 codepoints)
+{
+    //NOTE: only re-measure the codepoints between the common prefix and suffix of the old and new text
+    oc_ui_text_box_cache* cache = &ui->editCache;
+    if(codepoints.ptr == cache->codepoints && codepoints.len == cache->len)
+    {
+        return;
+    }
+
+    u32 oldLen = cache->len;
+    u32 newLen = codepoints.len;
+    u32 commonLen = oc_min(oldLen, newLen);
 
-    u32 firstDisplayedChar = 0;
-    if(oc_ui_box_active(box))
+    u32 prefix = 0;
+    while(prefix < commonLen && cache->codepoints[prefix] == codepoints.ptr[prefix])
     {
-        firstDisplayedChar = ui->editFirstDisplayedChar;
+        prefix++;
     }
+    u32 suffix = 0;
+    while(suffix < commonLen - prefix && cache->codepoints[oldLen - 1 - suffix] == codepoints.ptr[newLen - 1 - suffix])
+    {
+        suffix++;
+    }
+    if(prefix == oldLen && oldLen == newLen)
+    {
+        return;
+    }
+
+    if(newLen + 1 > cache->cap)
+    {
+        //NOTE: the previous arrays are left in the arena until another text box is cached
+        cache->cap = oc_max(newLen + 1, cache->cap * 2);
+
+        oc_utf32* newCodepoints = oc_arena_push_array(&cache->arena, oc_utf32, cache->cap);
+        f32* newAdvances = oc_arena_push_array(&cache->arena, f32, cache->cap);
+        memcpy(newCodepoints, cache->codepoints, oldLen * sizeof(oc_utf32));
+        memcpy(newAdvances, cache->advances, (oldLen + 1) * sizeof(f32));
+
+        cache->codepoints = newCodepoints;
+        cache->advances = newAdvances;
+    }
+
+    u32 oldEnd = oldLen - suffix;
+    u32 newEnd = newLen - suffix;
+    f32 base = cache->advances[prefix];
+    f32 oldSuffixBase = cache->advances[oldEnd];
+
+    memmove(cache->codepoints + newEnd, cache->codepoints + oldEnd, suffix * sizeof(oc_utf32));
+    memmove(cache->advances + newEnd, cache->advances + oldEnd, (suffix + 1) * sizeof(f32));
+    memcpy(cache->codepoints + prefix, codepoints.ptr + prefix, (newEnd - prefix) * sizeof(oc_utf32));
+
+    f32 x = base;
+    for(u32 i = prefix; i < newEnd; i++)
+    {
+        x += oc_ui_text_box_codepoint_width(cache->font, cache->fontSize, cache->codepoints[i]);
+        cache->advances[i + 1] = x;
+    }
+    cache->advances[newEnd] = x;
+
+    f32 delta = x - oldSuffixBase;
+    for(u32 i = newEnd + 1; i <= newLen; i++)
+    {
+        cache->advances[i] += delta;
+    }
+    cache->len = newLen;
+}
+
+static oc_str32 oc_ui_text_box_cache_text(oc_ui_context* ui, oc_ui_key key, oc_font font, f32 fontSize, oc_str8 text)
+{
+    oc_ui_text_box_cache* cache = &ui->editCache;
+
+    if(cache->key.hash != key.hash
+       || cache->font.h != font.h
+       || cache->fontSize != fontSize
+       || !cache->advances)
+    {
+        cache->key = key;
+        cache->font = font;
+        cache->fontSize = fontSize;
+        cache->textHash = 0;
+        cache->len = 0;
+
+        oc_arena_clear(&cache->arena);
+        cache->cap = 64;
+        cache->codepoints = oc_arena_push_array(&cache->arena, oc_utf32, cache->cap);
+        cache->advances = oc_arena_push_array(&cache->arena, f32, cache->cap);
+        cache->advances[0] = 0;
+    }
+
+    //NOTE: skip decoding the text if it didn't change since the last update
+    u64 textHash = oc_hash_xx64_string(text);
+    if(textHash != cache->textHash)
+    {
+        oc_str32 codepoints = oc_utf8_push_to_codepoints(&ui->frameArena, text);
+        oc_ui_text_box_cache_update(ui, codepoints);
+        cache->textHash = textHash;
+    }
+    return (oc_str32_from_buffer(cache->len, cache->codepoints));
+}
+
+static u32 oc_ui_text_box_cache_lower_bound(oc_ui_text_box_cache* cache, u32 first, f32 x)
+{
+    //NOTE: first index in [first, len] such that advances[index] >= x
+    u32 lo = first;
+    u32 hi = cache->len + 1;
+    while(lo < hi)
+    {
+        u32 mid = lo + (hi - lo) / 2;
+        if(cache->advances[mid] < x)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return (oc_min(lo, cache->len));
+}
+
+static u32 oc_ui_text_box_cache_hit(oc_ui_text_box_cache* cache, u32 first, f32 x)
+{
+    //NOTE: first index in [first, len) whose codepoint's midpoint is past x, or len if there's none
+    u32 lo = first;
+    u32 hi = cache->len;
+    while(lo < hi)
+    {
+        u32 mid = lo + (hi - lo) / 2;
+        if(0.5 * (cache->advances[mid] + cache->advances[mid + 1]) > x)
+        {
+            hi = mid;
+        }
+        else
+        {
+            lo = mid + 1;
+        }
+    }
+    return (lo);
+}
+
+typedef struct oc_ui_text_box_render_data
+{
+    oc_str32 codepoints;
+    u32 firstChar;
+    u32 endChar;
+    f32 firstX;
+    f32 selectStartX;
+    f32 selectEndX;
+} oc_ui_text_box_render_data;
+
+void oc_ui_text_box_render(oc_ui_box* box, void* data)
+{
+    oc_ui_text_box_render_data* renderData = (oc_ui_text_box_render_data*)data;
+    oc_str32 codepoints = renderData->codepoints;
+    oc_ui_context* ui = oc_ui_get_context();
 
     oc_ui_style* style = &box->style;
     oc_font_metrics extents = oc_font_get_metrics(style->font, style->fontSize);
     f32 lineHeight = extents.ascent + extents.descent;
 
-    oc_str32 before = oc_str32_slice(codepoints, 0, firstDisplayedChar);
-    oc_rect beforeBox = oc_font_text_metrics_utf32(style->font, style->fontSize, before).logical;
+    //NOTE: only the visible window of the text is drawn, starting at the left of the box
+    u32 firstChar = renderData->firstChar;
+    u32 endChar = renderData->endChar;
 
-    f32 textX = box->rect.x - beforeBox.w;
+    f32 textX = box->rect.x;
     f32 textTop = box->rect.y + 0.5 * (box->rect.h - lineHeight);
     f32 textY = textTop + extents.ascent;
 
+    oc_set_font(style->font);
+    oc_set_font_size(style->fontSize);
+
     if(box->active)
     {
-        u32 selectStart = oc_min(ui->editCursor, ui->editMark);
-        u32 selectEnd = oc_max(ui->editCursor, ui->editMark);
+        u32 selectStart = oc_clamp(oc_min(ui->editCursor, ui->editMark), firstChar, endChar);
+        u32 selectEnd = oc_clamp(oc_max(ui->editCursor, ui->editMark), firstChar, endChar);
 
-        oc_str32 beforeSelect = oc_str32_slice(codepoints, 0, selectStart);
-        oc_rect beforeSelectBox = oc_font_text_metrics_utf32(style->font, style->fontSize, beforeSelect).logical;
-        beforeSelectBox.x += textX;
-        beforeSelectBox.y += textY;
+        oc_str32 beforeSelect = oc_str32_slice(codepoints, firstChar, selectStart);
+        oc_str32 select = oc_str32_slice(codepoints, selectStart, selectEnd);
+        oc_str32 afterSelect = oc_str32_slice(codepoints, selectEnd, endChar);
 
-        if(selectStart != selectEnd)
+        if(ui->editCursor != ui->editMark)
         {
-            oc_str32 select = oc_str32_slice(codepoints, selectStart, selectEnd);
-            oc_str32 afterSelect = oc_str32_slice(codepoints, selectEnd, codepoints.len);
-            oc_rect selectBox = oc_font_text_metrics_utf32(style->font, style->fontSize, select).logical;
-            oc_rect afterSelectBox = oc_font_text_metrics_utf32(style->font, style->fontSize, afterSelect).logical;
-
-            selectBox.x += beforeSelectBox.x + beforeSelectBox.w;
-            selectBox.y += textY;
-
             oc_set_color(ui->theme->palette->blue2);
-            oc_rectangle_fill(selectBox.x, selectBox.y, selectBox.w, lineHeight);
+            oc_rectangle_fill(textX + renderData->selectStartX - renderData->firstX,
+                              textTop,
+                              renderData->selectEndX - renderData->selectStartX,
+                              lineHeight);
 
-            oc_set_font(style->font);
-            oc_set_font_size(style->fontSize);
             oc_set_color(style->color);
 
             oc_move_to(textX, textY);
-            oc_codepoints_outlines(beforeSelect);
-            oc_fill();
+            oc_codepoints_fill(beforeSelect);
 
             oc_set_color(box->style.color);
-            oc_codepoints_outlines(select);
-            oc_fill();
+            oc_codepoints_fill(select);
 
             oc_set_color(style->color);
-            oc_codepoints_outlines(afterSelect);
-            oc_fill();
+            oc_codepoints_fill(afterSelect);
         }
         else
         {
-            if(!((u64)(2 * (ui->frameTime - ui->editCursorBlinkStart)) & 1))
+            //NOTE: the caret only needs a new frame when it blinks
+            f64 blinkPhase = 2 * (ui->frameTime - ui->editCursorBlinkStart);
+            oc_ui_request_frame_at(ui, ui->editCursorBlinkStart + (floor(blinkPhase) + 1) / 2);
+
+            if(!((u64)blinkPhase & 1))
             {
-                f32 caretX = box->rect.x - beforeBox.w + beforeSelectBox.w;
+                f32 caretX = textX + renderData->selectStartX - renderData->firstX;
                 f32 caretY = textTop;
                 oc_set_color(style->color);
                 oc_rectangle_fill(caretX, caretY, 1, lineHeight);
             }
-            oc_set_font(style->font);
-            oc_set_font_size(style->fontSize);
             oc_set_color(style->color);
 
             oc_move_to(textX, textY);
-            oc_codepoints_outlines(codepoints);
-            oc_fill();
+            oc_codepoints_fill(oc_str32_slice(codepoints, firstChar, endChar));
         }
     }
     else
     {
-        oc_set_font(style->font);
-        oc_set_font_size(style->fontSize);
         oc_set_color(style->color);
 
         oc_move_to(textX, textY);
-        oc_codepoints_outlines(codepoints);
-        oc_fill();
+        oc_codepoints_fill(oc_str32_slice(codepoints, firstChar, endChar));
     }
 }
 
@@ -3891,27 +4977,20 @@ oc_ui_text_box_result oc_ui_text_box(const char* name, oc_arena* arena, oc_str8
         oc_vec2 pos = oc_ui_mouse_position();
         f32 cursorX = pos.x - textBox->rect.x;
 
-        oc_str32 codepoints = oc_utf8_push_to_codepoints(&ui->frameArena, text);
-        i32 newCursor = 0;
-        i32 hoveredChar = 0;
-        f32 x = 0;
-        for(int i = ui->editFirstDisplayedChar; i < codepoints.len; i++)
+        oc_str32 codepoints = oc_ui_text_box_cache_text(ui, frame->key, font, fontSize, text);
+        oc_ui_text_box_cache* cache = &ui->editCache;
+
+        u32 firstChar = oc_min((u32)ui->editFirstDisplayedChar, cache->len);
+        f32 targetX = cache->advances[firstChar] + cursorX;
+
+        //NOTE: the cursor goes before the first codepoint whose midpoint is past the mouse, and the
+        //      hovered codepoint is the last one starting before the mouse
+        i32 newCursor = oc_ui_text_box_cache_hit(cache, firstChar, targetX);
+        i32 hoveredChar = (i32)oc_ui_text_box_cache_lower_bound(cache, firstChar, targetX) - 1;
+        hoveredChar = oc_min(hoveredChar, oc_min(newCursor, (i32)cache->len - 1));
+        if(hoveredChar < (i32)firstChar)
         {
-            oc_rect bbox = oc_font_text_metrics_utf32(font, fontSize, oc_str32_slice(codepoints, i, i + 1)).logical;
-            if(x < cursorX)
-            {
-                hoveredChar = i;
-            }
-            if(x + 0.5 * bbox.w > cursorX)
-            {
-                newCursor = i;
-                break;
-            }
-            if(i == codepoints.len - 1)
-            {
-                newCursor = codepoints.len;
-            }
-            x += bbox.w;
+            hoveredChar = 0;
         }
 
         if(sig.doubleClicked)
@@ -3953,8 +5032,8 @@ oc_ui_text_box_result oc_ui_text_box(const char* name, oc_arena* arena, oc_str8
         }
         else if(ui->editSelectionMode == OC_UI_EDIT_MOVE_LINE)
         {
-            oc_rect bbox = oc_font_text_metrics_utf32(font, fontSize, codepoints).logical;
-            if(fabsf(bbox.w - cursorX) < fabsf(cursorX))
+            f32 width = cache->advances[cache->len];
+            if(fabsf(width - cursorX) < fabsf(cursorX))
             {
                 ui->editCursor = codepoints.len;
                 ui->editMark = 0;
@@ -3970,10 +5049,8 @@ oc_ui_text_box_result oc_ui_text_box(const char* name, oc_arena* arena, oc_str8
             if(oc_min(ui->editCursor, ui->editMark) == oc_min(ui->editWordSelectionInitialCursor, ui->editWordSelectionInitialMark)
                && oc_max(ui->editCursor, ui->editMark) == oc_max(ui->editWordSelectionInitialCursor, ui->editWordSelectionInitialMark))
             {
-                oc_rect editCursorPrefixBbox = oc_font_text_metrics_utf32(font, fontSize, oc_str32_slice(codepoints, 0, ui->editCursor)).logical;
-                oc_rect editMarkPrefixBbox = oc_font_text_metrics_utf32(font, fontSize, oc_str32_slice(codepoints, 0, ui->editMark)).logical;
-                f32 editCursorX = editCursorPrefixBbox.w;
-                f32 editMarkX = editMarkPrefixBbox.w;
+                f32 editCursorX = cache->advances[oc_clamp(ui->editCursor, 0, (i32)cache->len)];
+                f32 editMarkX = cache->advances[oc_clamp(ui->editMark, 0, (i32)cache->len)];
                 if(fabsf(cursorX - editMarkX) < fabsf(cursorX - editCursorX))
                 {
                     i32 tmp = ui->editMark;
@@ -4028,7 +5105,7 @@ oc_ui_text_box_result oc_ui_text_box(const char* name, oc_arena* arena, oc_str8
 
     if(oc_ui_box_active(frame))
     {
-        oc_str32 oldCodepoints = oc_utf8_push_to_codepoints(&ui->frameArena, text);
+        oc_str32 oldCodepoints = oc_ui_text_box_cache_text(ui, frame->key, font, fontSize, text);
         oc_str32 codepoints = oldCodepoints;
         ui->editCursor = oc_clamp(ui->editCursor, 0, codepoints.len);
         ui->editMark = oc_clamp(ui->editMark, 0, codepoints.len);
@@ -4080,10 +5157,14 @@ oc_ui_text_box_result oc_ui_text_box(const char* name, oc_arena* arena, oc_str8
         }
 
         //NOTE(martin): check changed/accepted
+        oc_ui_text_box_cache* cache = &ui->editCache;
         if(oldCodepoints.ptr != codepoints.ptr)
         {
             result.changed = true;
             result.text = oc_utf8_push_from_codepoints(arena, codepoints);
+
+            oc_ui_text_box_cache_update(ui, codepoints);
+            cache->textHash = oc_hash_xx64_string(result.text);
         }
 
         if(oc_key_press_count(&ui->input, OC_KEY_ENTER))
@@ -4103,32 +5184,38 @@ oc_ui_text_box_result oc_ui_text_box(const char* name, oc_arena* arena, oc_str8
             }
             else
             {
-                i32 firstDisplayedChar = ui->editFirstDisplayedChar;
-                oc_str32 firstToCursor = oc_str32_slice(codepoints, firstDisplayedChar, ui->editCursor);
-                oc_rect firstToCursorBox = oc_font_text_metrics_utf32(font, fontSize, firstToCursor).logical;
-
-                while(firstToCursorBox.w > textBox->rect.w)
-                {
-                    firstDisplayedChar++;
-                    firstToCursor = oc_str32_slice(codepoints, firstDisplayedChar, ui->editCursor);
-                    firstToCursorBox = oc_font_text_metrics_utf32(font, fontSize, firstToCursor).logical;
-                }
-
-                ui->editFirstDisplayedChar = firstDisplayedChar;
+                //NOTE: first displayed char is the first one such that the text up to the cursor fits in the box
+                f32 cursorX = cache->advances[ui->editCursor];
+                ui->editFirstDisplayedChar = oc_ui_text_box_cache_lower_bound(cache,
+                                                                             ui->editFirstDisplayedChar,
+                                                                             cursorX - textBox->rect.w);
             }
         }
 
         //NOTE: set renderer
-        oc_str32* renderCodepoints = oc_arena_push_type(&ui->frameArena, oc_str32);
-        *renderCodepoints = oc_str32_push_copy(&ui->frameArena, codepoints);
-        oc_ui_box_set_draw_proc(textBox, oc_ui_text_box_render, renderCodepoints);
+        oc_ui_text_box_render_data* renderData = oc_arena_push_type(&ui->frameArena, oc_ui_text_box_render_data);
+        renderData->codepoints = oc_str32_push_copy(&ui->frameArena, codepoints);
+        renderData->firstChar = ui->editFirstDisplayedChar;
+        renderData->endChar = cache->len;
+        if(textBox->rect.w > 0)
+        {
+            renderData->endChar = oc_ui_text_box_cache_lower_bound(cache,
+                                                                   renderData->firstChar,
+                                                                   cache->advances[renderData->firstChar] + textBox->rect.w);
+        }
+        renderData->firstX = cache->advances[renderData->firstChar];
+        renderData->selectStartX = cache->advances[oc_min(ui->editCursor, ui->editMark)];
+        renderData->selectEndX = cache->advances[oc_max(ui->editCursor, ui->editMark)];
+        oc_ui_box_set_draw_proc(textBox, oc_ui_text_box_render, renderData);
     }
     else
     {
         //NOTE: set renderer
-        oc_str32* renderCodepoints = oc_arena_push_type(&ui->frameArena, oc_str32);
-        *renderCodepoints = oc_utf8_push_to_codepoints(&ui->frameArena, text);
-        oc_ui_box_set_draw_proc(textBox, oc_ui_text_box_render, renderCodepoints);
+        oc_ui_text_box_render_data* renderData = oc_arena_push_type(&ui->frameArena, oc_ui_text_box_render_data);
+        memset(renderData, 0, sizeof(oc_ui_text_box_render_data));
+        renderData->codepoints = oc_utf8_push_to_codepoints(&ui->frameArena, text);
+        renderData->endChar = renderData->codepoints.len;
+        oc_ui_box_set_draw_proc(textBox, oc_ui_text_box_render, renderData);
     }
 
     oc_ui_box_end(); // frame
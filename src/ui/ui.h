@@ -424,6 +424,8 @@ typedef struct oc_ui_selector
         oc_ui_status status;
         //...
     };
+
+    u64 textHash; // hash of text, computed when the selector is pushed to a pattern
 } oc_ui_selector;
 
 typedef struct oc_ui_pattern
@@ -443,6 +445,10 @@ typedef struct oc_ui_style_rule
     oc_ui_pattern pattern;
     oc_ui_style_mask mask;
     oc_ui_style* style;
+
+    // rule index state, used during styling
+    oc_list* bucket;
+    i64 order;
 } oc_ui_style_rule;
 
 typedef struct oc_ui_sig
@@ -502,13 +508,14 @@ struct oc_ui_box
     oc_list_elt overlayElt;
 
     // keying and caching
-    oc_list_elt bucketElt;
     oc_ui_key key;
     u64 frameCounter;
+    u32 denseIndex;
 
     // builder-provided info
     oc_ui_flags flags;
     oc_str8 string;
+    u64 stringCap;
     oc_list tags;
 
     oc_ui_box_draw_proc drawProc;
@@ -529,6 +536,26 @@ struct oc_ui_box
     f32 minSize[2];
     oc_rect rect;
 
+    // layout caching
+    u64 layoutHash;
+    bool layoutReuse;
+    bool layoutAnimating;
+    u64 textHash;
+    oc_vec2 textSize;
+    f32 staticSize[2];
+    f32 downwardMinSize[2];
+    f32 downwardSize[2];
+    f32 upwardMinSize[2];
+    f32 upwardSize[2];
+    oc_vec2 layoutPos;
+    u32 layoutZ;
+    u32 layoutZCount;
+
+    // hit testing
+    oc_rect hitRect;
+    u64 hitFrame;
+    u32 hitIndex;
+
     // signals
     oc_ui_sig* sig;
 
@@ -585,9 +612,79 @@ typedef struct oc_ui_tag_elt
 
 enum
 {
-    OC_UI_BOX_MAP_BUCKET_COUNT = 1024
+    OC_UI_BOX_MAP_MIN_CAP = 1024,
+
+    //NOTE: the box pool is compacted when it holds at least OC_UI_BOX_POOL_COMPACT_MIN boxes and
+    //      fewer than 1/OC_UI_BOX_POOL_COMPACT_RATIO of them are alive
+    OC_UI_BOX_POOL_COMPACT_MIN = 1024,
+    OC_UI_BOX_POOL_COMPACT_RATIO = 4,
+
+    //NOTE: the box pool is also compacted when the box string arena holds at least OC_UI_BOX_STRING_COMPACT_MIN
+    //      bytes and fewer than 1/OC_UI_BOX_POOL_COMPACT_RATIO of them are used by live boxes
+    OC_UI_BOX_STRING_COMPACT_MIN = 64 << 10,
+
+    OC_UI_HIT_GRID_DIM = 32,
+
+    OC_UI_STYLE_MAP_MIN_CAP = 256,
 };
 
+//NOTE: interned target style. Boxes whose resolved styles are identical share the same record,
+//      and records that weren't used during a frame are released at the end of that frame.
+typedef struct oc_ui_style_record
+{
+    u64 hash;
+    u64 frame;
+    oc_ui_style style;
+} oc_ui_style_record;
+
+typedef struct oc_ui_style_map_entry
+{
+    u64 hash;
+    oc_ui_style_record* record;
+} oc_ui_style_map_entry;
+
+//NOTE: codepoints and cumulative advances of the text box being edited. advances[i] is the width of
+//      the first i codepoints, so that widths of slices, hit testing and scrolling don't need to
+//      measure text again. Both arrays are allocated from the cache's arena, which is cleared when
+//      another text box is cached.
+typedef struct oc_ui_text_box_cache
+{
+    oc_ui_key key;
+    oc_font font;
+    f32 fontSize;
+    u64 textHash;
+
+    oc_arena arena;
+    u32 len;
+    u32 cap;
+    oc_utf32* codepoints;
+    f32* advances;
+} oc_ui_text_box_cache;
+
+//NOTE: uniform grid of the mouse-blocking boxes laid out during the last frame, used for hover queries.
+//      Boxes are stored in increasing z order, and each cell lists the indices of the boxes whose
+//      clipped rect overlaps it, between cellStart[cell] and cellStart[cell+1].
+typedef struct oc_ui_hit_grid
+{
+    u64 frame;
+    oc_rect bounds;
+    oc_vec2 cellSize;
+
+    oc_arena arena; // boxes and items, cleared when the grid is rebuilt
+    u32 boxCount;
+    u32 boxCap;
+    oc_ui_box** boxes;
+
+    u32* items;
+    u32 cellStart[OC_UI_HIT_GRID_DIM * OC_UI_HIT_GRID_DIM + 1];
+} oc_ui_hit_grid;
+
+typedef struct oc_ui_box_map_entry
+{
+    u64 hash;
+    oc_ui_box* box;
+} oc_ui_box_map_entry;
+
 typedef enum
 {
     OC_UI_EDIT_MOVE_NONE = 0,
@@ -605,10 +702,47 @@ typedef struct oc_ui_context
     u64 frameCounter;
     f64 frameTime;
     f64 lastFrameDuration;
+    bool frameRequested;
+    f64 frameDeadline; // time at which the UI needs a new frame even if no event comes in, or 0
 
     oc_arena frameArena;
     oc_pool boxPool;
-    oc_list boxMap[OC_UI_BOX_MAP_BUCKET_COUNT];
+
+    //NOTE: open addressing map from key hash to box, and dense array of live boxes.
+    //      Boxes made during the current frame are moved to the front of the dense array,
+    //      so that stale boxes are the ones past touchedBoxCount at the end of the frame.
+    //      Both are allocated from boxTableArena, which is replaced when the box pool is compacted.
+    oc_arena boxTableArena;
+    oc_ui_box_map_entry* boxMap;
+    u32 boxMapCap;
+    oc_ui_box** boxes;
+    u32 boxesCap;
+    u32 touchedBoxCount;
+    u32 boxCount;
+
+    //NOTE: box strings are kept across frames in boxStringArena. Strings left behind when they grow or when
+    //      their box is recycled are released when the box pool is compacted.
+    oc_arena boxStringArena;
+    u64 boxStringBytes;     // bytes pushed to the string arena since the last compaction
+    u64 liveBoxStringBytes; // capacity of the strings of live boxes
+
+    u32 freeBoxCount;
+    u32 compactionCount;
+    u32 reusedLayoutCount;
+    f64 stylingTime;
+    f64 layoutTime;
+    f64 hitTestTime;
+    u64 frameArenaBytes;
+
+    oc_pool stylePool;
+    oc_arena styleTableArena; // style map and records array, which are only replaced when they grow
+    oc_ui_style_map_entry* styleMap;
+    u32 styleMapCap;
+    oc_ui_style_record** styles;
+    u32 stylesCap;
+    u32 styleCount;
+    oc_ui_style_record* defaultStyle;
+    oc_ui_theme* defaultStyleTheme;
 
     oc_ui_box* root;
     oc_ui_box* overlay;
@@ -622,6 +756,7 @@ typedef struct oc_ui_context
 
     u32 z;
     oc_ui_box* hovered;
+    oc_ui_hit_grid hitGrid;
 
     oc_ui_box* focus;
     i32 editCursor;
@@ -631,16 +766,32 @@ typedef struct oc_ui_context
     oc_ui_edit_move editSelectionMode;
     i32 editWordSelectionInitialCursor;
     i32 editWordSelectionInitialMark;
+    oc_ui_text_box_cache editCache;
 
     bool clipboardRegistered;
 
     oc_ui_theme* theme;
 } oc_ui_context;
 
+typedef struct oc_ui_stats
+{
+    u32 boxCount;          // number of live boxes in the box map
+    u32 freeBoxCount;      // number of recycled boxes waiting in the box pool
+    u64 poolBytes;         // memory committed by the box pool
+    u32 compactionCount;   // number of times the box pool was compacted
+    u32 reusedLayoutCount; // number of unchanged subtrees whose layout was reused during the last frame
+    u32 styleCount;        // number of distinct interned target styles
+    f64 stylingTime;       // time spent in the styling prepass during the last frame, in seconds
+    f64 layoutTime;        // time spent computing the layout during the last frame, in seconds
+    f64 hitTestTime;       // time spent indexing boxes and resolving hover during the last frame, in seconds
+    u64 frameArenaBytes;   // bytes allocated from the frame arena during the last frame
+} oc_ui_stats;
+
 //-------------------------------------------------------------------------------------
 // UI context initialization and frame cycle
 //-------------------------------------------------------------------------------------
 ORCA_API void oc_ui_init(oc_ui_context* context);
+ORCA_API void oc_ui_cleanup(void);
 ORCA_API oc_ui_context* oc_ui_get_context(void);
 ORCA_API void oc_ui_set_context(oc_ui_context* context);
 
@@ -649,6 +800,7 @@ ORCA_API void oc_ui_begin_frame(oc_vec2 size, oc_ui_style* defaultStyle, oc_ui_s
 ORCA_API void oc_ui_end_frame(void);
 ORCA_API void oc_ui_draw(void);
 ORCA_API void oc_ui_set_theme(oc_ui_theme* theme);
+ORCA_API oc_ui_stats oc_ui_get_stats(void);
 
 #define oc_ui_frame(size, style, mask) oc_defer_loop(oc_ui_begin_frame((size), (style), (mask)), oc_ui_end_frame())
 
@@ -677,6 +829,7 @@ ORCA_API oc_ui_box* oc_ui_box_top(void);
 
 ORCA_API oc_ui_box* oc_ui_box_lookup_key(oc_ui_key key);
 ORCA_API oc_ui_box* oc_ui_box_lookup_str8(oc_str8 string);
+ORCA_API oc_ui_box* oc_ui_hit_test(oc_vec2 p);
 
 ORCA_API void oc_ui_box_set_draw_proc(oc_ui_box* box, oc_ui_box_draw_proc proc, void* data);
 
@@ -755,6 +908,20 @@ ORCA_API void oc_ui_panel_begin(const char* name, oc_ui_flags flags);
 ORCA_API void oc_ui_panel_end(void);
 #define oc_ui_panel(s, f) oc_defer_loop(oc_ui_panel_begin(s, f), oc_ui_panel_end())
 
+typedef void (*oc_ui_list_row_proc)(u32 index, void* user);
+
+typedef struct oc_ui_list_info
+{
+    u32 rowCount;        // total number of rows
+    f32 rowHeight;       // height of each row, or estimated height if estimateHeight is set
+    bool estimateHeight; // rows are sized by their contents, and rowHeight is refined from the rows built last frame
+    u32 overscan;        // number of rows built before and after the visible ones
+    oc_ui_list_row_proc proc;
+    void* user;
+} oc_ui_list_info;
+
+ORCA_API void oc_ui_list(const char* name, oc_ui_list_info* info);
+
 ORCA_API void oc_ui_menu_bar_begin(const char* label);
 ORCA_API void oc_ui_menu_bar_end(void);
 #define oc_ui_menu_bar(name) oc_defer_loop(oc_ui_menu_bar_begin(name), oc_ui_menu_bar_end())
@@ -0,0 +1,16 @@
+#!/bin/bash
+
+BINDIR=bin
+LIBDIR=../../build/bin
+SRCDIR=../../src
+
+INCLUDES="-I$SRCDIR -I$SRCDIR/util -I$SRCDIR/platform -I$SRCDIR/app"
+LIBS="-L$LIBDIR -lorca"
+FLAGS="-mmacos-version-min=10.15.4 -DOC_DEBUG -DLOG_COMPILE_DEBUG"
+
+mkdir -p $BINDIR
+clang -g $FLAGS $LIBS $INCLUDES -o $BINDIR/test_glyph_ranges main.c
+
+cp $LIBDIR/liborca.dylib $BINDIR/
+
+install_name_tool -add_rpath "@executable_path" $BINDIR/test_glyph_ranges
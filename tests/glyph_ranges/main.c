@@ -0,0 +1,106 @@
+/*************************************************************************
+*
+*  Orca
+*  Copyright 2023 Martin Fouilleul and the Orca project contributors
+*  See LICENSE.txt for licensing information
+*
+**************************************************************************/
+#include <stdio.h>
+
+#include "orca.h"
+
+//NOTE: checks glyph index lookup when the requested unicode ranges are nested or overlap. Glyph indices
+//      are assigned to the ranges in the requested order, and a codepoint maps to the first range that
+//      contains it.
+
+typedef struct glyph_check
+{
+    oc_utf32 codePoint;
+    u32 glyphIndex;
+} glyph_check;
+
+int main()
+{
+    oc_init();
+
+    oc_unicode_range ranges[] = {
+        { .firstCodePoint = 0x20, .count = 96 },  // glyphs 1 to 96
+        { .firstCodePoint = 0x41, .count = 26 },  // glyphs 97 to 122, nested in the first range
+        { .firstCodePoint = 0x100, .count = 16 }, // glyphs 123 to 138
+        { .firstCodePoint = 0x0, .count = 512 },  // glyphs 139 to 650, contains all the previous ranges
+        { .firstCodePoint = 0x300, .count = 16 }, // glyphs 651 to 666
+    };
+
+    glyph_check checks[] = {
+        { 0x20, 1 },
+        { 0x41, 34 },    // first range, which hides the second one
+        { 0x7f, 96 },
+        { 0x10, 155 },   // fourth range, before the first one
+        { 0x80, 267 },   // fourth range, between the first and third ones
+        { 0xff, 394 },
+        { 0x100, 123 },  // third range
+        { 0x105, 128 },
+        { 0x110, 411 },  // fourth range, after the third one
+        { 0x150, 475 },
+        { 0x1ff, 650 },
+        { 0x305, 656 },  // fifth range
+        { 0x200, 0 },    // not in any range
+        { 0x400, 0 },
+    };
+
+    oc_arena_scope scratch = oc_scratch_begin();
+    oc_str8 fontPath = oc_path_executable_relative(scratch.arena, OC_STR8("../../../resources/Menlo.ttf"));
+
+    oc_font font = oc_font_create_from_path(fontPath, oc_array_size(ranges), ranges);
+    if(oc_font_is_nil(font))
+    {
+        oc_log_error("couldn't create font\n");
+        oc_scratch_end(scratch);
+        return (-1);
+    }
+
+    int result = 0;
+    for(int i = 0; i < oc_array_size(checks); i++)
+    {
+        u32 glyphIndex = oc_font_get_glyph_index(font, checks[i].codePoint);
+        if(glyphIndex != checks[i].glyphIndex)
+        {
+            oc_log_error("codepoint 0x%x: expected glyph index %u, got %u\n",
+                         checks[i].codePoint,
+                         checks[i].glyphIndex,
+                         glyphIndex);
+            result = -1;
+        }
+    }
+
+    //NOTE: check the batch lookup too, in reverse order so that it doesn't just hit the last range
+    u32 count = oc_array_size(checks);
+    oc_str32 codePoints = { .ptr = oc_arena_push_array(scratch.arena, oc_utf32, count), .len = count };
+    oc_str32 backing = { .ptr = oc_arena_push_array(scratch.arena, oc_utf32, count), .len = count };
+    for(int i = 0; i < count; i++)
+    {
+        codePoints.ptr[i] = checks[count - 1 - i].codePoint;
+    }
+    oc_str32 indices = oc_font_get_glyph_indices(font, codePoints, backing);
+    for(int i = 0; i < count; i++)
+    {
+        glyph_check* check = &checks[count - 1 - i];
+        if(indices.ptr[i] != check->glyphIndex)
+        {
+            oc_log_error("codepoint 0x%x: expected glyph index %u in batch lookup, got %u\n",
+                         check->codePoint,
+                         check->glyphIndex,
+                         indices.ptr[i]);
+            result = -1;
+        }
+    }
+
+    oc_font_destroy(font);
+    oc_scratch_end(scratch);
+
+    if(result == 0)
+    {
+        oc_log_info("glyph ranges: ok\n");
+    }
+    return (result);
+}